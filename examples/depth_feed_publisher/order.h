@@ -5,15 +5,15 @@
 
 namespace liquibook { namespace examples {
 
-class Order : public book::Order {
+class Order final : public book::Order {
 public:
   Order(bool buy,
         const double& price,          
         book::Quantity qty);
 
-  virtual bool is_buy() const;
-  virtual book::Quantity order_qty() const;
-  virtual book::Price price() const;
+  bool is_buy() const;
+  book::Quantity order_qty() const;
+  book::Price price() const;
 
   static const uint8_t precision_;
 private:
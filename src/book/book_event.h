@@ -0,0 +1,53 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include "types.h"
+
+#include <cstdint>
+#include <utility>
+
+namespace liquibook { namespace book {
+
+/// @brief a change to the orders resting in an OrderBook, for a market by
+///        order (L3) feed.
+///
+/// Applying a book's events in sequence order to an empty mirror keyed by
+/// order gives the orders in its bids() and asks(), each at its price,
+/// with its open quantity, in time priority.  Stop orders are not resting,
+/// so they appear only once they are triggered and rest.
+///
+///   be_add      the order rests at price with open_qty
+///   be_modify   a replace left the order resting at price with open_qty,
+///               behind the other orders at that price
+///   be_execute  quantity of the order traded at price, leaving open_qty.
+///               With no open quantity left the order has left the book;
+///               no delete follows.
+///   be_delete   the order left the book without trading: it was
+///               cancelled, or replaced and did not rest again.
+///               quantity is the open quantity it had
+///
+/// The order is named by its handle, as in a Callback.
+template <typename OrderPtr>
+struct BookEvent {
+  /// @brief how an event refers to an order
+  typedef decltype(&*std::declval<const OrderPtr &>()) OrderHandle;
+
+  enum EventType {
+    be_add,
+    be_modify,
+    be_execute,
+    be_delete
+  };
+
+  EventType type;
+  uint64_t sequence;  // one more than the book's previous event
+  OrderHandle order;
+  bool is_buy;
+  Price price;
+  Quantity quantity;
+  Quantity open_qty;
+};
+
+} }
@@ -0,0 +1,286 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include "types.h"
+#include "depth_level.h"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace liquibook { namespace book {
+
+/// @brief Flat binary image of an order book.
+///
+/// The image is a header followed by fixed size records, in host byte
+/// order, each section aligned to 8 bytes:
+///
+///   BookSnapshotHeader
+///   BookSnapshotOrder   bids, best price first, then arrival order
+///   BookSnapshotOrder   asks, likewise
+///   BookSnapshotOrder   stop bids, first to be triggered first
+///   BookSnapshotOrder   stop asks, likewise
+///   BookSnapshotLevel   visible depth bid levels, then ask levels
+///
+/// Orders are in the order the book keeps them, so restoring them one
+/// after another restores their time priority without matching.  The
+/// book does not know how to save the orders themselves: each record
+/// carries a reference the application chooses (an index into its own
+/// order table, for instance) and the application maps it back to an
+/// order on restore.
+///
+/// An image can be used in place, from a buffer or a memory mapped file:
+/// BookSnapshotView only checks the header and points into it.
+struct BookSnapshotHeader {
+  char magic[4];
+  uint16_t version;
+  uint16_t header_size;
+  uint16_t order_size;
+  uint16_t level_size;
+  uint32_t depth_size;     // visible levels per side, zero without depth
+  Price market_price;
+  uint64_t event_sequence;
+  uint64_t bid_count;
+  uint64_t ask_count;
+  uint64_t stop_bid_count;
+  uint64_t stop_ask_count;
+};
+
+/// @brief one order in a book snapshot
+struct BookSnapshotOrder {
+  uint64_t order_ref;      // chosen by the application
+  Price price;
+  Price stop_price;
+  Quantity open_qty;
+  OrderConditions conditions;
+  uint8_t is_buy;
+  uint8_t reserved[3];
+};
+
+/// @brief one depth level in a book snapshot
+struct BookSnapshotLevel {
+  Price price;
+  Quantity aggregate_qty;
+  uint32_t order_count;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(BookSnapshotHeader) % 8 == 0 &&
+  sizeof(BookSnapshotOrder) % 8 == 0 && sizeof(BookSnapshotLevel) % 8 == 0,
+  "book snapshot sections stay 8 byte aligned");
+
+static const char BOOK_SNAPSHOT_MAGIC[4] = { 'L', 'Q', 'B', 'S' };
+static const uint16_t BOOK_SNAPSHOT_VERSION = 1;
+
+/// @brief read only access to a book snapshot image, without copying it.
+class BookSnapshotView {
+public:
+  /// @brief check an image and point into it
+  /// @param data the image.  Must be 8 byte aligned and outlive the view.
+  /// @param size the size of the image in bytes
+  /// @throws std::runtime_error if this is not a complete image of this
+  ///         version
+  BookSnapshotView(const void * data, size_t size);
+
+  const BookSnapshotHeader & header() const { return *header_; }
+
+  const BookSnapshotOrder * bids() const { return bids_; }
+  const BookSnapshotOrder * asks() const { return bids_ + header_->bid_count; }
+  const BookSnapshotOrder * stop_bids() const
+    { return asks() + header_->ask_count; }
+  const BookSnapshotOrder * stop_asks() const
+    { return stop_bids() + header_->stop_bid_count; }
+
+  /// @brief the visible bid levels, header().depth_size of them.
+  /// Unused levels have price INVALID_LEVEL_PRICE.
+  const BookSnapshotLevel * depth_bids() const { return levels_; }
+  const BookSnapshotLevel * depth_asks() const
+    { return levels_ + header_->depth_size; }
+
+  /// @brief the size of an image with these counts
+  static size_t image_size(size_t bid_count, size_t ask_count,
+                           size_t stop_bid_count, size_t stop_ask_count,
+                           size_t depth_size);
+
+private:
+  const BookSnapshotHeader * header_;
+  const BookSnapshotOrder * bids_;
+  const BookSnapshotLevel * levels_;
+};
+
+namespace snapshot_detail {
+
+template <class Trackers, class OrderRef>
+BookSnapshotOrder * write_orders(const Trackers & trackers, OrderRef & ref,
+                                 BookSnapshotOrder * out)
+{
+  for(auto pos = trackers.begin(); pos != trackers.end(); ++pos, ++out)
+  {
+    const auto & tracker = pos->second;
+    memset(out, 0, sizeof(BookSnapshotOrder));
+    out->order_ref = ref(tracker.ptr());
+    out->price = tracker.price();
+    out->stop_price = tracker.stop_price();
+    out->open_qty = tracker.open_qty();
+    out->conditions = tracker.conditions();
+    out->is_buy = tracker.is_buy() ? 1 : 0;
+  }
+  return out;
+}
+
+template <class Book, class OrderFor>
+void restore_orders(Book & book, const BookSnapshotOrder * in, uint64_t count,
+                    bool is_stop, OrderFor & order_for)
+{
+  for(const BookSnapshotOrder * end = in + count; in != end; ++in)
+  {
+    book.restore_order(order_for(*in), in->price, in->open_qty,
+      in->conditions, is_stop);
+  }
+}
+
+// Books with depth (DepthOrderBook) save their visible levels.
+template <class Book>
+auto depth_of(const Book & book, int)
+  -> decltype(book.depth().bids(), std::pair<const DepthLevel *, size_t>())
+{
+  const DepthLevel * bids = book.depth().bids();
+  return std::make_pair(bids, size_t(book.depth().asks() - bids));
+}
+
+template <class Book>
+std::pair<const DepthLevel *, size_t> depth_of(const Book &, long)
+{
+  return std::make_pair(static_cast<const DepthLevel *>(nullptr), size_t(0));
+}
+
+} // namespace snapshot_detail
+
+/// @brief write a snapshot of a book in one pass over its containers.
+/// @param book the book
+/// @param ref called with each order, returns the reference to save for it
+/// @param[OUT] image replaced by the snapshot image
+template <class Book, class OrderRef>
+void write_book_snapshot(const Book & book, OrderRef ref,
+                         std::vector<uint64_t> & image)
+{
+  std::pair<const DepthLevel *, size_t> depth =
+    snapshot_detail::depth_of(book, 0);
+  size_t size = BookSnapshotView::image_size(book.bids().size(),
+    book.asks().size(), book.stopBids().size(), book.stopAsks().size(),
+    depth.second);
+  image.assign(size / sizeof(uint64_t), 0);
+
+  BookSnapshotHeader * header =
+    reinterpret_cast<BookSnapshotHeader *>(image.data());
+  memcpy(header->magic, BOOK_SNAPSHOT_MAGIC, sizeof(header->magic));
+  header->version = BOOK_SNAPSHOT_VERSION;
+  header->header_size = sizeof(BookSnapshotHeader);
+  header->order_size = sizeof(BookSnapshotOrder);
+  header->level_size = sizeof(BookSnapshotLevel);
+  header->depth_size = uint32_t(depth.second);
+  header->market_price = book.market_price();
+  header->event_sequence = book.event_sequence();
+  header->bid_count = book.bids().size();
+  header->ask_count = book.asks().size();
+  header->stop_bid_count = book.stopBids().size();
+  header->stop_ask_count = book.stopAsks().size();
+
+  BookSnapshotOrder * orders = reinterpret_cast<BookSnapshotOrder *>(header + 1);
+  orders = snapshot_detail::write_orders(book.bids(), ref, orders);
+  orders = snapshot_detail::write_orders(book.asks(), ref, orders);
+  orders = snapshot_detail::write_orders(book.stopBids(), ref, orders);
+  orders = snapshot_detail::write_orders(book.stopAsks(), ref, orders);
+
+  BookSnapshotLevel * level = reinterpret_cast<BookSnapshotLevel *>(orders);
+  for(size_t i = 0; i < depth.second * 2; ++i, ++level)
+  {
+    const DepthLevel & source = depth.first[i];
+    level->price = source.price();
+    level->aggregate_qty = source.aggregate_qty();
+    level->order_count = source.order_count();
+  }
+}
+
+/// @brief put the orders in a snapshot back into an empty book, in the
+/// order they were saved, without matching them or issuing callbacks.
+/// Listeners see the restored book from the next change on.
+/// @param book the book
+/// @param view the snapshot
+/// @param order_for called with each BookSnapshotOrder, returns the order
+///        its order_ref refers to
+/// @throws std::runtime_error if the book is not empty
+template <class Book, class OrderFor>
+void restore_book_snapshot(Book & book, const BookSnapshotView & view,
+                           OrderFor order_for)
+{
+  if(!book.bids().empty() || !book.asks().empty() ||
+    !book.stopBids().empty() || !book.stopAsks().empty())
+  {
+    throw std::runtime_error("Snapshot can only be restored to an empty book");
+  }
+  const BookSnapshotHeader & header = view.header();
+  book.restore_market(header.market_price, header.event_sequence);
+  snapshot_detail::restore_orders(book, view.bids(), header.bid_count,
+    false, order_for);
+  snapshot_detail::restore_orders(book, view.asks(), header.ask_count,
+    false, order_for);
+  snapshot_detail::restore_orders(book, view.stop_bids(),
+    header.stop_bid_count, true, order_for);
+  snapshot_detail::restore_orders(book, view.stop_asks(),
+    header.stop_ask_count, true, order_for);
+}
+
+inline
+BookSnapshotView::BookSnapshotView(const void * data, size_t size)
+: header_(static_cast<const BookSnapshotHeader *>(data)),
+  bids_(nullptr),
+  levels_(nullptr)
+{
+  if(size < sizeof(BookSnapshotHeader) ||
+    memcmp(header_->magic, BOOK_SNAPSHOT_MAGIC, sizeof(header_->magic)) != 0)
+  {
+    throw std::runtime_error("Not a book snapshot");
+  }
+  if(header_->version != BOOK_SNAPSHOT_VERSION ||
+    header_->header_size != sizeof(BookSnapshotHeader) ||
+    header_->order_size != sizeof(BookSnapshotOrder) ||
+    header_->level_size != sizeof(BookSnapshotLevel))
+  {
+    throw std::runtime_error("Unsupported book snapshot version");
+  }
+  // Each count is at most the image size, so the sum cannot overflow
+  const uint64_t counts[] = { header_->bid_count, header_->ask_count,
+    header_->stop_bid_count, header_->stop_ask_count };
+  for(size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+  {
+    if(counts[i] > size)
+    {
+      throw std::runtime_error("Book snapshot is truncated");
+    }
+  }
+  if(size < image_size(header_->bid_count, header_->ask_count,
+    header_->stop_bid_count, header_->stop_ask_count, header_->depth_size))
+  {
+    throw std::runtime_error("Book snapshot is truncated");
+  }
+  bids_ = reinterpret_cast<const BookSnapshotOrder *>(header_ + 1);
+  levels_ = reinterpret_cast<const BookSnapshotLevel *>(stop_asks() +
+    header_->stop_ask_count);
+}
+
+inline
+size_t
+BookSnapshotView::image_size(size_t bid_count, size_t ask_count,
+  size_t stop_bid_count, size_t stop_ask_count, size_t depth_size)
+{
+  return sizeof(BookSnapshotHeader) +
+    sizeof(BookSnapshotOrder) *
+      (bid_count + ask_count + stop_bid_count + stop_ask_count) +
+    sizeof(BookSnapshotLevel) * depth_size * 2;
+}
+
+} }
@@ -0,0 +1,106 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include "comparable_price.h"
+#include "price_ladder.h"
+#include "pool_allocator.h"
+#include "stop_book.h"
+#include "level_quantities.h"
+#include <map>
+
+namespace liquibook { namespace book {
+
+/// @brief Storage policies for the containers that hold resting and stop
+///        orders in an OrderBook.
+///
+/// A storage policy supplies the TrackerMap type for a given tracker type
+/// through a nested Bind template.  The TrackerMap must provide the subset
+/// of the std::multimap<ComparablePrice, Tracker> interface used by
+/// OrderBook: begin, end, rbegin, rend, find, insert, emplace, erase, size
+/// and empty, with iterators that yield first (price) and second (tracker)
+/// and that remain valid when other entries are erased.
+///
+/// It also supplies the StopMap type that holds stop orders until they
+/// are triggered (see stop_book.h), and the Quantities type that keeps
+/// the open quantity at each price level (see level_quantities.h).
+
+/// @brief Store each order in its own std::multimap node.
+struct MultimapStorage
+{
+  template <class Tracker>
+  struct Bind
+  {
+    typedef std::multimap<ComparablePrice, Tracker> TrackerMap;
+    typedef StopBook<Tracker> StopMap;
+    typedef LevelQuantities<> Quantities;
+  };
+};
+
+/// @brief Keep levels in a std::map whose nodes come from a pool owned by
+///        the map, for containers used with PooledStorage.
+struct PooledLevels
+{
+  template <class Level>
+  struct Bind
+  {
+    typedef std::map<ComparablePrice, Level,
+      std::less<ComparablePrice>,
+      PoolAllocator<std::pair<const ComparablePrice, Level> > > LevelMap;
+  };
+};
+
+/// @brief Store each order in a std::multimap node taken from a pool
+///        owned by the container.  Nodes of erased orders are reused, so
+///        once the book reaches its working size adding and removing
+///        orders does not allocate.
+struct PooledStorage
+{
+  template <class Tracker>
+  struct Bind
+  {
+    typedef std::multimap<ComparablePrice, Tracker,
+      std::less<ComparablePrice>,
+      PoolAllocator<std::pair<const ComparablePrice, Tracker> > > TrackerMap;
+    typedef StopBook<Tracker, PooledLevels> StopMap;
+    typedef LevelQuantities<PooledLevels> Quantities;
+  };
+};
+
+/// @brief Store orders in a PriceLadder: one node per price level,
+///        each level a contiguous FIFO of orders.
+struct LadderStorage
+{
+  template <class Tracker>
+  struct Bind
+  {
+    typedef PriceLadder<Tracker> TrackerMap;
+    typedef StopBook<Tracker> StopMap;
+    typedef LevelQuantities<> Quantities;
+  };
+};
+
+/// @brief Store orders in a PriceLadder whose levels are indexed by tick
+///        on the book's price band (see OrderBook::set_price_band).
+///        Prices off the band are kept in a std::map.
+struct TickLadderStorage
+{
+  template <class Tracker>
+  struct Bind
+  {
+    typedef PriceLadder<Tracker, TickLevels> TrackerMap;
+    typedef StopBook<Tracker, TickLevels> StopMap;
+    typedef LevelQuantities<TickLevels> Quantities;
+  };
+};
+
+// Define LIQUIBOOK_DEFAULT_STORAGE to change the storage used by books
+// that do not name one explicitly.
+#ifndef LIQUIBOOK_DEFAULT_STORAGE
+#define LIQUIBOOK_DEFAULT_STORAGE MultimapStorage
+#endif // LIQUIBOOK_DEFAULT_STORAGE
+
+typedef LIQUIBOOK_DEFAULT_STORAGE DefaultStorage;
+
+} }
@@ -4,10 +4,13 @@
 #pragma once
 
 #include "types.h"
+#include "book_storage.h"
+
+#include <utility>
 
 namespace liquibook { namespace book {
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage = DefaultStorage, class Derived = void>
 class OrderBook;
 
 // Callback events
@@ -36,10 +39,19 @@ class OrderBook;
 //     - order replace reject
 
 /// @brief notification from OrderBook of an event
+///
+/// A callback refers to orders by handle: the address of the order as a
+/// plain pointer.  For a book of plain pointers that is the OrderPtr
+/// itself.  A book of smart pointers keeps every order its queued
+/// callbacks refer to until they have been performed, and passes the
+/// OrderPtr to its callback methods and listeners.  Either way a callback
+/// is trivially copyable, so queueing one never touches a reference count.
 template <typename OrderPtr>
 class Callback {
 public:
   typedef OrderBook<OrderPtr > TypedOrderBook;
+  /// @brief how a callback refers to an order
+  typedef decltype(&*std::declval<const OrderPtr &>()) OrderHandle;
 
   enum CbType {
     cb_unknown,
@@ -98,9 +110,13 @@ public:
                                            const char* reason);
 
   static Callback<OrderPtr> book_update(const TypedOrderBook* book = nullptr);
+
+  /// @brief the handle for an order
+  static OrderHandle handle(const OrderPtr& order);
+
   CbType type;
-  OrderPtr order;
-  OrderPtr matched_order;
+  OrderHandle order;
+  OrderHandle matched_order;
   Quantity quantity;
   Price price;
   uint8_t flags;
@@ -121,13 +137,20 @@ Callback<OrderPtr>::Callback()
 {
 }
 
+template <class OrderPtr>
+typename Callback<OrderPtr>::OrderHandle
+Callback<OrderPtr>::handle(const OrderPtr& order)
+{
+  return &*order;
+}
+
 template <class OrderPtr>
 Callback<OrderPtr> Callback<OrderPtr>::accept(
   const OrderPtr& order)
 {
   Callback<OrderPtr> result;
   result.type = cb_order_accept;
-  result.order = order;
+  result.order = handle(order);
   return result;
 }
 
@@ -137,7 +160,7 @@ Callback<OrderPtr> Callback<OrderPtr>::accept_stop(
 {
   Callback<OrderPtr> result;
   result.type = cb_order_accept_stop;
-  result.order = order;
+  result.order = handle(order);
   return result;
 }
 
@@ -147,7 +170,7 @@ Callback<OrderPtr> Callback<OrderPtr>::trigger_stop(
 {
   Callback<OrderPtr> result;
   result.type = cb_order_trigger_stop;
-  result.order = order;
+  result.order = handle(order);
   return result;
 }
 
@@ -158,7 +181,7 @@ Callback<OrderPtr> Callback<OrderPtr>::reject(
 {
   Callback<OrderPtr> result;
   result.type = cb_order_reject;
-  result.order = order;
+  result.order = handle(order);
   result.reject_reason = reason;
   return result;
 }
@@ -173,8 +196,8 @@ Callback<OrderPtr> Callback<OrderPtr>::fill(
 {
   Callback<OrderPtr> result;
   result.type = cb_order_fill;
-  result.order = inbound_order;
-  result.matched_order = matched_order;
+  result.order = handle(inbound_order);
+  result.matched_order = handle(matched_order);
   result.quantity = fill_qty;
   result.price = fill_price;
   result.flags = fill_flags;
@@ -189,7 +212,7 @@ Callback<OrderPtr> Callback<OrderPtr>::cancel(
   // TODO save the open qty
   Callback<OrderPtr> result;
   result.type = cb_order_cancel;
-  result.order = order;
+  result.order = handle(order);
   result.quantity = open_qty;
   return result;
 }
@@ -200,7 +223,7 @@ Callback<OrderPtr> Callback<OrderPtr>::cancel_stop(
 {
   Callback<OrderPtr> result;
   result.type = cb_order_cancel_stop;
-  result.order = order;
+  result.order = handle(order);
   return result;
 }
 
@@ -211,7 +234,7 @@ Callback<OrderPtr> Callback<OrderPtr>::cancel_reject(
 {
   Callback<OrderPtr> result;
   result.type = cb_order_cancel_reject;
-  result.order = order;
+  result.order = handle(order);
   result.reject_reason = reason;
   return result;
 }
@@ -226,7 +249,7 @@ Callback<OrderPtr> Callback<OrderPtr>::replace(
   // TODO save the order open qty
   Callback<OrderPtr> result;
   result.type = cb_order_replace;
-  result.order = order;
+  result.order = handle(order);
   result.quantity = curr_open_qty;
   result.delta = size_delta;
   result.price = new_price;
@@ -240,7 +263,7 @@ Callback<OrderPtr> Callback<OrderPtr>::replace_reject(
 {
   Callback<OrderPtr> result;
   result.type = cb_order_replace_reject;
-  result.order = order;
+  result.order = handle(order);
   result.reject_reason = reason;
   return result;
 }
@@ -0,0 +1,87 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include "types.h"
+
+namespace liquibook { namespace book {
+
+/// @brief request to an OrderBook: add, cancel or replace one order.
+/// A sequence of commands can be applied with OrderBook::apply_batch.
+template <typename OrderPtr>
+class Command {
+public:
+  enum CmdType {
+    cmd_unknown,
+    cmd_add,
+    cmd_cancel,
+    cmd_replace
+  };
+
+  Command();
+
+  /// @brief create a new add command
+  static Command<OrderPtr> add(const OrderPtr& order,
+                               OrderConditions conditions = 0);
+  /// @brief create a new cancel command
+  static Command<OrderPtr> cancel(const OrderPtr& order);
+  /// @brief create a new replace command
+  static Command<OrderPtr> replace(const OrderPtr& order,
+                                   int64_t size_delta = SIZE_UNCHANGED,
+                                   Price new_price = PRICE_UNCHANGED);
+
+  CmdType type;
+  OrderPtr order;
+  OrderConditions conditions;
+  int64_t size_delta;
+  Price price;
+};
+
+template <class OrderPtr>
+Command<OrderPtr>::Command()
+: type(cmd_unknown),
+  order(nullptr),
+  conditions(0),
+  size_delta(SIZE_UNCHANGED),
+  price(PRICE_UNCHANGED)
+{
+}
+
+template <class OrderPtr>
+Command<OrderPtr> Command<OrderPtr>::add(
+  const OrderPtr& order,
+  OrderConditions conditions)
+{
+  Command<OrderPtr> result;
+  result.type = cmd_add;
+  result.order = order;
+  result.conditions = conditions;
+  return result;
+}
+
+template <class OrderPtr>
+Command<OrderPtr> Command<OrderPtr>::cancel(
+  const OrderPtr& order)
+{
+  Command<OrderPtr> result;
+  result.type = cmd_cancel;
+  result.order = order;
+  return result;
+}
+
+template <class OrderPtr>
+Command<OrderPtr> Command<OrderPtr>::replace(
+  const OrderPtr& order,
+  int64_t size_delta,
+  Price new_price)
+{
+  Command<OrderPtr> result;
+  result.type = cmd_replace;
+  result.order = order;
+  result.size_delta = size_delta;
+  result.price = new_price;
+  return result;
+}
+
+} }
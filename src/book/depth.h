@@ -5,6 +5,7 @@
 
 #include "depth_constants.h"
 #include "depth_level.h"
+#include "tick_map.h"
 #include <stdexcept>
 #include <map>
 #include <cmath>
@@ -113,6 +114,10 @@ public:
   /// @brief note the ID of last published change
   void published();
 
+  /// @brief keep levels beyond the visible depth in arrays indexed by
+  ///        tick on this band.  Only allowed before any orders are added.
+  void set_price_band(const PriceBand & band);
+
 private:
   DepthLevel levels_[SIZE*2];
   ChangeId last_change_;
@@ -120,8 +125,9 @@ private:
   Quantity ignore_bid_fill_qty_;
   Quantity ignore_ask_fill_qty_;
 
-  typedef std::map<Price, DepthLevel, std::greater<Price> > BidLevelMap;
-  typedef std::map<Price, DepthLevel, std::less<Price> > AskLevelMap;
+  // Keyed by ComparablePrice so the best excess level is first.
+  typedef TickMap<DepthLevel> BidLevelMap;
+  typedef TickMap<DepthLevel> AskLevelMap;
   BidLevelMap excess_bid_levels_;
   AskLevelMap excess_ask_levels_;
 
@@ -406,7 +412,8 @@ Depth<SIZE>::find_level(Price price, bool is_bid, bool should_create)
   if (level == past_end) {
     if (is_bid) {
       // Search in excess bid levels
-      BidLevelMap::iterator find_result = excess_bid_levels_.find(price);
+      BidLevelMap::iterator find_result =
+        excess_bid_levels_.find(ComparablePrice(true, price));
       // If found in excess levels, return location
       if (find_result != excess_bid_levels_.end()) {
         level = &find_result->second;
@@ -416,12 +423,13 @@ Depth<SIZE>::find_level(Price price, bool is_bid, bool should_create)
         new_level.init(price, true);
         std::pair<BidLevelMap::iterator, bool> insert_result;
         insert_result = excess_bid_levels_.insert(
-            std::make_pair(price, new_level));
+            std::make_pair(ComparablePrice(true, price), new_level));
         level = &insert_result.first->second;
       }
     } else {
       // Search in excess ask levels
-      AskLevelMap::iterator find_result = excess_ask_levels_.find(price);
+      AskLevelMap::iterator find_result =
+        excess_ask_levels_.find(ComparablePrice(false, price));
       // If found in excess levels, return location
       if (find_result != excess_ask_levels_.end()) {
         level = &find_result->second;
@@ -431,7 +439,7 @@ Depth<SIZE>::find_level(Price price, bool is_bid, bool should_create)
         new_level.init(price, true);
         std::pair<AskLevelMap::iterator, bool> insert_result;
         insert_result = excess_ask_levels_.insert(
-            std::make_pair(price, new_level));
+            std::make_pair(ComparablePrice(false, price), new_level));
         level = &insert_result.first->second;
       }
     }
@@ -455,10 +463,12 @@ Depth<SIZE>::insert_level_before(DepthLevel* level,
     // Save it in excess levels
     if (is_bid) {
       excess_bid_levels_.insert(
-      std::make_pair(last_side_level->price(), excess_level));
+      std::make_pair(ComparablePrice(true, last_side_level->price()),
+                     excess_level));
     } else {
       excess_ask_levels_.insert(
-      std::make_pair(last_side_level->price(), excess_level));
+      std::make_pair(ComparablePrice(false, last_side_level->price()),
+                     excess_level));
     }
   }
   // Back from end
@@ -487,9 +497,9 @@ Depth<SIZE>::erase_level(DepthLevel* level, bool is_bid)
   // If ther level being erased is from the excess, remove excess from map
   if (level->is_excess()) {
     if (is_bid) {
-      excess_bid_levels_.erase(level->price());
+      excess_bid_levels_.erase(ComparablePrice(true, level->price()));
     } else {
-      excess_ask_levels_.erase(level->price());
+      excess_ask_levels_.erase(ComparablePrice(false, level->price()));
     }
   // Else the level being erased is not excess, copy over from those worse
   } else {
@@ -572,4 +582,12 @@ Depth<SIZE>::published()
   last_published_change_ = last_change_;
 }
 
+template <int SIZE> 
+void
+Depth<SIZE>::set_price_band(const PriceBand & band)
+{
+  excess_bid_levels_.set_band(true, band);
+  excess_ask_levels_.set_band(false, band);
+}
+
 } }
@@ -83,7 +83,9 @@ inline
 DepthLevel::DepthLevel()
   : price_(INVALID_LEVEL_PRICE),
   order_count_(0),
-  aggregate_qty_(0)
+  aggregate_qty_(0),
+  is_excess_(false),
+  last_change_(0)
 {
 }
 
@@ -12,8 +12,10 @@ namespace liquibook { namespace book {
 
 /// @brief Implementation of order book child class, that incorporates
 ///        aggregate depth tracking.  
-template <typename OrderPtr, int SIZE = 5>
-class DepthOrderBook : public OrderBook<OrderPtr> {
+///        Derived works as it does for OrderBook.
+template <typename OrderPtr, int SIZE = 5, class Storage = DefaultStorage,
+          class Derived = void>
+class DepthOrderBook : public OrderBook<OrderPtr, Storage, Derived> {
 public:
   typedef Depth<SIZE> DepthTracker;
   typedef BboListener<DepthOrderBook >TypedBboListener;
@@ -34,6 +36,18 @@ public:
   // @brief access the depth tracker
   const DepthTracker& depth() const;
 
+  /// @brief Set the prices this security normally trades at, for both
+  ///        the order containers and the depth tracker.
+  virtual void set_price_band(const PriceBand & band);
+
+  /// @brief restore an order (see OrderBook::restore_order) and its
+  ///        quantity in the depth.
+  virtual void restore_order(const OrderPtr& order,
+                             Price price,
+                             Quantity open_qty,
+                             OrderConditions conditions,
+                             bool is_stop);
+
   protected:
   //////////////////////////////////
   // Implement virtual callback methods
@@ -59,40 +73,77 @@ public:
 
   virtual void on_order_book_change();
 
+  /// @brief callback for change in tracked aggregated depth
+  virtual void on_depth_change(const DepthTracker* depth);
+
+  /// @brief callback for top of book change
+  virtual void on_bbo_change(const DepthTracker* depth);
+
 private:
+  typedef typename std::conditional<std::is_void<Derived>::value,
+    DepthOrderBook, Derived>::type Self;
+
+  Self & self() { return static_cast<Self &>(*this); }
+
   DepthTracker depth_;
   TypedBboListener* bbo_listener_;
   TypedDepthListener* depth_listener_;
 };
 
-template <class OrderPtr, int SIZE>
-DepthOrderBook<OrderPtr, SIZE>::DepthOrderBook(const std::string & symbol)
-: OrderBook<OrderPtr>(symbol),
+template <class OrderPtr, int SIZE, class Storage, class Derived>
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::DepthOrderBook(const std::string & symbol)
+: OrderBook<OrderPtr, Storage, Derived>(symbol),
   bbo_listener_(nullptr),
   depth_listener_(nullptr)
 {
 }
 
-template <class OrderPtr, int SIZE>
+template <class OrderPtr, int SIZE, class Storage, class Derived>
+void
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::set_price_band(const PriceBand & band)
+{
+  OrderBook<OrderPtr, Storage, Derived>::set_price_band(band);
+  depth_.set_price_band(band);
+}
+
+template <class OrderPtr, int SIZE, class Storage, class Derived>
 void
-DepthOrderBook<OrderPtr, SIZE>::set_bbo_listener(TypedBboListener* listener)
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::restore_order(
+  const OrderPtr& order,
+  Price price,
+  Quantity open_qty,
+  OrderConditions conditions,
+  bool is_stop)
+{
+  OrderBook<OrderPtr, Storage, Derived>::restore_order(
+    order, price, open_qty, conditions, is_stop);
+  // Depth is kept for resting limit orders only, as in on_accept
+  if(!is_stop && price != MARKET_ORDER_PRICE)
+  {
+    depth_.add_order(price, open_qty, order->is_buy());
+  }
+}
+
+template <class OrderPtr, int SIZE, class Storage, class Derived>
+void
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::set_bbo_listener(TypedBboListener* listener)
 {
   bbo_listener_ = listener;
 }
 
-template <class OrderPtr, int SIZE>
+template <class OrderPtr, int SIZE, class Storage, class Derived>
 void
-DepthOrderBook<OrderPtr, SIZE>::set_depth_listener(TypedDepthListener* listener)
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::set_depth_listener(TypedDepthListener* listener)
 {
   depth_listener_ = listener;
 }
 
-template <class OrderPtr, int SIZE> 
+template <class OrderPtr, int SIZE, class Storage, class Derived>
 void 
-DepthOrderBook<OrderPtr, SIZE>::on_accept(const OrderPtr& order, Quantity quantity)
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::on_accept(const OrderPtr& order, Quantity quantity)
 {
   // If the order is a limit order
-  if (order->is_limit())
+  if (order->price() != MARKET_ORDER_PRICE)
   {
     // If the order is completely filled on acceptance, do not modify 
     // depth unnecessarily
@@ -112,23 +163,23 @@ DepthOrderBook<OrderPtr, SIZE>::on_accept(const OrderPtr& order, Quantity quanti
   }
 }
 
-template <class OrderPtr, int SIZE> 
+template <class OrderPtr, int SIZE, class Storage, class Derived>
 void 
-DepthOrderBook<OrderPtr, SIZE>::on_accept_stop(const OrderPtr& order)
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::on_accept_stop(const OrderPtr& order)
 {
 }
 
-template <class OrderPtr, int SIZE> 
+template <class OrderPtr, int SIZE, class Storage, class Derived>
 void 
-DepthOrderBook<OrderPtr, SIZE>::on_trigger_stop(const OrderPtr& order)
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::on_trigger_stop(const OrderPtr& order)
 {
   // Add to depth
   depth_.add_order(order->price(), order->order_qty(), order->is_buy());
 }
 
-template <class OrderPtr, int SIZE> 
+template <class OrderPtr, int SIZE, class Storage, class Derived>
 void 
-DepthOrderBook<OrderPtr, SIZE>::on_fill(const OrderPtr& order, 
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::on_fill(const OrderPtr& order, 
   const OrderPtr& matched_order, 
   Quantity quantity, 
   Price fill_price,
@@ -136,7 +187,7 @@ DepthOrderBook<OrderPtr, SIZE>::on_fill(const OrderPtr& order,
   bool matched_order_filled)
 {
   // If the matched order is a limit order
-  if (matched_order->is_limit()) {
+  if (matched_order->price() != MARKET_ORDER_PRICE) {
     // Inform the depth
     depth_.fill_order(matched_order->price(), 
       quantity,
@@ -144,7 +195,7 @@ DepthOrderBook<OrderPtr, SIZE>::on_fill(const OrderPtr& order,
       matched_order->is_buy());
   }
   // If the inbound order is a limit order
-  if (order->is_limit()) {
+  if (order->price() != MARKET_ORDER_PRICE) {
     // Inform the depth
     depth_.fill_order(order->price(), 
       quantity,
@@ -153,12 +204,12 @@ DepthOrderBook<OrderPtr, SIZE>::on_fill(const OrderPtr& order,
   }
 }
 
-template <class OrderPtr, int SIZE> 
+template <class OrderPtr, int SIZE, class Storage, class Derived>
 void 
-DepthOrderBook<OrderPtr, SIZE>::on_cancel(const OrderPtr& order, Quantity quantity)
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::on_cancel(const OrderPtr& order, Quantity quantity)
 {
   // If the order is a limit order
-  if (order->is_limit()) {
+  if (order->price() != MARKET_ORDER_PRICE) {
     // If the close erases a level
     depth_.close_order(order->price(), 
       quantity, 
@@ -166,16 +217,16 @@ DepthOrderBook<OrderPtr, SIZE>::on_cancel(const OrderPtr& order, Quantity quanti
   }
 }
 
-template <class OrderPtr, int SIZE> 
+template <class OrderPtr, int SIZE, class Storage, class Derived>
 void 
-DepthOrderBook<OrderPtr, SIZE>::on_cancel_stop(const OrderPtr& order)
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::on_cancel_stop(const OrderPtr& order)
 {
   // nothing to do for STOP until triggered/submitted
 }
 
-template <class OrderPtr, int SIZE> 
+template <class OrderPtr, int SIZE, class Storage, class Derived>
 void 
-DepthOrderBook<OrderPtr, SIZE>::on_replace(const OrderPtr& order,
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::on_replace(const OrderPtr& order,
   Quantity current_qty, 
   Quantity new_qty,
   Price new_price)
@@ -185,38 +236,54 @@ DepthOrderBook<OrderPtr, SIZE>::on_replace(const OrderPtr& order,
     current_qty, new_qty, order->is_buy());
 }
 
-template <class OrderPtr, int SIZE> 
+template <class OrderPtr, int SIZE, class Storage, class Derived>
 void 
-DepthOrderBook<OrderPtr, SIZE>::on_order_book_change()
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::on_order_book_change()
 {
   // Book was updated, see if the depth we track was effected
   if (depth_.changed()) {
-    if (depth_listener_) {
-      depth_listener_->on_depth_change(this, &depth_);
-    }
-    if (bbo_listener_) {
-      ChangeId last_change = depth_.last_published_change();
-      // May have been the first level which changed
-      if ((depth_.bids()->changed_since(last_change)) ||
-        (depth_.asks()->changed_since(last_change))) {
-        bbo_listener_->on_bbo_change(this, &depth_);
-      }
+    self().on_depth_change(&depth_);
+    ChangeId last_change = depth_.last_published_change();
+    // May have been the first level which changed
+    if ((depth_.bids()->changed_since(last_change)) ||
+      (depth_.asks()->changed_since(last_change))) {
+      self().on_bbo_change(&depth_);
     }
     // Start tracking changes again...
     depth_.published();
   }
 }
 
-template <class OrderPtr, int SIZE>
-inline typename DepthOrderBook<OrderPtr, SIZE>::DepthTracker&
-DepthOrderBook<OrderPtr, SIZE>::depth()
+template <class OrderPtr, int SIZE, class Storage, class Derived>
+void
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::on_depth_change(
+  const DepthTracker* depth)
+{
+  if (depth_listener_) {
+    depth_listener_->on_depth_change(this, depth);
+  }
+}
+
+template <class OrderPtr, int SIZE, class Storage, class Derived>
+void
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::on_bbo_change(
+  const DepthTracker* depth)
+{
+  if (bbo_listener_) {
+    bbo_listener_->on_bbo_change(this, depth);
+  }
+}
+
+template <class OrderPtr, int SIZE, class Storage, class Derived>
+inline typename DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::DepthTracker&
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::depth()
 {
   return depth_;
 }
 
-template <class OrderPtr, int SIZE>
-inline const typename DepthOrderBook<OrderPtr, SIZE>::DepthTracker&
-DepthOrderBook<OrderPtr, SIZE>::depth() const
+template <class OrderPtr, int SIZE, class Storage, class Derived>
+inline const typename DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::DepthTracker&
+DepthOrderBook<OrderPtr, SIZE, Storage, Derived>::depth() const
 {
   return depth_;
 }
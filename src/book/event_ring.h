@@ -0,0 +1,191 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace liquibook { namespace book {
+
+/// @brief Bounded lock-free queue for passing events from one producer
+///        thread to one consumer thread.
+///
+/// The producer calls push() or try_push(); the consumer calls try_pop()
+/// or drain().  Neither side ever takes a lock or allocates.  Each slot is
+/// written by the producer and then read by the consumer, never both at
+/// once, so events are best kept small and trivially copyable.
+template <class Event>
+class EventRing {
+public:
+  /// @brief construct
+  /// @param capacity the most events the ring can hold.  Rounded up to a
+  ///        power of two.
+  explicit EventRing(size_t capacity = 4096);
+
+  /// @brief add an event if there is room.  Producer only.
+  /// @return false if the ring is full
+  bool try_push(const Event & event);
+
+  /// @brief add an event, waiting for the consumer if the ring is full.
+  /// Producer only.  Never call this from the consumer thread.
+  void push(const Event & event);
+
+  /// @brief remove the oldest event.  Consumer only.
+  /// @return false if the ring is empty
+  bool try_pop(Event & event);
+
+  /// @brief pass queued events, oldest first, to a handler.
+  /// Consumer only.  Slots are released once, after the last event.
+  /// @param handler called as handler(const Event &) for each event
+  /// @param max_events the most events to handle
+  /// @return the number of events handled
+  template <class Handler>
+  size_t drain(Handler handler, size_t max_events = size_t(-1));
+
+  /// @brief the most events the ring can hold
+  size_t capacity() const;
+
+  /// @brief number of queued events.  Exact only when neither side is
+  ///        active.
+  size_t size() const;
+
+  /// @brief are there no queued events?  Exact only when neither side is
+  ///        active.
+  bool empty() const;
+
+private:
+  EventRing(const EventRing &);
+  EventRing & operator =(const EventRing &);
+
+  static size_t round_up(size_t capacity);
+
+  std::vector<Event> slots_;
+  size_t mask_;
+  // Written by the consumer.  The consumer's copy of tail_ lives on the
+  // same cache line so it rarely needs to read the producer's line.
+  alignas(64) std::atomic<size_t> head_;
+  size_t tail_seen_;
+  // Written by the producer.
+  alignas(64) std::atomic<size_t> tail_;
+  size_t head_seen_;
+};
+
+template <class Event>
+EventRing<Event>::EventRing(size_t capacity)
+: slots_(round_up(capacity)),
+  mask_(slots_.size() - 1),
+  head_(0),
+  tail_seen_(0),
+  tail_(0),
+  head_seen_(0)
+{
+}
+
+template <class Event>
+size_t
+EventRing<Event>::round_up(size_t capacity)
+{
+  size_t size = 1;
+  while(size < capacity)
+  {
+    size <<= 1;
+  }
+  return size;
+}
+
+template <class Event>
+bool
+EventRing<Event>::try_push(const Event & event)
+{
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  if(tail - head_seen_ == slots_.size())
+  {
+    head_seen_ = head_.load(std::memory_order_acquire);
+    if(tail - head_seen_ == slots_.size())
+    {
+      return false;
+    }
+  }
+  slots_[tail & mask_] = event;
+  tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+template <class Event>
+void
+EventRing<Event>::push(const Event & event)
+{
+  while(!try_push(event))
+  {
+    std::this_thread::yield();
+  }
+}
+
+template <class Event>
+bool
+EventRing<Event>::try_pop(Event & event)
+{
+  size_t head = head_.load(std::memory_order_relaxed);
+  if(head == tail_seen_)
+  {
+    tail_seen_ = tail_.load(std::memory_order_acquire);
+    if(head == tail_seen_)
+    {
+      return false;
+    }
+  }
+  event = slots_[head & mask_];
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+template <class Event>
+template <class Handler>
+size_t
+EventRing<Event>::drain(Handler handler, size_t max_events)
+{
+  size_t head = head_.load(std::memory_order_relaxed);
+  tail_seen_ = tail_.load(std::memory_order_acquire);
+  size_t count = tail_seen_ - head;
+  if(count > max_events)
+  {
+    count = max_events;
+  }
+  for(size_t index = 0; index < count; ++index)
+  {
+    handler(static_cast<const Event &>(slots_[(head + index) & mask_]));
+  }
+  if(count != 0)
+  {
+    head_.store(head + count, std::memory_order_release);
+  }
+  return count;
+}
+
+template <class Event>
+size_t
+EventRing<Event>::capacity() const
+{
+  return slots_.size();
+}
+
+template <class Event>
+size_t
+EventRing<Event>::size() const
+{
+  // head first: tail only grows, so it cannot be behind the head read here
+  size_t head = head_.load(std::memory_order_acquire);
+  return tail_.load(std::memory_order_acquire) - head;
+}
+
+template <class Event>
+bool
+EventRing<Event>::empty() const
+{
+  return size() == 0;
+}
+
+} }
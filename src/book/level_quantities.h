@@ -0,0 +1,157 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include "comparable_price.h"
+#include "price_ladder.h"
+#include <cstdint>
+#include <stdexcept>
+
+namespace liquibook { namespace book {
+
+/// @brief Running totals of open quantity on one side of a book.
+///
+/// Keeps the open quantity at each price level and across the whole side,
+/// so the book can tell whether an order could be filled without looking
+/// at individual orders.  The total answers most questions at once; when
+/// it does not, available() adds up levels, best first, only until it has
+/// found enough.  The Levels policy (see price_ladder.h) selects the
+/// container that maps prices to totals.
+template <class Levels = OrderedLevels>
+class LevelQuantities {
+  typedef typename Levels::template Bind<Quantity>::LevelMap LevelMap;
+
+public:
+  /// @brief construct with no quantity on any level
+  LevelQuantities();
+
+  /// @brief add open quantity to a level
+  void add(const ComparablePrice & level, Quantity qty);
+
+  /// @brief take open quantity away from a level
+  /// @throws std::runtime_error if the level does not have that much
+  void remove(const ComparablePrice & level, Quantity qty);
+
+  /// @brief the open quantity at a level
+  Quantity at(const ComparablePrice & level) const;
+
+  /// @brief the open quantity on the whole side
+  Quantity total() const;
+
+  /// @brief how much could an order at this price trade?
+  /// @param price the price of an order on the other side
+  /// @param needed stop counting once this much has been found
+  /// @return the open quantity at matching prices, or needed if that is less
+  Quantity available(Price price, Quantity needed) const;
+
+  /// @brief number of levels with open quantity
+  size_t level_count() const;
+
+  /// @brief index levels on a price band, if the Levels policy supports it.
+  /// Only allowed while there is no quantity on any level.
+  void set_price_band(bool buy_side, const PriceBand & band);
+
+private:
+  LevelMap levels_;
+  Quantity total_;
+};
+
+template <class Levels>
+LevelQuantities<Levels>::LevelQuantities()
+: total_(0)
+{
+}
+
+template <class Levels>
+void
+LevelQuantities<Levels>::add(const ComparablePrice & level, Quantity qty)
+{
+  if(qty == 0)
+  {
+    return;
+  }
+  levels_.insert(std::make_pair(level, Quantity(0))).first->second += qty;
+  total_ += qty;
+}
+
+template <class Levels>
+void
+LevelQuantities<Levels>::remove(const ComparablePrice & level, Quantity qty)
+{
+  if(qty == 0)
+  {
+    return;
+  }
+  typename LevelMap::iterator pos = levels_.find(level);
+  if(pos == levels_.end() || pos->second < qty)
+  {
+    throw std::runtime_error("Removing more quantity than the level holds");
+  }
+  pos->second -= qty;
+  if(pos->second == 0)
+  {
+    levels_.erase(pos);
+  }
+  total_ -= qty;
+}
+
+template <class Levels>
+Quantity
+LevelQuantities<Levels>::at(const ComparablePrice & level) const
+{
+  typename LevelMap::const_iterator pos = levels_.find(level);
+  return pos == levels_.end() ? 0 : pos->second;
+}
+
+template <class Levels>
+Quantity
+LevelQuantities<Levels>::total() const
+{
+  return total_;
+}
+
+template <class Levels>
+Quantity
+LevelQuantities<Levels>::available(Price price, Quantity needed) const
+{
+  if(total_ < needed)
+  {
+    // there is not enough on the whole side
+    return total_;
+  }
+  Quantity found = 0;
+  for(typename LevelMap::const_iterator pos = levels_.begin();
+    pos != levels_.end() && found < needed && pos->first.matches(price);
+    ++pos)
+  {
+    found += pos->second;
+  }
+  return found < needed ? found : needed;
+}
+
+template <class Levels>
+size_t
+LevelQuantities<Levels>::level_count() const
+{
+  return levels_.size();
+}
+
+template <class Levels>
+void
+LevelQuantities<Levels>::set_price_band(bool buy_side, const PriceBand & band)
+{
+  configure_price_band(levels_, buy_side, band);
+}
+
+/// @brief index a LevelQuantities' levels on a band.
+template <class Levels>
+void
+configure_price_band(LevelQuantities<Levels> & quantities,
+                     bool buy_side,
+                     const PriceBand & band)
+{
+  quantities.set_price_band(buy_side, band);
+}
+
+} }
@@ -2,15 +2,30 @@
 #include "version.h"
 
 #include "depth_order_book.h"
+#include "static_order_book.h"
 #include "order.h"
 
 using namespace liquibook;
 using namespace book;
 namespace
 {
+  // The least an order must provide to satisfy the Order concept.
+  class CheckedOrder final : public Order
+  {
+  public:
+    bool is_buy() const { return true; }
+    Price price() const { return 0; }
+    Quantity order_qty() const { return 0; }
+  };
+  static_assert(is_order<CheckedOrder>::value, "CheckedOrder is an Order");
+  static_assert(!is_order<int>::value, "int is not an Order");
+
   // depth order book pulls in all the other header files.
-  // except order.h which is actually a concept.
-  DepthOrderBook<Order *, 5> unusedDepthOrderBook_;
+  DepthOrderBook<CheckedOrder *, 5> unusedDepthOrderBook_;
+  DepthOrderBook<CheckedOrder *, 5, LadderStorage> unusedLadderDepthOrderBook_;
+  DepthOrderBook<CheckedOrder *, 5, TickLadderStorage> unusedTickLadderDepthOrderBook_;
+  DepthOrderBook<CheckedOrder *, 5, PooledStorage> unusedPooledDepthOrderBook_;
+  StaticDepthOrderBook<CheckedOrder *, StaticListener> unusedStaticDepthOrderBook_;
 }
 
 int main(int, const char**)
@@ -0,0 +1,25 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include "book_event.h"
+
+namespace liquibook { namespace book {
+
+/// @brief listener of changes to resting orders.  Implement to build a
+/// market by order (L3) feed, or to keep a mirror of the book.
+template <class OrderBook >
+class MarketByOrderListener {
+public:
+  /// @brief callback for a change to a resting order
+  /// @param book the order book.  Events are delivered once the add,
+  ///      cancel or replace that caused them is done, so the book may
+  ///      already show later events.
+  /// @param event the change (see book_event.h)
+  virtual void on_book_event(
+      const OrderBook* book,
+      const typename OrderBook::TypedBookEvent& event) = 0;
+};
+
+} }
@@ -5,45 +5,43 @@
 
 #include "types.h"
 
+#include <type_traits>
+#include <utility>
+
 namespace liquibook { namespace book {
 
-/// @brief interface an order must implement in order to be used by OrderBook.
-/// Note: structly speaking, inheriting from Order should not be required, 
-///       due to the template implementation of OrderBook.
+/// @brief the Order concept: what OrderBook needs from an order.
+///
+/// An order type must provide, as const members:
+///   bool is_buy()              is this order a buy?
+///   Price price()              the limit price, or 0 for a market order
+///   Quantity order_qty()       the quantity of this order
+///   Price stop_price()         the stop price, or 0 if not a stop order
+///   bool all_or_none()         trade only if the order can be filled completely
+///   bool immediate_or_cancel() cancel whatever does not trade on arrival
+///
+/// The book calls them directly, so non-virtual accessors in a final class
+/// are inlined.  Inheriting from Order supplies the last three.
+/// OrderBook checks the concept with is_order when it is instantiated.
 class Order {
 public:
-  /// @brief is this a limit order?
-  bool is_limit() const;
-
-  /// @brief is this order a buy?
-  virtual bool is_buy() const = 0;
-
-  /// @brief get the price of this order, or 0 if a market order
-  virtual Price price() const = 0;
-
   /// @brief get the stop price (if any) for this order.
   /// @returns the stop price or zero if not a stop order
-  virtual Price stop_price() const;
-
-  /// @brief get the quantity of this order
-  virtual Quantity order_qty() const = 0;
+  Price stop_price() const;
 
   /// @brief if no trades should happen until the order
   /// can be filled completely.
   /// Note: one or more trades may be used to fill the order.
-  virtual bool all_or_none() const;
+  bool all_or_none() const;
 
   /// @brief After generating as many trades as possible against
   /// orders already on the market, cancel any remaining quantity.
-  virtual bool immediate_or_cancel() const;
-};
+  bool immediate_or_cancel() const;
 
-inline
-bool
-Order::is_limit() const 
-{
-  return (price() > 0);
-}
+protected:
+  // Orders are not deleted through a pointer to Order
+  ~Order() {}
+};
 
 inline
 Price
@@ -69,4 +67,30 @@ Order::immediate_or_cancel() const
   return false;
 }
 
+/// @brief does T satisfy the Order concept?
+template <class T, class = void>
+struct is_order : std::false_type
+{
+};
+
+template <class T>
+struct is_order<T, typename std::enable_if<
+  std::is_convertible<decltype(std::declval<const T &>().is_buy()), bool>::value &&
+  std::is_convertible<decltype(std::declval<const T &>().price()), Price>::value &&
+  std::is_convertible<decltype(std::declval<const T &>().order_qty()), Quantity>::value &&
+  std::is_convertible<decltype(std::declval<const T &>().stop_price()), Price>::value &&
+  std::is_convertible<decltype(std::declval<const T &>().all_or_none()), bool>::value &&
+  std::is_convertible<decltype(std::declval<const T &>().immediate_or_cancel()), bool>::value
+  >::type> : std::true_type
+{
+};
+
+/// @brief the order type an OrderPtr points to
+template <class OrderPtr>
+struct order_type
+{
+  typedef typename std::remove_cv<typename std::remove_reference<
+    decltype(*std::declval<const OrderPtr &>())>::type>::type type;
+};
+
 } }
@@ -4,12 +4,20 @@
 #pragma once
 
 #include "version.h"
+#include "order.h"
 #include "order_tracker.h"
 #include "callback.h"
+#include "book_event.h"
+#include "command.h"
+#include "event_ring.h"
 #include "order_listener.h"
 #include "order_book_listener.h"
 #include "trade_listener.h"
+#include "market_by_order_listener.h"
 #include "comparable_price.h"
+#include "book_storage.h"
+#include "order_index.h"
+#include "price_band.h"
 #include "logger.h"
 
 #include <sstream>
@@ -17,8 +25,8 @@
 #include <vector>
 #include <stdexcept>
 #include <cmath>
-#include <list>
 #include <functional>
+#include <type_traits>
 #include <algorithm>
 
 #ifdef LIQUIBOOK_IGNORES_DEPRECATED_CALLS
@@ -46,23 +54,42 @@ class OrderBookListener;
 /// @brief The limit order book of a security.  Template implementation allows
 ///        user to supply common or smart pointers, and to provide a different
 ///        Order class completely (as long as interface is obeyed).
-template <typename OrderPtr>
+///        The Storage policy selects the containers used to hold orders
+///        (see book_storage.h).
+///
+///        Derived is void for a book whose callbacks are dispatched at run
+///        time, through virtual methods and listener pointers.  A final
+///        class can pass itself as Derived (see static_order_book.h); the
+///        book then calls its callback methods through that class, so the
+///        compiler can bind and inline them.
+template <typename OrderPtr, class Storage, class Derived>
 class OrderBook {
+  static_assert(is_order<typename order_type<OrderPtr>::type>::value,
+    "OrderPtr must point to a type that satisfies the Order concept "
+    "(see order.h)");
 public:
   typedef OrderTracker<OrderPtr > Tracker;
   typedef Callback<OrderPtr > TypedCallback;
+  typedef typename TypedCallback::OrderHandle OrderHandle;
+  typedef Command<OrderPtr > TypedCommand;
+  typedef EventRing<TypedCallback > TypedEventRing;
   typedef OrderListener<OrderPtr > TypedOrderListener;
-  typedef OrderBook<OrderPtr > MyClass;
+  typedef OrderBook<OrderPtr, Storage, Derived > MyClass;
   typedef TradeListener<MyClass > TypedTradeListener;
   typedef OrderBookListener<MyClass > TypedOrderBookListener;
+  typedef BookEvent<OrderPtr > TypedBookEvent;
+  typedef MarketByOrderListener<MyClass > TypedMarketByOrderListener;
   typedef std::vector<TypedCallback > Callbacks;
-  typedef std::multimap<ComparablePrice, Tracker> TrackerMap;
+  typedef std::vector<TypedBookEvent > BookEvents;
+  typedef typename Storage::template Bind<Tracker>::TrackerMap TrackerMap;
+  typedef typename Storage::template Bind<Tracker>::StopMap StopMap;
+  typedef typename Storage::template Bind<Tracker>::Quantities Quantities;
   typedef std::vector<Tracker> TrackerVec;
   // Keep this around briefly for compatibility.
   typedef TrackerMap Bids;
   typedef TrackerMap Asks;
 
-  typedef std::list<typename TrackerMap::iterator> DeferredMatches;
+  typedef std::vector<typename TrackerMap::iterator> DeferredMatches;
 
   /// @brief construct
   OrderBook(const std::string & symbol = "unknown");
@@ -83,9 +110,27 @@ public:
   /// @brief set the order book listener
   void set_order_book_listener(TypedOrderBookListener* listener);
 
+  /// @brief set the market by order listener.
+  /// Changes to resting orders are only recorded while one is set.
+  void set_market_by_order_listener(TypedMarketByOrderListener* listener);
+
+  /// @brief the sequence number of the last book event, or zero if
+  /// there has been none.
+  uint64_t event_sequence() const;
+
   /// @brief let the application handle reporting errors.
   void set_logger(Logger * logger);
 
+  /// @brief also queue every callback, after the book has handled it, on
+  /// a ring another thread can drain.  Listeners set on the book are still
+  /// called as before, so a book that publishes from the ring usually has
+  /// none.  If the ring is full the book waits for the consumer.
+  /// Queued events refer to orders by handle, and the book lets go of the
+  /// orders that left it once its callbacks are done, so only books whose
+  /// handles are the orders themselves (raw pointers) can use a ring.
+  /// @param ring the ring, or nullptr to stop queueing callbacks.
+  void set_event_ring(TypedEventRing* ring);
+
   /// @brief add an order to book
   /// @param order the order to add
   /// @param conditions special conditions on the order
@@ -104,6 +149,35 @@ public:
                        int64_t size_delta = SIZE_UNCHANGED,
                        Price new_price = PRICE_UNCHANGED);
 
+  /// @brief apply a sequence of add, cancel and replace commands.
+  /// Each command is handled as if add(), cancel() or replace() had been
+  /// called, and its order, fill and trade callbacks happen in the same
+  /// order, but the book change notification (and so any depth or BBO
+  /// publication) happens once, after the last command.
+  /// @param commands the first command
+  /// @param count the number of commands
+  /// @return true if any command resulted in a fill
+  bool apply_batch(const TypedCommand* commands, size_t count);
+
+  /// @brief put an order back into the book as it was when a snapshot was
+  /// taken (see book_snapshot.h), without matching it or issuing callbacks.
+  /// The order goes behind those already restored at its price, so orders
+  /// must be restored in the order the book kept them.
+  /// @param order the order
+  /// @param price the price the order rested at
+  /// @param open_qty the open quantity of the order
+  /// @param conditions the conditions the order was accepted with
+  /// @param is_stop true if the order is waiting for its stop price
+  virtual void restore_order(const OrderPtr& order,
+                             Price price,
+                             Quantity open_qty,
+                             OrderConditions conditions,
+                             bool is_stop);
+
+  /// @brief restore the market price and book event sequence of a snapshot.
+  /// Unlike set_market_price() this does not trigger stop orders.
+  void restore_market(Price market_price, uint64_t event_sequence);
+
   /// @brief Set the current market price
   /// Intended to be used during initialization to establish the market
   /// price before this order book has generated any exceptions.
@@ -116,17 +190,30 @@ public:
   /// The market price is normally the price at which the last trade happened.
   Price market_price()const;
 
+  /// @brief Set the prices this security normally trades at.
+  /// Storage that supports it (TickLadderStorage) finds levels on the
+  /// band by array indexing.  Other prices still work, but are slower.
+  /// Must be called before any orders are added.
+  /// @throws std::runtime_error if the book is not empty
+  virtual void set_price_band(const PriceBand & band);
+
   /// @brief access the bids container
   const TrackerMap& bids() const { return bids_; };
 
   /// @brief access the asks container
   const TrackerMap& asks() const { return asks_; };
 
-  /// @brief access stop bid orders
-  const TrackerMap & stopBids() const { return stopBids_;}
+  /// @brief access the open quantity at each bid price
+  const Quantities & bidQuantities() const { return bidQuantities_; }
 
-  /// @brief access stop ask orders
-  const TrackerMap & stopAsks() const { return stopAsks_;}
+  /// @brief access the open quantity at each ask price
+  const Quantities & askQuantities() const { return askQuantities_; }
+
+  /// @brief access stop bid orders, lowest stop price first
+  const StopMap & stopBids() const { return stopBids_;}
+
+  /// @brief access stop ask orders, highest stop price first
+  const StopMap & stopAsks() const { return stopAsks_;}
 
   /// @brief move callbacks to another thread's container
   /// @deprecated  This doesn't do anything now
@@ -142,6 +229,24 @@ public:
   std::ostream & log(std::ostream & out) const;
 
 protected:
+  /// @brief the class whose methods handle callbacks
+  typedef typename std::conditional<std::is_void<Derived>::value,
+    OrderBook, Derived>::type Self;
+
+  /// @brief access this book as the class that handles its callbacks
+  Self & self() { return static_cast<Self &>(*this); }
+
+  /// @brief what order_of returns: the handle itself when handles are
+  /// orders, otherwise a copy of the book's pointer, since a listener that
+  /// re-enters the book can move or drop the slot the book keeps it in.
+  typedef typename std::conditional<
+    std::is_same<OrderHandle, OrderPtr>::value,
+    const OrderPtr &, OrderPtr>::type CallbackOrder;
+
+  /// @brief note that the book changed.  Outside a batch this queues a
+  /// book update callback; inside one the update waits for the batch end.
+  void book_updated();
+
   /// @brief Internal method to process callbacks.
   /// Protected against recursive calls in case callbacks
   /// issue new requests. 
@@ -150,6 +255,10 @@ protected:
   /// @brief perform an individual callback
   virtual void perform_callback(TypedCallback& cb);
 
+  /// @brief the order a callback handle refers to.
+  /// The handle is valid until the callback has been performed.
+  CallbackOrder order_of(const OrderHandle & handle);
+
   /// @brief match a new order to current orders
   /// @param inbound_order the inbound order
   /// @param inbound_price price of the inbound order
@@ -197,6 +306,30 @@ protected:
                     Tracker& current_tracker,
                     Quantity max_quantity = QUANTITY_MAX);
 
+  /// @brief add a tracker to one of the book's containers and index it.
+  /// @return the position of the new entry
+  template <class T>
+  typename TrackerMap::iterator insert_tracker(
+    TrackerMap & trackers,
+    const ComparablePrice & key,
+    T && tracker);
+
+  /// @brief add a tracker to one of the book's containers and index it,
+  ///        without recording a book event.
+  /// @return the position of the new entry
+  template <class T>
+  typename TrackerMap::iterator place_tracker(
+    TrackerMap & trackers,
+    const ComparablePrice & key,
+    T && tracker);
+
+  /// @brief remove a tracker from one of the book's containers
+  ///        and from the index.
+  /// @return the position following the erased entry
+  typename TrackerMap::iterator erase_tracker(
+    TrackerMap & trackers,
+    typename TrackerMap::iterator pos);
+
   /// @brief find an order in a container
   /// @param order is the the order we are looking for
   /// @param[OUT] result will point to the entry in the container if we find a match
@@ -207,10 +340,38 @@ protected:
 
   /// @brief find stop order in a container.
   /// @param order is the the stop order we are looking for
-  /// @param[OUT] result will point to the entry in the container if we find a match
+  /// @param[OUT] result will be the order's slot in the stop book if we find a match
   /// @returns true: match, false: no match
   bool find_in_stop_orders(
     const OrderPtr& order,
+    typename StopMap::Slot& result);
+
+  /// @brief add a tracker to one of the stop books and index it.
+  template <class T>
+  void insert_stop(
+    StopMap & stops,
+    const ComparablePrice & key,
+    T && tracker);
+
+  /// @brief remove a tracker from one of the stop books
+  ///        and from the index.
+  void erase_stop(StopMap & stops, typename StopMap::Slot slot);
+
+  /// @brief remove an order that is leaving the book from the index.
+  void unindex(OrderPtr & order);
+
+  /// @brief the open quantities of bids_ or asks_
+  Quantities & quantities_of(const TrackerMap & trackers);
+
+  /// @brief the key a resting order is filed under
+  static ComparablePrice key_of(const Tracker & tracker);
+
+  /// @brief look up an order in the index.
+  /// @param trackers the container the order is expected to be in
+  /// @param[OUT] result the entry, or trackers.end() if it is not there
+  bool find_indexed(
+    const OrderPtr& order,
+    TrackerMap & trackers,
     typename TrackerMap::iterator& result);
 
   /// @brief add incoming stop order to stops colletion unless it's already
@@ -219,7 +380,7 @@ protected:
   bool add_stop_order(Tracker & tracker);
 
   /// @brief See if any stop orders should go on the market.
-  void check_stop_orders(bool side, Price price, TrackerMap & stops);
+  void check_stop_orders(bool side, Price price, StopMap & stops);
 
   /// @brief accept pending (formerly stop) orders.
   void submit_pending_orders();
@@ -292,67 +453,192 @@ protected:
 
 
 private:
+    /// @brief where the index finds an order.
+    struct OrderLocation {
+      OrderLocation()
+        : trackers(nullptr)
+        , stops(nullptr)
+        , slot(0)
+      {
+      }
+
+      OrderLocation(TrackerMap * container, typename TrackerMap::iterator pos)
+        : trackers(container)
+        , position(pos)
+        , stops(nullptr)
+        , slot(0)
+      {
+      }
+
+      OrderLocation(StopMap * container, typename StopMap::Slot stop)
+        : trackers(nullptr)
+        , stops(container)
+        , slot(stop)
+      {
+      }
+
+      explicit OrderLocation(size_t held)
+        : trackers(nullptr)
+        , stops(nullptr)
+        , slot(held)
+      {
+      }
+
+      /// @brief has the order left the book?
+      bool retired() const
+      {
+        return trackers == nullptr && stops == nullptr;
+      }
+
+      TrackerMap * trackers;  // the side the order rests on, if any
+      typename TrackerMap::iterator position;
+      StopMap * stops;        // the stop book the order waits in, if any
+      size_t slot;            // its slot in stops, or in retired_
+    };
+
+    /// @brief callback handles are the orders themselves, so the book
+    /// never has to hold orders for its callbacks.
+    typedef std::is_same<OrderHandle, OrderPtr> HandleIsOrder;
+
+    /// @brief keep an order that has left the book until callbacks
+    /// have been performed.
+    /// @param order the order's handle
+    /// @param source moved into retired_
+    void retire(OrderHandle order, OrderPtr & source);
+    /// @brief keep an order that may not be in the book until callbacks
+    /// have been performed.
+    /// @param order the order
+    /// @param source moved from if the book must keep the order
+    void hold_order(const OrderPtr & order, OrderPtr & source);
+    void hold_order(const OrderPtr & order);
+    /// @brief forget the orders kept for callbacks
+    void release_orders();
+    const OrderPtr & order_of(const OrderHandle & handle, std::true_type);
+    OrderPtr order_of(const OrderHandle & handle, std::false_type);
+
+    /// @brief note a change to a resting order for the market by
+    /// order listener, if there is one
+    void record_event(typename TypedBookEvent::EventType type,
+                      const Tracker & tracker,
+                      Price price,
+                      Quantity quantity,
+                      Quantity open_qty);
+    /// @brief is the order resting in bids_ or asks_?
+    bool is_resting(const Tracker & tracker) const;
+    /// @brief give queued book events to the market by order listener
+    void publish_book_events();
+    /// @brief report an exception thrown by a callback
+    void callback_failed(const std::exception * ex);
+
     bool submit_order(Tracker & inbound);
     bool add_order(Tracker& order_tracker, Price order_price);
+    /// @brief finish a batch, publishing the book change if there was one
+    void end_batch();
 private:
 
   std::string symbol_;
   TrackerMap bids_;
   TrackerMap asks_;
+  // the open quantity of the orders in bids_ and asks_
+  Quantities bidQuantities_;
+  Quantities askQuantities_;
 
-  TrackerMap stopBids_;
-  TrackerMap stopAsks_;
+  StopMap stopBids_;
+  StopMap stopAsks_;
   TrackerVec pendingOrders_;
+  // Scratch space for matching, kept between calls so that matching
+  // does not allocate once these have grown to the book's working size.
+  DeferredMatches deferredAons_;    // add_order
+  DeferredMatches ignoredAons_;     // check_deferred_aons
+  DeferredMatches deferredMatches_; // match_aon_order
+  std::vector<Quantity> fills_;     // try_create_deferred_trades
+  // every order in bids_, asks_, stopBids_ and stopAsks_, and every
+  // order in retired_
+  OrderIndex<OrderLocation> index_;
+  // orders that left the book while callbacks could still refer to them
+  std::vector<OrderPtr> retired_;
 
   Callbacks callbacks_;
   Callbacks workingCallbacks_;
+  BookEvents bookEvents_;
+  BookEvents workingBookEvents_;
+  uint64_t eventSequence_;
+  // the order being replaced, while it is matched again
+  OrderHandle replacing_;
   bool handling_callbacks_;
+  bool batching_;
+  bool batch_updated_;
   TypedOrderListener* order_listener_;
   TypedTradeListener* trade_listener_;
   TypedOrderBookListener* order_book_listener_;
+  TypedMarketByOrderListener* market_by_order_listener_;
   Logger * logger_;
+  TypedEventRing* event_ring_;
   Price marketPrice_;
 };
 
-template <class OrderPtr>
-OrderBook<OrderPtr>::OrderBook(const std::string & symbol)
+template <class OrderPtr, class Storage, class Derived>
+OrderBook<OrderPtr, Storage, Derived>::OrderBook(const std::string & symbol)
 : symbol_(symbol),
+  eventSequence_(0),
+  replacing_(nullptr),
   handling_callbacks_(false),
+  batching_(false),
+  batch_updated_(false),
   order_listener_(nullptr),
   trade_listener_(nullptr),
   order_book_listener_(nullptr),
+  market_by_order_listener_(nullptr),
   logger_(nullptr),
+  event_ring_(nullptr),
   marketPrice_(MARKET_ORDER_PRICE)
 {
   callbacks_.reserve(16);  // Why 16?  Why not?  
   workingCallbacks_.reserve(callbacks_.capacity());
+  deferredAons_.reserve(16);
+  ignoredAons_.reserve(16);
+  deferredMatches_.reserve(16);
+  fills_.reserve(16);
+  retired_.reserve(16);
+  bookEvents_.reserve(16);
+  workingBookEvents_.reserve(bookEvents_.capacity());
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 void
-OrderBook<OrderPtr>::set_logger(Logger * logger)
+OrderBook<OrderPtr, Storage, Derived>::set_logger(Logger * logger)
 {
   logger_ = logger;
 }
 
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::set_event_ring(TypedEventRing* ring)
+{
+  static_assert(HandleIsOrder::value,
+    "an event ring needs a book whose order handles are the orders, "
+    "otherwise queued events outlive the orders they refer to");
+  event_ring_ = ring;
+}
+
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 void 
-OrderBook<OrderPtr>::set_symbol(const std::string & symbol)
+OrderBook<OrderPtr, Storage, Derived>::set_symbol(const std::string & symbol)
 {
     symbol_ = symbol;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 const std::string &
-OrderBook<OrderPtr>::symbol() const
+OrderBook<OrderPtr, Storage, Derived>::symbol() const
 {
     return symbol_;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 void
-OrderBook<OrderPtr>:: set_market_price(Price price)
+OrderBook<OrderPtr, Storage, Derived>:: set_market_price(Price price)
 {
   Price oldMarketPrice = marketPrice_;
   marketPrice_ = price;
@@ -372,48 +658,81 @@ OrderBook<OrderPtr>:: set_market_price(Price price)
 
 /// @brief Get current market price.
 /// The market price is normally the price at which the last trade happened.
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 Price
-OrderBook<OrderPtr>::market_price() const
+OrderBook<OrderPtr, Storage, Derived>::market_price() const
 {
   return marketPrice_;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::set_price_band(const PriceBand & band)
+{
+  if(!bids_.empty() || !asks_.empty() ||
+    !stopBids_.empty() || !stopAsks_.empty())
+  {
+    throw std::runtime_error("Price band can only be set on an empty book");
+  }
+  configure_price_band(bids_, true, band);
+  configure_price_band(asks_, false, band);
+  configure_price_band(bidQuantities_, true, band);
+  configure_price_band(askQuantities_, false, band);
+  configure_price_band(stopBids_, false, band);
+  configure_price_band(stopAsks_, true, band);
+}
+
+template <class OrderPtr, class Storage, class Derived>
 void
-OrderBook<OrderPtr>::set_order_listener(TypedOrderListener* listener)
+OrderBook<OrderPtr, Storage, Derived>::set_order_listener(TypedOrderListener* listener)
 {
   order_listener_ = listener;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 void
-OrderBook<OrderPtr>::set_trade_listener(TypedTradeListener* listener)
+OrderBook<OrderPtr, Storage, Derived>::set_trade_listener(TypedTradeListener* listener)
 {
   trade_listener_ = listener;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 void
-OrderBook<OrderPtr>::set_order_book_listener(TypedOrderBookListener* listener)
+OrderBook<OrderPtr, Storage, Derived>::set_order_book_listener(TypedOrderBookListener* listener)
 {
   order_book_listener_ = listener;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::set_market_by_order_listener(
+  TypedMarketByOrderListener* listener)
+{
+  market_by_order_listener_ = listener;
+}
+
+template <class OrderPtr, class Storage, class Derived>
+uint64_t
+OrderBook<OrderPtr, Storage, Derived>::event_sequence() const
+{
+  return eventSequence_;
+}
+
+template <class OrderPtr, class Storage, class Derived>
 bool
-OrderBook<OrderPtr>::add(const OrderPtr& order, OrderConditions conditions)
+OrderBook<OrderPtr, Storage, Derived>::add(const OrderPtr& order, OrderConditions conditions)
 {
   bool matched = false;
 
   // If the order is invalid, ignore it
   if (order->order_qty() == 0) {
     callbacks_.push_back(TypedCallback::reject(order, "size must be positive"));
+    hold_order(order);
   }
   else 
   {
     Tracker inbound(order, conditions);
-    if(inbound.ptr()->stop_price() != 0 && add_stop_order(inbound))
+    if(inbound.stop_price() != 0 && add_stop_order(inbound))
     {
       // The order has been added to stops
       callbacks_.push_back(TypedCallback::accept_stop(order));
@@ -439,15 +758,17 @@ OrderBook<OrderPtr>::add(const OrderPtr& order, OrderConditions conditions)
     {
       submit_pending_orders();
     }
-    callbacks_.push_back(TypedCallback::book_update(this));
+    book_updated();
+    // the callbacks refer to the order even if it did not rest
+    hold_order(order, inbound.ptr());
   }
   callback_now();
   return matched;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 void
-OrderBook<OrderPtr>::cancel(const OrderPtr& order)
+OrderBook<OrderPtr, Storage, Derived>::cancel(const OrderPtr& order)
 {
   bool found = false;
   bool foundStop = false;
@@ -458,14 +779,16 @@ OrderBook<OrderPtr>::cancel(const OrderPtr& order)
     find_on_market(order, bid);
     if (bid != bids_.end()) {
       open_qty = bid->second.open_qty();
+      record_event(TypedBookEvent::be_delete, bid->second,
+        bid->second.price(), open_qty, 0);
       // Remove from container for cancel
-      bids_.erase(bid);
+      erase_tracker(bids_, bid);
       found = true;
     }
     else if (order->stop_price()) {
-      find_in_stop_orders(order, bid);
-      if (bid != stopBids_.end()) {
-        stopBids_.erase(bid);
+      typename StopMap::Slot stop;
+      if (find_in_stop_orders(order, stop)) {
+        erase_stop(stopBids_, stop);
         foundStop = true;
       }
     }
@@ -475,14 +798,16 @@ OrderBook<OrderPtr>::cancel(const OrderPtr& order)
     find_on_market(order, ask);
     if (ask != asks_.end()) {
       open_qty = ask->second.open_qty();
+      record_event(TypedBookEvent::be_delete, ask->second,
+        ask->second.price(), open_qty, 0);
       // Remove from container for cancel
-      asks_.erase(ask);
+      erase_tracker(asks_, ask);
       found = true;
     }
     else if (order->stop_price()) {
-      find_in_stop_orders(order, ask);
-      if (ask != stopAsks_.end()) {
-        stopAsks_.erase(ask);
+      typename StopMap::Slot stop;
+      if (find_in_stop_orders(order, stop)) {
+        erase_stop(stopAsks_, stop);
         foundStop = true;
       }
     }
@@ -490,30 +815,27 @@ OrderBook<OrderPtr>::cancel(const OrderPtr& order)
   // If the cancel was found, issue callback
   if (found) {
     callbacks_.push_back(TypedCallback::cancel(order, open_qty));
-    callbacks_.push_back(TypedCallback::book_update(this));
+    book_updated();
   }
   else if (foundStop) {
     callbacks_.push_back(TypedCallback::cancel_stop(order));
-    callbacks_.push_back(TypedCallback::book_update(this));
+    book_updated();
   }
   else {
     callbacks_.push_back(TypedCallback::cancel_reject(order, "not found"));
+    hold_order(order);
   }
   callback_now();
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 bool
-OrderBook<OrderPtr>::replace(
+OrderBook<OrderPtr, Storage, Derived>::replace(
   const OrderPtr& order, 
   int64_t size_delta,
   Price new_price)
 {
   bool matched = false;
-  bool price_change = new_price && (new_price != order->price());
-
-  Price price = (new_price == PRICE_UNCHANGED) ? order->price() : new_price;
-
   // If the order to replace is a buy order
   TrackerMap & market = order->is_buy() ? bids_ : asks_;
   typename TrackerMap::iterator pos;
@@ -521,6 +843,7 @@ OrderBook<OrderPtr>::replace(
   {
     // If this is a valid replace
     const Tracker& tracker = pos->second;
+    Price price = (new_price == PRICE_UNCHANGED) ? tracker.price() : new_price;
     // If there is not enough open quantity for the size reduction
     if (size_delta < 0 && ((int)tracker.open_qty() < -size_delta)) 
     {
@@ -540,22 +863,45 @@ OrderBook<OrderPtr>::replace(
     callbacks_.push_back(
         TypedCallback::replace(order, pos->second.open_qty(), size_delta, 
                                 price));
-    Quantity new_open_qty = pos->second.open_qty() + size_delta;
+    Quantity old_open_qty = pos->second.open_qty();
+    Quantity new_open_qty = old_open_qty + size_delta;
+    Quantities & quantities = quantities_of(market);
+    if(size_delta < 0)
+    {
+      quantities.remove(pos->first, Quantity(-size_delta));
+    }
+    else
+    {
+      quantities.add(pos->first, Quantity(size_delta));
+    }
     pos->second.change_qty(size_delta);  // Update my copy
     // If the size change will close the order
     if (!new_open_qty) 
     {
       // Cancel with NO open qty (should be zero after replace)
       callbacks_.push_back(TypedCallback::cancel(order, 0));
-      market.erase(pos); // Remove order
+      record_event(TypedBookEvent::be_delete, pos->second,
+        pos->second.price(), old_open_qty, 0);
+      erase_tracker(market, pos); // Remove order
     } 
     else 
     {
       // Else rematch the new order - there could be a price change
       // or size change - that could cause all or none match
       auto order = pos->second;
-      market.erase(pos); // Remove old order order
+      Price old_price = order.price();
+      order.set_price(price);
+      erase_tracker(market, pos); // Remove old order order
+      // if the order rests again it is reported as modified
+      replacing_ = TypedCallback::handle(order.ptr());
       matched = add_order(order, price); // Add order
+      if(replacing_ != nullptr)
+      {
+        // it traded away without resting again
+        replacing_ = nullptr;
+        record_event(TypedBookEvent::be_delete, order,
+          old_price, old_open_qty, 0);
+      }
     }
     // If replace any order this order triggered any trades
     // which triggered any stops
@@ -564,61 +910,173 @@ OrderBook<OrderPtr>::replace(
     {
       submit_pending_orders();
     }
-    callbacks_.push_back(TypedCallback::book_update(this));
+    book_updated();
   }
   else
   {
     // not found
     callbacks_.push_back(
           TypedCallback::replace_reject(order, "not found"));
+    hold_order(order);
   }
   callback_now();
   return matched;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
+bool
+OrderBook<OrderPtr, Storage, Derived>::apply_batch(
+  const TypedCommand* commands,
+  size_t count)
+{
+  // a batch applied from a callback joins the batch in progress
+  bool outer = !batching_;
+  batching_ = true;
+  bool matched = false;
+  try
+  {
+    for(size_t index = 0; index < count; ++index)
+    {
+      const TypedCommand & command = commands[index];
+      switch(command.type)
+      {
+        case TypedCommand::cmd_add:
+          matched |= add(command.order, command.conditions);
+          break;
+        case TypedCommand::cmd_cancel:
+          cancel(command.order);
+          break;
+        case TypedCommand::cmd_replace:
+          matched |= replace(command.order, command.size_delta, command.price);
+          break;
+        default:
+        {
+          std::stringstream msg;
+          msg << "Unexpected command type " << command.type;
+          throw std::runtime_error(msg.str());
+        }
+      }
+    }
+  }
+  catch(...)
+  {
+    if(outer)
+    {
+      // publish whatever the earlier commands changed
+      end_batch();
+    }
+    throw;
+  }
+  if(outer)
+  {
+    end_batch();
+  }
+  return matched;
+}
+
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::end_batch()
+{
+  batching_ = false;
+  if(batch_updated_)
+  {
+    batch_updated_ = false;
+    book_updated();
+    callback_now();
+  }
+}
+
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::book_updated()
+{
+  if(batching_)
+  {
+    batch_updated_ = true;
+  }
+  else
+  {
+    callbacks_.push_back(TypedCallback::book_update());
+  }
+}
+
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::restore_order(
+  const OrderPtr& order,
+  Price price,
+  Quantity open_qty,
+  OrderConditions conditions,
+  bool is_stop)
+{
+  Tracker tracker(order, conditions);
+  tracker.set_price(price);
+  // The order may have been filled or replaced since it was accepted
+  tracker.change_qty(int64_t(open_qty) - int64_t(tracker.open_qty()));
+  bool isBuy = tracker.is_buy();
+  if(is_stop)
+  {
+    ComparablePrice trigger(!isBuy, tracker.stop_price());
+    insert_stop(isBuy ? stopBids_ : stopAsks_, trigger, std::move(tracker));
+  }
+  else
+  {
+    ComparablePrice key = key_of(tracker);
+    place_tracker(isBuy ? bids_ : asks_, key, std::move(tracker));
+  }
+}
+
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::restore_market(
+  Price market_price,
+  uint64_t event_sequence)
+{
+  marketPrice_ = market_price;
+  eventSequence_ = event_sequence;
+}
+
+template <class OrderPtr, class Storage, class Derived>
 bool
-OrderBook<OrderPtr>::add_stop_order(Tracker & tracker)
+OrderBook<OrderPtr, Storage, Derived>::add_stop_order(Tracker & tracker)
 {
-  bool isBuy = tracker.ptr()->is_buy();
-  ComparablePrice key(isBuy, tracker.ptr()->stop_price());
+  bool isBuy = tracker.is_buy();
+  Price stopPrice = tracker.stop_price();
   // if the market price is a better deal then the stop price, it's not time to panic
-  bool isStopped = key < marketPrice_;
+  bool isStopped = ComparablePrice(isBuy, stopPrice) < marketPrice_;
   if(isStopped)
   {
+    // stops are keyed so the first to be triggered comes first
+    ComparablePrice trigger(!isBuy, stopPrice);
     if(isBuy)
     {
-      stopBids_.emplace(key, std::move(tracker));
+      insert_stop(stopBids_, trigger, std::move(tracker));
     }
     else
     {
-      stopAsks_.emplace(key, std::move(tracker));
+      insert_stop(stopAsks_, trigger, std::move(tracker));
     }
   }
   return isStopped;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 void
-OrderBook<OrderPtr>::check_stop_orders(bool side, Price price, TrackerMap & stops)
+OrderBook<OrderPtr, Storage, Derived>::check_stop_orders(bool side, Price price, StopMap & stops)
 {
-  ComparablePrice until(side, price);
-  auto pos = stops.begin(); 
-  while(pos != stops.end())
+  ComparablePrice until(!side, price);
+  stops.release(until, [this](Tracker & tracker)
   {
-    auto here = pos++;
-    if(until > here->first)
-    {
-      break;
-    }
-    pendingOrders_.push_back(std::move(here->second));
-    stops.erase(here);
-  }
+    // copy rather than move: unindex needs the order
+    pendingOrders_.push_back(tracker);
+    unindex(tracker.ptr());
+  });
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 void
-OrderBook<OrderPtr>::submit_pending_orders()
+OrderBook<OrderPtr, Storage, Derived>::submit_pending_orders()
 {
   TrackerVec pending;
   pending.swap(pendingOrders_);
@@ -630,60 +1088,239 @@ OrderBook<OrderPtr>::submit_pending_orders()
   }
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 bool
-OrderBook<OrderPtr>::submit_order(Tracker & inbound)
+OrderBook<OrderPtr, Storage, Derived>::submit_order(Tracker & inbound)
 {
-  Price order_price = inbound.ptr()->price();
+  Price order_price = inbound.price();
   return add_order(inbound, order_price);
 }
 
-template <class OrderPtr>
-bool
-OrderBook<OrderPtr>::find_on_market(
-  const OrderPtr& order,
-  typename TrackerMap::iterator& result)
+template <class OrderPtr, class Storage, class Derived>
+template <class T>
+typename OrderBook<OrderPtr, Storage, Derived>::TrackerMap::iterator
+OrderBook<OrderPtr, Storage, Derived>::insert_tracker(
+  TrackerMap & trackers,
+  const ComparablePrice & key,
+  T && tracker)
 {
-  const ComparablePrice key(order->is_buy(), order->price());
-  TrackerMap & sideMap = order->is_buy() ? bids_ : asks_;
+  if(&*tracker.ptr() == replacing_)
+  {
+    replacing_ = nullptr;
+    record_event(TypedBookEvent::be_modify, tracker, tracker.price(),
+      tracker.open_qty(), tracker.open_qty());
+  }
+  else
+  {
+    record_event(TypedBookEvent::be_add, tracker, tracker.price(),
+      tracker.open_qty(), tracker.open_qty());
+  }
+  return place_tracker(trackers, key, std::forward<T>(tracker));
+}
 
-  for (result = sideMap.find(key); result != sideMap.end(); ++result) {
-    // If this is the correct bid
-    if (result->second.ptr() == order) 
-    {
-      return true;
-    } 
-    else if (key < result->first) 
+template <class OrderPtr, class Storage, class Derived>
+template <class T>
+typename OrderBook<OrderPtr, Storage, Derived>::TrackerMap::iterator
+OrderBook<OrderPtr, Storage, Derived>::place_tracker(
+  TrackerMap & trackers,
+  const ComparablePrice & key,
+  T && tracker)
+{
+  const void * order = &*tracker.ptr();
+  quantities_of(trackers).add(key, tracker.open_qty());
+  typename TrackerMap::iterator pos =
+    trackers.emplace(key, std::forward<T>(tracker));
+  index_.insert(order, OrderLocation(&trackers, pos));
+  return pos;
+}
+
+template <class OrderPtr, class Storage, class Derived>
+typename OrderBook<OrderPtr, Storage, Derived>::TrackerMap::iterator
+OrderBook<OrderPtr, Storage, Derived>::erase_tracker(
+  TrackerMap & trackers,
+  typename TrackerMap::iterator pos)
+{
+  quantities_of(trackers).remove(pos->first, pos->second.open_qty());
+  unindex(pos->second.ptr());
+  return trackers.erase(pos);
+}
+
+template <class OrderPtr, class Storage, class Derived>
+typename OrderBook<OrderPtr, Storage, Derived>::Quantities &
+OrderBook<OrderPtr, Storage, Derived>::quantities_of(const TrackerMap & trackers)
+{
+  return &trackers == &bids_ ? bidQuantities_ : askQuantities_;
+}
+
+template <class OrderPtr, class Storage, class Derived>
+ComparablePrice
+OrderBook<OrderPtr, Storage, Derived>::key_of(const Tracker & tracker)
+{
+  return ComparablePrice(tracker.is_buy(), tracker.price());
+}
+
+template <class OrderPtr, class Storage, class Derived>
+template <class T>
+void
+OrderBook<OrderPtr, Storage, Derived>::insert_stop(
+  StopMap & stops,
+  const ComparablePrice & key,
+  T && tracker)
+{
+  const void * order = &*tracker.ptr();
+  typename StopMap::Slot slot = stops.insert(key, std::forward<T>(tracker));
+  index_.insert(order, OrderLocation(&stops, slot));
+}
+
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::erase_stop(
+  StopMap & stops,
+  typename StopMap::Slot slot)
+{
+  unindex(stops.at(slot).second.ptr());
+  stops.erase(slot);
+}
+
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::unindex(OrderPtr & order)
+{
+  if(HandleIsOrder::value)
+  {
+    index_.erase(&*order);
+  }
+  else
+  {
+    retire(&*order, order);
+  }
+}
+
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::retire(
+  OrderHandle order,
+  OrderPtr & source)
+{
+  index_.insert(order, OrderLocation(retired_.size()));
+  retired_.push_back(std::move(source));
+}
+
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::hold_order(
+  const OrderPtr & order,
+  OrderPtr & source)
+{
+  if(!HandleIsOrder::value && index_.find(&*order) == nullptr)
+  {
+    retire(&*order, source);
+  }
+}
+
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::hold_order(const OrderPtr & order)
+{
+  if(!HandleIsOrder::value)
+  {
+    OrderPtr copy(order);
+    hold_order(order, copy);
+  }
+}
+
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::release_orders()
+{
+  for(auto order = retired_.begin(); order != retired_.end(); ++order)
+  {
+    // unless the order has since gone back into the book
+    const OrderLocation * location = index_.find(&**order);
+    if(location != nullptr && location->retired())
     {
-      // exit early if result is beyond the matching prices
-      result = sideMap.end();
-      return false;
+      index_.erase(&**order);
     }
   }
+  retired_.clear();
+}
+
+template <class OrderPtr, class Storage, class Derived>
+typename OrderBook<OrderPtr, Storage, Derived>::CallbackOrder
+OrderBook<OrderPtr, Storage, Derived>::order_of(const OrderHandle & handle)
+{
+  return order_of(handle, HandleIsOrder());
+}
+
+template <class OrderPtr, class Storage, class Derived>
+const OrderPtr &
+OrderBook<OrderPtr, Storage, Derived>::order_of(
+  const OrderHandle & handle,
+  std::true_type)
+{
+  return handle;
+}
+
+template <class OrderPtr, class Storage, class Derived>
+OrderPtr
+OrderBook<OrderPtr, Storage, Derived>::order_of(
+  const OrderHandle & handle,
+  std::false_type)
+{
+  const OrderLocation * location = index_.find(handle);
+  if(location == nullptr)
+  {
+    throw std::runtime_error("Callback refers to an order the book does not hold");
+  }
+  if(location->stops != nullptr)
+  {
+    return location->stops->at(location->slot).second.ptr();
+  }
+  if(location->trackers == nullptr)
+  {
+    return retired_[location->slot];
+  }
+  return location->position->second.ptr();
+}
+
+template <class OrderPtr, class Storage, class Derived>
+bool
+OrderBook<OrderPtr, Storage, Derived>::find_indexed(
+  const OrderPtr& order,
+  TrackerMap & trackers,
+  typename TrackerMap::iterator& result)
+{
+  const OrderLocation * location = index_.find(&*order);
+  if(location != nullptr && location->trackers == &trackers)
+  {
+    result = location->position;
+    return true;
+  }
+  result = trackers.end();
   return false;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 bool
-OrderBook<OrderPtr>::find_in_stop_orders(
+OrderBook<OrderPtr, Storage, Derived>::find_on_market(
   const OrderPtr& order,
   typename TrackerMap::iterator& result)
 {
-  const ComparablePrice key(order->is_buy(), order->stop_price());
-  TrackerMap & sideMap = order->is_buy() ? stopBids_ : stopAsks_;
+  return find_indexed(order, order->is_buy() ? bids_ : asks_, result);
+}
 
-  for (result = sideMap.find(key); result != sideMap.end(); ++result) {
-    // If this is the correct bid
-    if (result->second.ptr() == order)
-    {
-      return true;
-    }
-    else if (key < result->first)
-    {
-      // exit early if result is beyond the matching prices
-      result = sideMap.end();
-      return false;
-    }
+template <class OrderPtr, class Storage, class Derived>
+bool
+OrderBook<OrderPtr, Storage, Derived>::find_in_stop_orders(
+  const OrderPtr& order,
+  typename StopMap::Slot& result)
+{
+  const OrderLocation * location = index_.find(&*order);
+  if(location != nullptr &&
+    location->stops == (order->is_buy() ? &stopBids_ : &stopAsks_))
+  {
+    result = location->slot;
+    return true;
   }
   return false;
 }
@@ -691,15 +1328,15 @@ OrderBook<OrderPtr>::find_in_stop_orders(
 // Try to match order.  Generate trades.
 // If not completely filled and not IOC,
 // add the order to the order book
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 bool
-OrderBook<OrderPtr>::add_order(Tracker& inbound, Price order_price)
+OrderBook<OrderPtr, Storage, Derived>::add_order(Tracker& inbound, Price order_price)
 {
   bool matched = false;
-  OrderPtr& order = inbound.ptr();
-  DeferredMatches deferred_aons;
+  DeferredMatches & deferred_aons = deferredAons_;
+  deferred_aons.clear();
   // Try to match with current orders
-  if (order->is_buy()) {
+  if (inbound.is_buy()) {
     matched = match_order(inbound, order_price, asks_, deferred_aons);
   } else {
     matched = match_order(inbound, order_price, bids_, deferred_aons);
@@ -708,10 +1345,10 @@ OrderBook<OrderPtr>::add_order(Tracker& inbound, Price order_price)
   // If order has remaining open quantity and is not immediate or cancel
   if (inbound.open_qty() && !inbound.immediate_or_cancel()) {
     // If this is a buy order
-    if (order->is_buy()) 
+    if (inbound.is_buy()) 
     {
       // Insert into bids
-      bids_.insert(std::make_pair(ComparablePrice(true, order_price), inbound));
+      insert_tracker(bids_, ComparablePrice(true, order_price), inbound);
       // and see if that satisfies any ask orders
       if(check_deferred_aons(deferred_aons, asks_, bids_))
       {
@@ -722,7 +1359,7 @@ OrderBook<OrderPtr>::add_order(Tracker& inbound, Price order_price)
     {
       // Else this is a sell order
       // Insert into asks
-      asks_.insert(std::make_pair(ComparablePrice(false, order_price), inbound));
+      insert_tracker(asks_, ComparablePrice(false, order_price), inbound);
       if(check_deferred_aons(deferred_aons, bids_, asks_))
       {
         matched = true;
@@ -732,26 +1369,32 @@ OrderBook<OrderPtr>::add_order(Tracker& inbound, Price order_price)
   return matched;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 bool
-OrderBook<OrderPtr>::check_deferred_aons(DeferredMatches & aons, 
+OrderBook<OrderPtr, Storage, Derived>::check_deferred_aons(DeferredMatches & aons, 
   TrackerMap & deferredTrackers, 
   TrackerMap & marketTrackers)
 {
   bool result = false;
-  DeferredMatches ignoredAons;
+  DeferredMatches & ignoredAons = ignoredAons_;
 
   for(auto pos = aons.begin(); pos != aons.end(); ++pos)
   {
     auto entry = *pos;
     ComparablePrice current_price = entry->first;
     Tracker & tracker = entry->second;
+    ignoredAons.clear();
+    // While it is matching, the resting order does not count as open
+    // quantity on its own side.
+    Quantities & quantities = quantities_of(deferredTrackers);
+    quantities.remove(current_price, tracker.open_qty());
     bool matched = match_order(tracker, current_price.price(), 
       marketTrackers, ignoredAons);
+    quantities.add(current_price, tracker.open_qty());
     result |= matched;
     if(tracker.filled())
     {
-      deferredTrackers.erase(entry);
+      erase_tracker(deferredTrackers, entry);
     }
   }
   return result;
@@ -761,9 +1404,9 @@ OrderBook<OrderPtr>::check_deferred_aons(DeferredMatches & aons,
 ///  If successful
 ///    generate trade(s)
 ///    if any current order is complete, remove from 'current' orders
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 bool
-OrderBook<OrderPtr>::match_order(Tracker& inbound, 
+OrderBook<OrderPtr, Storage, Derived>::match_order(Tracker& inbound, 
   Price inbound_price, 
   TrackerMap& current_orders,
   DeferredMatches & deferred_aons)
@@ -775,9 +1418,9 @@ OrderBook<OrderPtr>::match_order(Tracker& inbound,
   return match_regular_order(inbound, inbound_price, current_orders, deferred_aons);
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 bool
-OrderBook<OrderPtr>::match_regular_order(Tracker& inbound, 
+OrderBook<OrderPtr, Storage, Derived>::match_regular_order(Tracker& inbound, 
   Price inbound_price, 
   TrackerMap& current_orders,
   DeferredMatches & deferred_aons)
@@ -818,7 +1461,7 @@ OrderBook<OrderPtr>::match_regular_order(Tracker& inbound,
         {
           matched = true;
           // assert traded == current_quantity
-          current_orders.erase(entry);
+          erase_tracker(current_orders, entry);
           inbound_qty -= traded;
         }
       }
@@ -838,7 +1481,7 @@ OrderBook<OrderPtr>::match_regular_order(Tracker& inbound,
         matched = true;
         if(current_order.filled())
         {
-          current_orders.erase(entry);
+          erase_tracker(current_orders, entry);
         }
         inbound_qty -= traded;
       }
@@ -847,9 +1490,9 @@ OrderBook<OrderPtr>::match_regular_order(Tracker& inbound,
   return matched;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 bool
-OrderBook<OrderPtr>::match_aon_order(Tracker& inbound, 
+OrderBook<OrderPtr, Storage, Derived>::match_aon_order(Tracker& inbound, 
   Price inbound_price, 
   TrackerMap& current_orders,
   DeferredMatches & deferred_aons)
@@ -858,7 +1501,19 @@ OrderBook<OrderPtr>::match_aon_order(Tracker& inbound,
   Quantity inbound_qty = inbound.open_qty();
   Quantity deferred_qty = 0;
 
-  DeferredMatches deferred_matches;
+  // A fill or kill order that cannot be filled from the open quantity at
+  // matching prices is cancelled without looking at the orders.  Other
+  // AON orders walk the book anyway, to find AON orders they could fill
+  // once they rest.
+  if(inbound.immediate_or_cancel() &&
+    quantities_of(current_orders).available(inbound_price, inbound_qty) <
+      inbound_qty)
+  {
+    return false;
+  }
+
+  DeferredMatches & deferred_matches = deferredMatches_;
+  deferred_matches.clear();
 
   typename TrackerMap::iterator pos = current_orders.begin(); 
   while(pos != current_orders.end() && !inbound.filled()) 
@@ -905,7 +1560,7 @@ OrderBook<OrderPtr>::match_aon_order(Tracker& inbound,
               // assert traded == current_quantity
               inbound_qty -= traded;
               matched = true;
-              current_orders.erase(entry);
+              erase_tracker(current_orders, entry);
             }
           }
         }
@@ -946,7 +1601,7 @@ OrderBook<OrderPtr>::match_aon_order(Tracker& inbound,
           }
           if(current_order.filled())
           {
-            current_orders.erase(entry);
+            erase_tracker(current_orders, entry);
           }
         }
       }
@@ -965,9 +1620,9 @@ namespace {
   const size_t AON_LIMIT = 5;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 Quantity
-OrderBook<OrderPtr>::try_create_deferred_trades(
+OrderBook<OrderPtr, Storage, Derived>::try_create_deferred_trades(
   Tracker& inbound,
   DeferredMatches & deferred_matches, 
   Quantity maxQty, // do not exceed
@@ -976,8 +1631,8 @@ OrderBook<OrderPtr>::try_create_deferred_trades(
 {
   Quantity traded = 0;
   // create a vector of proposed trade quantities:
-  std::vector<int> fills(deferred_matches.size());
-  std::fill(fills.begin(), fills.end(), 0);
+  std::vector<Quantity> & fills = fills_;
+  fills.assign(deferred_matches.size(), 0);
   Quantity foundQty = 0;
   auto pos = deferred_matches.begin(); 
   for(size_t index = 0;
@@ -1017,23 +1672,23 @@ OrderBook<OrderPtr>::try_create_deferred_trades(
       traded += create_trade(inbound, tracker, fills[index]);
       if(tracker.filled())
       {
-        current_orders.erase(entry);
+        erase_tracker(current_orders, entry);
       }
     }
   }
   return traded;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 Quantity
-OrderBook<OrderPtr>::create_trade(Tracker& inbound_tracker, 
+OrderBook<OrderPtr, Storage, Derived>::create_trade(Tracker& inbound_tracker, 
                                   Tracker& current_tracker,
                                   Quantity maxQuantity)
 {
-  Price cross_price = current_tracker.ptr()->price();
+  Price cross_price = current_tracker.price();
   // If current order is a market order, cross at inbound price
   if (MARKET_ORDER_PRICE == cross_price) {
-    cross_price = inbound_tracker.ptr()->price();
+    cross_price = inbound_tracker.price();
   }
   if(MARKET_ORDER_PRICE == cross_price)
   {
@@ -1052,6 +1707,20 @@ OrderBook<OrderPtr>::create_trade(Tracker& inbound_tracker,
   {
     inbound_tracker.fill(fill_qty);
     current_tracker.fill(fill_qty);
+    // the current order is always resting
+    quantities_of(current_tracker.is_buy() ? bids_ : asks_).remove(
+      key_of(current_tracker), fill_qty);
+    if(market_by_order_listener_)
+    {
+      // an AON order that was waiting for a match may be resting too
+      if(is_resting(inbound_tracker))
+      {
+        record_event(TypedBookEvent::be_execute, inbound_tracker,
+          cross_price, fill_qty, inbound_tracker.open_qty());
+      }
+      record_event(TypedBookEvent::be_execute, current_tracker,
+        cross_price, fill_qty, current_tracker.open_qty());
+    }
     set_market_price(cross_price);
 
     typename TypedCallback::FillFlags fill_flags = 
@@ -1074,26 +1743,57 @@ OrderBook<OrderPtr>::create_trade(Tracker& inbound_tracker,
   return fill_qty;
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::record_event(
+  typename TypedBookEvent::EventType type,
+  const Tracker & tracker,
+  Price price,
+  Quantity quantity,
+  Quantity open_qty)
+{
+  if(market_by_order_listener_)
+  {
+    TypedBookEvent event;
+    event.type = type;
+    event.sequence = ++eventSequence_;
+    event.order = TypedCallback::handle(tracker.ptr());
+    event.is_buy = tracker.is_buy();
+    event.price = price;
+    event.quantity = quantity;
+    event.open_qty = open_qty;
+    bookEvents_.push_back(event);
+  }
+}
+
+template <class OrderPtr, class Storage, class Derived>
+bool
+OrderBook<OrderPtr, Storage, Derived>::is_resting(const Tracker & tracker) const
+{
+  const OrderLocation * location = index_.find(&*tracker.ptr());
+  return location != nullptr && location->trackers != nullptr;
+}
+
+template <class OrderPtr, class Storage, class Derived>
 void
-OrderBook<OrderPtr>::move_callbacks(Callbacks& target)
+OrderBook<OrderPtr, Storage, Derived>::move_callbacks(Callbacks& target)
 {
   COMPLAIN_ONCE("Ignoring call to deprecated method: move_callbacks");
   // We get to decide when callbacks happen.
   // And it *certainly* doesn't happen on another thread!
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 void
-OrderBook<OrderPtr>::perform_callbacks()
+OrderBook<OrderPtr, Storage, Derived>::perform_callbacks()
 {
   COMPLAIN_ONCE("Ignoring call to deprecated method: perform_callbacks");
   // We get to decide when callbacks happen.
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 void
-OrderBook<OrderPtr>::callback_now()
+OrderBook<OrderPtr, Storage, Derived>::callback_now()
 {
   // protect against recursive calls
   // callbacks generated in response to previous callbacks
@@ -1103,48 +1803,102 @@ OrderBook<OrderPtr>::callback_now()
     handling_callbacks_ = true;
     // remove all accumulated callbacks in case
     // new callbacks are generated by the application code.
-    while(!callbacks_.empty())
+    while(!callbacks_.empty() || !bookEvents_.empty())
     {
+      // mirrors of the book are brought up to date first
+      publish_book_events();
       // if we needed more entries, be sure that both containers have them.
       workingCallbacks_.reserve(callbacks_.capacity());
       workingCallbacks_.swap(callbacks_);
       for (auto cb = workingCallbacks_.begin(); cb != workingCallbacks_.end(); ++cb) {
         try
         {
-          perform_callback(*cb);
+          self().perform_callback(*cb);
         }
         catch(const std::exception & ex)
         {
-          if(logger_)
-          {
-            logger_->log_exception("Caught exception during callback: ", ex);
-          }
-          else
-          {
-            std::cerr << "Caught exception during callback: " << ex.what() << std::endl;
-          }
+          callback_failed(&ex);
         }
         catch(...)
         {
-          if(logger_)
-          {
-            logger_->log_message("Caught unknown exception during callback");
-          }
-          else
-          {
-            std::cerr << "Caught unknown exception during callback" << std::endl;
-          }
+          callback_failed(nullptr);
+        }
+        if(event_ring_)
+        {
+          event_ring_->push(*cb);
         }
       }
       workingCallbacks_.clear();
     }
+    release_orders();
     handling_callbacks_ = false;
   }
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::publish_book_events()
+{
+  if(bookEvents_.empty())
+  {
+    return;
+  }
+  workingBookEvents_.reserve(bookEvents_.capacity());
+  workingBookEvents_.swap(bookEvents_);
+  for(auto event = workingBookEvents_.begin();
+    event != workingBookEvents_.end(); ++event)
+  {
+    try
+    {
+      // the listener may have been removed by an earlier callback
+      if(market_by_order_listener_)
+      {
+        market_by_order_listener_->on_book_event(this, *event);
+      }
+    }
+    catch(const std::exception & ex)
+    {
+      callback_failed(&ex);
+    }
+    catch(...)
+    {
+      callback_failed(nullptr);
+    }
+  }
+  workingBookEvents_.clear();
+}
+
+template <class OrderPtr, class Storage, class Derived>
+void
+OrderBook<OrderPtr, Storage, Derived>::callback_failed(const std::exception * ex)
+{
+  if(ex)
+  {
+    if(logger_)
+    {
+      logger_->log_exception("Caught exception during callback: ", *ex);
+    }
+    else
+    {
+      std::cerr << "Caught exception during callback: " << ex->what() << std::endl;
+    }
+  }
+  else
+  {
+    if(logger_)
+    {
+      logger_->log_message("Caught unknown exception during callback");
+    }
+    else
+    {
+      std::cerr << "Caught unknown exception during callback" << std::endl;
+    }
+  }
+}
+
+template <class OrderPtr, class Storage, class Derived>
 void
-OrderBook<OrderPtr>::perform_callback(TypedCallback& cb)
+OrderBook<OrderPtr, Storage, Derived>::perform_callback(TypedCallback& cb)
 {
   switch (cb.type) 
   {
@@ -1152,16 +1906,18 @@ OrderBook<OrderPtr>::perform_callback(TypedCallback& cb)
     {
       bool inbound_filled = (cb.flags & (TypedCallback::ff_inbound_filled | TypedCallback::ff_both_filled)) != 0;
       bool matched_filled = (cb.flags & (TypedCallback::ff_matched_filled | TypedCallback::ff_both_filled)) != 0;
-      on_fill(cb.order, cb.matched_order, 
+      const OrderPtr & order = order_of(cb.order);
+      const OrderPtr & matched_order = order_of(cb.matched_order);
+      self().on_fill(order, matched_order, 
         cb.quantity, cb.price,
         inbound_filled,
         matched_filled);
       if(order_listener_)
       {
-        order_listener_->on_fill(cb.order, cb.matched_order, 
+        order_listener_->on_fill(order, matched_order, 
                                 cb.quantity, cb.price);
       }
-      on_trade(this, cb.quantity, cb.price);
+      self().on_trade(this, cb.quantity, cb.price);
       if(trade_listener_)
       {
         trade_listener_->on_trade(this, cb.quantity, cb.price);
@@ -1169,75 +1925,103 @@ OrderBook<OrderPtr>::perform_callback(TypedCallback& cb)
       break;
     }
     case TypedCallback::cb_order_accept:
-      on_accept(cb.order, cb.quantity);
+    {
+      const OrderPtr & order = order_of(cb.order);
+      self().on_accept(order, cb.quantity);
       if(order_listener_)
       {
-        order_listener_->on_accept(cb.order);
+        order_listener_->on_accept(order);
       }
       break;
+    }
     case TypedCallback::cb_order_accept_stop:
-      on_accept_stop(cb.order);
+    {
+      const OrderPtr & order = order_of(cb.order);
+      self().on_accept_stop(order);
       if(order_listener_)
       {
-        order_listener_->on_accept(cb.order);
+        order_listener_->on_accept(order);
       }
       break;
+    }
     case TypedCallback::cb_order_trigger_stop:
-      on_trigger_stop(cb.order);
+    {
+      const OrderPtr & order = order_of(cb.order);
+      self().on_trigger_stop(order);
       if(order_listener_)
       {
-        order_listener_->on_trigger_stop(cb.order);
+        order_listener_->on_trigger_stop(order);
       }
       break;
+    }
     case TypedCallback::cb_order_reject:
-      on_reject(cb.order, cb.reject_reason);
+    {
+      const OrderPtr & order = order_of(cb.order);
+      self().on_reject(order, cb.reject_reason);
       if(order_listener_)
       {
-        order_listener_->on_reject(cb.order, cb.reject_reason);
+        order_listener_->on_reject(order, cb.reject_reason);
       }
       break;
+    }
     case TypedCallback::cb_order_cancel:
-      on_cancel(cb.order, cb.quantity);
+    {
+      const OrderPtr & order = order_of(cb.order);
+      self().on_cancel(order, cb.quantity);
       if(order_listener_)
       {
-        order_listener_->on_cancel(cb.order);
+        order_listener_->on_cancel(order);
       }
       break;
+    }
     case TypedCallback::cb_order_cancel_stop:
-      on_cancel_stop(cb.order);
+    {
+      const OrderPtr & order = order_of(cb.order);
+      self().on_cancel_stop(order);
       if(order_listener_)
       {
-        order_listener_->on_cancel(cb.order);
+        order_listener_->on_cancel(order);
       }
       break;
+    }
     case TypedCallback::cb_order_cancel_reject:
-      on_cancel_reject(cb.order, cb.reject_reason);
+    {
+      const OrderPtr & order = order_of(cb.order);
+      self().on_cancel_reject(order, cb.reject_reason);
       if(order_listener_)
       {
-        order_listener_->on_cancel_reject(cb.order, cb.reject_reason);
+        order_listener_->on_cancel_reject(order, cb.reject_reason);
       }
       break;
+    }
     case TypedCallback::cb_order_replace:
-      on_replace(cb.order, 
-        cb.order->order_qty(), 
-        cb.order->order_qty() + cb.delta,
+    {
+      const OrderPtr & order = order_of(cb.order);
+      // depth holds open quantities, saved when the replace was accepted
+      self().on_replace(order, 
+        cb.quantity, 
+        cb.quantity + cb.delta,
         cb.price);
       if(order_listener_)
       {
-        order_listener_->on_replace(cb.order,
+        order_listener_->on_replace(order,
         cb.delta,
         cb.price);
       }
       break;
+    }
     case TypedCallback::cb_order_replace_reject:
-      on_replace_reject(cb.order, cb.reject_reason);
+    {
+      const OrderPtr & order = order_of(cb.order);
+      self().on_replace_reject(order, cb.reject_reason);
       if(order_listener_)
       {
-        order_listener_->on_replace_reject(cb.order, cb.reject_reason);
+        order_listener_->on_replace_reject(order, cb.reject_reason);
       }
       break;
+    }
     case TypedCallback::cb_book_update:
-      on_order_book_change();
+      self().on_order_book_change();
       if(order_book_listener_)
       {
         order_book_listener_->on_order_book_change(this);
@@ -1253,9 +2037,9 @@ OrderBook<OrderPtr>::perform_callback(TypedCallback& cb)
   }
 }
 
-template <class OrderPtr>
+template <class OrderPtr, class Storage, class Derived>
 std::ostream &
-OrderBook<OrderPtr>::log(std::ostream & out) const
+OrderBook<OrderPtr, Storage, Derived>::log(std::ostream & out) const
 {
   for(auto ask = asks_.rbegin(); ask != asks_.rend(); ++ask) {
     out << "  Ask " << ask->second.open_qty() << " @ " << ask->first
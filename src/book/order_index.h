@@ -0,0 +1,199 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace liquibook { namespace book {
+
+/// @brief Hash table from the address of an order to where the
+///        order is held in the book.
+///
+/// Open addressing with linear probing keeps the table in a single
+/// vector, so adding and removing orders does not allocate once the
+/// table has grown to the size of the book.  Removal shifts later
+/// entries back rather than leaving tombstones, so lookups stay short
+/// however many orders pass through the book.
+template <class Location>
+class OrderIndex {
+public:
+  /// @brief construct an empty index.
+  /// @param capacity initial number of slots (rounded up to a power of 2)
+  explicit OrderIndex(size_t capacity = 64);
+
+  /// @brief record where an order is, replacing any previous location
+  void insert(const void * order, const Location & location);
+
+  /// @brief find where an order is.
+  /// @return the location, or nullptr if the order is not in the index
+  Location * find(const void * order);
+  const Location * find(const void * order) const;
+
+  /// @brief forget an order
+  /// @return true if the order was in the index
+  bool erase(const void * order);
+
+  /// @brief forget all orders
+  void clear();
+
+  /// @brief number of orders in the index
+  size_t size() const;
+
+private:
+  struct Slot {
+    Slot()
+      : key(nullptr)
+    {
+    }
+
+    const void * key;
+    Location location;
+  };
+
+  size_t home(const void * key) const;
+  size_t probe(const void * key) const;
+  void grow();
+
+  std::vector<Slot> slots_;
+  size_t mask_;
+  size_t size_;
+};
+
+template <class Location>
+OrderIndex<Location>::OrderIndex(size_t capacity)
+: size_(0)
+{
+  size_t slots = 8;
+  while(slots < capacity)
+  {
+    slots *= 2;
+  }
+  slots_.resize(slots);
+  mask_ = slots - 1;
+}
+
+template <class Location>
+size_t
+OrderIndex<Location>::home(const void * key) const
+{
+  // Orders are aligned, so mix the high bits down into the low ones.
+  uint64_t hash = reinterpret_cast<uintptr_t>(key);
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return static_cast<size_t>(hash) & mask_;
+}
+
+template <class Location>
+size_t
+OrderIndex<Location>::probe(const void * key) const
+{
+  size_t pos = home(key);
+  while(slots_[pos].key != nullptr && slots_[pos].key != key)
+  {
+    pos = (pos + 1) & mask_;
+  }
+  return pos;
+}
+
+template <class Location>
+void
+OrderIndex<Location>::insert(const void * order, const Location & location)
+{
+  // keep the load factor at or below one half
+  if((size_ + 1) * 2 > slots_.size())
+  {
+    grow();
+  }
+  Slot & slot = slots_[probe(order)];
+  if(slot.key == nullptr)
+  {
+    slot.key = order;
+    ++size_;
+  }
+  slot.location = location;
+}
+
+template <class Location>
+Location *
+OrderIndex<Location>::find(const void * order)
+{
+  Slot & slot = slots_[probe(order)];
+  return slot.key == nullptr ? nullptr : &slot.location;
+}
+
+template <class Location>
+const Location *
+OrderIndex<Location>::find(const void * order) const
+{
+  const Slot & slot = slots_[probe(order)];
+  return slot.key == nullptr ? nullptr : &slot.location;
+}
+
+template <class Location>
+bool
+OrderIndex<Location>::erase(const void * order)
+{
+  size_t hole = probe(order);
+  if(slots_[hole].key == nullptr)
+  {
+    return false;
+  }
+  // Move back any later entry in the run that would otherwise
+  // become unreachable from its home slot.
+  size_t pos = hole;
+  while(true)
+  {
+    pos = (pos + 1) & mask_;
+    if(slots_[pos].key == nullptr)
+    {
+      break;
+    }
+    size_t want = home(slots_[pos].key);
+    if(((pos - want) & mask_) >= ((pos - hole) & mask_))
+    {
+      slots_[hole] = slots_[pos];
+      hole = pos;
+    }
+  }
+  slots_[hole] = Slot();
+  --size_;
+  return true;
+}
+
+template <class Location>
+void
+OrderIndex<Location>::clear()
+{
+  slots_.assign(slots_.size(), Slot());
+  size_ = 0;
+}
+
+template <class Location>
+size_t
+OrderIndex<Location>::size() const
+{
+  return size_;
+}
+
+template <class Location>
+void
+OrderIndex<Location>::grow()
+{
+  std::vector<Slot> old;
+  old.swap(slots_);
+  slots_.resize(old.size() * 2);
+  mask_ = slots_.size() - 1;
+  for(auto pos = old.begin(); pos != old.end(); ++pos)
+  {
+    if(pos->key != nullptr)
+    {
+      slots_[probe(pos->key)] = *pos;
+    }
+  }
+}
+
+} }
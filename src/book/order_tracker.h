@@ -9,6 +9,8 @@ namespace liquibook { namespace book {
 
 /// @brief Tracker of an order's state, to keep inside the OrderBook.  
 ///   Kept separate from the order itself.
+///   The side, prices and conditions are copied from the order when it is
+///   accepted, so matching does not have to go through the order pointer.
 template <typename OrderPtr>
 class OrderTracker {
 public:
@@ -37,6 +39,21 @@ public:
   /// @brief get the order pointer
   OrderPtr& ptr();
 
+  /// @brief is this order a buy?
+  bool is_buy() const;
+
+  /// @brief get the price of this order, or 0 if a market order
+  Price price() const;
+
+  /// @brief change the price of this order
+  void set_price(Price price);
+
+  /// @brief get the stop price, or 0 if not a stop order
+  Price stop_price() const;
+
+  /// @brief get the conditions this order was accepted with
+  OrderConditions conditions() const;
+
   /// @ brief is this order marked all or none?
   bool all_or_none() const;
 
@@ -49,7 +66,10 @@ private:
   OrderPtr order_;
   Quantity open_qty_;
   int64_t reserved_;
+  Price price_;
+  Price stop_price_;
   OrderConditions conditions_;
+  bool is_buy_;
 };
 
 template <class OrderPtr>
@@ -59,7 +79,10 @@ OrderTracker<OrderPtr>::OrderTracker(
 : order_(order),
   open_qty_(order->order_qty()),
   reserved_(0),
-  conditions_(conditions)
+  price_(order->price()),
+  stop_price_(order->stop_price()),
+  conditions_(conditions),
+  is_buy_(order->is_buy())
 {
 #if defined(LIQUIBOOK_ORDER_KNOWS_CONDITIONS)
   if(order->all_or_none())
@@ -141,6 +164,41 @@ OrderTracker<OrderPtr>::ptr()
   return order_;
 }
 
+template <class OrderPtr>
+bool
+OrderTracker<OrderPtr>::is_buy() const
+{
+  return is_buy_;
+}
+
+template <class OrderPtr>
+Price
+OrderTracker<OrderPtr>::price() const
+{
+  return price_;
+}
+
+template <class OrderPtr>
+void
+OrderTracker<OrderPtr>::set_price(Price price)
+{
+  price_ = price;
+}
+
+template <class OrderPtr>
+Price
+OrderTracker<OrderPtr>::stop_price() const
+{
+  return stop_price_;
+}
+
+template <class OrderPtr>
+OrderConditions
+OrderTracker<OrderPtr>::conditions() const
+{
+  return conditions_;
+}
+
 template <class OrderPtr>
 bool
 OrderTracker<OrderPtr>::all_or_none() const
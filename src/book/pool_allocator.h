@@ -0,0 +1,196 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+#include <type_traits>
+
+namespace liquibook { namespace book {
+
+/// @brief Pool of equal-sized blocks carved from larger slabs.
+///
+/// Freed blocks go on a free list and are handed out again before any new
+/// slab is allocated, so once a pool has grown to its working size it
+/// never touches the heap.  Slabs are only released when the pool is
+/// destroyed.
+class SlabPool {
+public:
+  /// @brief construct
+  /// @param blocks_per_slab how many blocks to allocate at a time
+  explicit SlabPool(size_t blocks_per_slab = 256);
+  ~SlabPool();
+
+  /// @brief get a block.  The first request fixes the block size;
+  ///        requests for other sizes go to the heap.
+  void * allocate(size_t size);
+
+  /// @brief return a block obtained from allocate(size)
+  void deallocate(void * block, size_t size);
+
+  /// @brief number of blocks currently handed out
+  size_t in_use() const { return in_use_; }
+
+  /// @brief number of blocks in all slabs
+  size_t capacity() const { return slabs_.size() * blocks_per_slab_; }
+
+private:
+  SlabPool(const SlabPool &);
+  SlabPool & operator =(const SlabPool &);
+
+  struct FreeBlock {
+    FreeBlock * next;
+  };
+
+  void add_slab();
+
+  size_t blocks_per_slab_;
+  size_t request_size_;  // size of the requests this pool serves
+  size_t block_size_;    // request_size_ rounded up for alignment
+  FreeBlock * free_;
+  size_t in_use_;
+  std::vector<void *> slabs_;
+};
+
+inline
+SlabPool::SlabPool(size_t blocks_per_slab)
+: blocks_per_slab_(blocks_per_slab ? blocks_per_slab : 1),
+  request_size_(0),
+  block_size_(0),
+  free_(nullptr),
+  in_use_(0)
+{
+}
+
+inline
+SlabPool::~SlabPool()
+{
+  for(auto slab = slabs_.begin(); slab != slabs_.end(); ++slab)
+  {
+    ::operator delete(*slab);
+  }
+}
+
+inline void *
+SlabPool::allocate(size_t size)
+{
+  if(request_size_ == 0)
+  {
+    const size_t align = alignof(std::max_align_t);
+    request_size_ = size;
+    block_size_ = (std::max)(size, sizeof(FreeBlock));
+    block_size_ = (block_size_ + align - 1) / align * align;
+  }
+  if(size != request_size_)
+  {
+    return ::operator new(size);
+  }
+  if(free_ == nullptr)
+  {
+    add_slab();
+  }
+  FreeBlock * block = free_;
+  free_ = block->next;
+  ++in_use_;
+  return block;
+}
+
+inline void
+SlabPool::deallocate(void * block, size_t size)
+{
+  if(size != request_size_)
+  {
+    ::operator delete(block);
+    return;
+  }
+  FreeBlock * freed = static_cast<FreeBlock *>(block);
+  freed->next = free_;
+  free_ = freed;
+  --in_use_;
+}
+
+inline void
+SlabPool::add_slab()
+{
+  char * slab = static_cast<char *>(
+    ::operator new(block_size_ * blocks_per_slab_));
+  slabs_.push_back(slab);
+  // thread the new blocks onto the free list in address order
+  for(size_t index = blocks_per_slab_; index > 0; --index)
+  {
+    FreeBlock * block =
+      reinterpret_cast<FreeBlock *>(slab + (index - 1) * block_size_);
+    block->next = free_;
+    free_ = block;
+  }
+}
+
+/// @brief Standard allocator that takes single objects from a SlabPool.
+///
+/// A default constructed allocator creates its own pool, which is shared
+/// by every copy (and every rebound copy) of it, so each container that
+/// uses a PoolAllocator gets a private pool for its nodes.  Arrays go to
+/// the heap.
+template <class T>
+class PoolAllocator {
+public:
+  typedef T value_type;
+  typedef std::true_type propagate_on_container_copy_assignment;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  PoolAllocator()
+    : pool_(std::make_shared<SlabPool>())
+  {
+  }
+
+  template <class U>
+  PoolAllocator(const PoolAllocator<U> & rhs)
+    : pool_(rhs.pool_)
+  {
+  }
+
+  T * allocate(size_t count)
+  {
+    if(count != 1)
+    {
+      return static_cast<T *>(::operator new(count * sizeof(T)));
+    }
+    return static_cast<T *>(pool_->allocate(sizeof(T)));
+  }
+
+  void deallocate(T * object, size_t count)
+  {
+    if(count != 1)
+    {
+      ::operator delete(object);
+      return;
+    }
+    pool_->deallocate(object, sizeof(T));
+  }
+
+  /// @brief access the pool
+  const SlabPool & pool() const { return *pool_; }
+
+  template <class U>
+  bool operator ==(const PoolAllocator<U> & rhs) const
+  {
+    return pool_ == rhs.pool_;
+  }
+
+  template <class U>
+  bool operator !=(const PoolAllocator<U> & rhs) const
+  {
+    return pool_ != rhs.pool_;
+  }
+
+private:
+  template <class U> friend class PoolAllocator;
+  std::shared_ptr<SlabPool> pool_;
+};
+
+} }
@@ -0,0 +1,83 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include "types.h"
+#include <stdexcept>
+
+namespace liquibook { namespace book {
+
+/// @brief The range of prices, and the tick size, that a security
+///        normally trades at.
+///
+/// Containers that support it store levels on the band's ticks in a flat
+/// array indexed by tick, and keep any other prices in an ordinary map.
+class PriceBand {
+public:
+  /// @brief construct an empty band.  Nothing is on an empty band.
+  PriceBand()
+    : low_(0)
+    , high_(0)
+    , tick_(0)
+  {
+  }
+
+  /// @brief construct
+  /// @param low the lowest price on the band
+  /// @param high the highest price on the band
+  /// @param tick the price increment.  (high - low) must be a multiple of it.
+  PriceBand(Price low, Price high, Price tick)
+    : low_(low)
+    , high_(high)
+    , tick_(tick)
+  {
+    if(tick == 0 || high < low || (high - low) % tick != 0)
+    {
+      throw std::runtime_error("Invalid price band");
+    }
+  }
+
+  /// @brief lowest price on the band
+  Price low() const { return low_; }
+
+  /// @brief highest price on the band
+  Price high() const { return high_; }
+
+  /// @brief price increment
+  Price tick() const { return tick_; }
+
+  /// @brief is this the empty band?
+  bool empty() const { return tick_ == 0; }
+
+  /// @brief number of ticks on the band, including both ends.
+  size_t ticks() const
+  {
+    return empty() ? 0 : size_t((high_ - low_) / tick_ + 1);
+  }
+
+  /// @brief is this price on one of the band's ticks?
+  bool contains(Price price) const
+  {
+    return !empty() && price >= low_ && price <= high_ &&
+      (price - low_) % tick_ == 0;
+  }
+
+private:
+  Price low_;
+  Price high_;
+  Price tick_;
+};
+
+/// @brief give a container a price band to index its levels by.
+/// Containers without tick-indexed storage ignore the band; those that
+/// have it provide a more specialized overload.
+template <class Container>
+void
+configure_price_band(Container & container,
+                     bool buy_side,
+                     const PriceBand & band)
+{
+}
+
+} }
@@ -0,0 +1,545 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include "comparable_price.h"
+#include "tick_map.h"
+#include <map>
+#include <vector>
+#include <iterator>
+#include <cstddef>
+#include <utility>
+
+namespace liquibook { namespace book {
+
+/// @brief Keep a PriceLadder's levels in a std::map.
+struct OrderedLevels
+{
+  template <class Level>
+  struct Bind
+  {
+    typedef std::map<ComparablePrice, Level> LevelMap;
+  };
+};
+
+/// @brief Keep a PriceLadder's levels in a TickMap, so levels on the
+///        book's price band are found by array indexing.
+struct TickLevels
+{
+  template <class Level>
+  struct Bind
+  {
+    typedef TickMap<Level> LevelMap;
+  };
+};
+
+/// @brief Order container that groups resting orders by price level.
+///
+/// Each level holds its orders in a vector in time priority, so walking a
+/// level during matching touches contiguous memory, and only one map node
+/// is allocated per price rather than one per order.  The best level is
+/// always at begin().  The Levels policy selects the container that maps
+/// prices to levels.
+///
+/// The container presents the subset of the std::multimap<ComparablePrice,
+/// Tracker> interface that OrderBook uses, so it can be used as a drop-in
+/// TrackerMap.  Dereferencing an iterator yields an Entry with the same
+/// first (price) and second (tracker) members as a multimap value_type.
+///
+/// Erased orders are marked dead in place and skipped by iterators.  Dead
+/// slots are squeezed out of a level only when a new order is added to it.
+/// Iterators name an order by its sequence number within the level, so as
+/// in a multimap an iterator to a live order stays valid until that order
+/// is erased, even if its level is compacted in the meantime.
+template <class Tracker, class Levels = OrderedLevels>
+class PriceLadder {
+public:
+  /// @brief an order in the ladder.
+  struct Entry {
+    template <class T>
+    Entry(const ComparablePrice & key, T && tracker, size_t sequence)
+      : first(key)
+      , second(std::forward<T>(tracker))
+      , seq(sequence)
+      , live(true)
+    {
+    }
+
+    ComparablePrice first;
+    Tracker second;
+    size_t seq;   // arrival order within the level
+    bool live;
+  };
+
+private:
+  /// @brief all orders at one price, in time priority.
+  /// Invariant: a level in the map has at least one live entry, and
+  /// both entries[head] and entries.back() are live.
+  struct Level {
+    Level()
+      : head(0)
+      , next_seq(0)
+      , live(0)
+    {
+    }
+
+    /// @brief position of the entry with this sequence number.
+    size_t locate(size_t seq) const
+    {
+      size_t low = head;
+      size_t high = entries.size();
+      while(low < high)
+      {
+        size_t mid = low + (high - low) / 2;
+        if(entries[mid].seq < seq)
+        {
+          low = mid + 1;
+        }
+        else
+        {
+          high = mid;
+        }
+      }
+      return low;
+    }
+
+    std::vector<Entry> entries;
+    size_t head;      // position of the first live entry
+    size_t next_seq;  // sequence number for the next entry
+    size_t live;      // number of live entries
+  };
+  typedef typename Levels::template Bind<Level>::LevelMap LevelMap;
+
+public:
+  /// @brief bidirectional iterator over live orders, best price first.
+  template <class LevelMapT, class LevelIter, class Value>
+  class Iterator {
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Value * pointer;
+    typedef Value & reference;
+
+    Iterator()
+      : levels_(nullptr)
+      , seq_(0)
+      , pos_(0)
+    {
+    }
+
+    Iterator(LevelMapT * levels, LevelIter level, size_t pos)
+      : levels_(levels)
+      , level_(level)
+      , seq_(0)
+      , pos_(pos)
+    {
+      if(level_ != levels_->end())
+      {
+        seq_ = level_->second.entries[pos_].seq;
+      }
+    }
+
+    /// @brief allow iterator to const_iterator conversion.
+    template <class M, class L, class V>
+    Iterator(const Iterator<M, L, V> & rhs)
+      : levels_(rhs.levels_)
+      , level_(rhs.level_)
+      , seq_(rhs.seq_)
+      , pos_(rhs.pos_)
+    {
+    }
+
+    reference operator *() const
+    {
+      return level_->second.entries[position()];
+    }
+
+    pointer operator ->() const
+    {
+      return &**this;
+    }
+
+    Iterator & operator ++()
+    {
+      const Level & level = level_->second;
+      size_t pos = position() + 1;
+      while(pos < level.entries.size() && !level.entries[pos].live)
+      {
+        ++pos;
+      }
+      if(pos < level.entries.size())
+      {
+        seek(pos);
+      }
+      else
+      {
+        ++level_;
+        seek(level_ == levels_->end() ? 0 : level_->second.head);
+      }
+      return *this;
+    }
+
+    Iterator operator ++(int)
+    {
+      Iterator result(*this);
+      ++*this;
+      return result;
+    }
+
+    Iterator & operator --()
+    {
+      if(level_ != levels_->end())
+      {
+        const Level & level = level_->second;
+        size_t pos = position();
+        while(pos > level.head)
+        {
+          --pos;
+          if(level.entries[pos].live)
+          {
+            seek(pos);
+            return *this;
+          }
+        }
+      }
+      --level_;
+      seek(level_->second.entries.size() - 1);
+      return *this;
+    }
+
+    Iterator operator --(int)
+    {
+      Iterator result(*this);
+      --*this;
+      return result;
+    }
+
+    bool operator ==(const Iterator & rhs) const
+    {
+      return level_ == rhs.level_ && seq_ == rhs.seq_;
+    }
+
+    bool operator !=(const Iterator & rhs) const
+    {
+      return !(*this == rhs);
+    }
+
+  private:
+    template <class M, class L, class V> friend class Iterator;
+    friend class PriceLadder;
+
+    /// @brief current position of the entry, which moves
+    /// if the level has been compacted.
+    size_t position() const
+    {
+      const Level & level = level_->second;
+      if(pos_ >= level.entries.size() || level.entries[pos_].seq != seq_)
+      {
+        pos_ = level.locate(seq_);
+      }
+      return pos_;
+    }
+
+    void seek(size_t pos)
+    {
+      pos_ = pos;
+      seq_ = (level_ == levels_->end()) ? 0 : level_->second.entries[pos].seq;
+    }
+
+    LevelMapT * levels_;
+    LevelIter level_;
+    size_t seq_;
+    mutable size_t pos_;
+  };
+
+  typedef ComparablePrice key_type;
+  typedef Tracker mapped_type;
+  typedef Entry value_type;
+  typedef size_t size_type;
+  typedef Iterator<LevelMap, typename LevelMap::iterator, Entry> iterator;
+  typedef Iterator<const LevelMap, typename LevelMap::const_iterator, const Entry>
+    const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  /// @brief construct an empty ladder
+  PriceLadder();
+
+  /// @brief add an order behind all other orders at the same price.
+  /// @return an iterator to the new entry
+  template <class T>
+  iterator emplace(const ComparablePrice & key, T && tracker);
+
+  /// @brief add a (price, tracker) pair, as std::multimap::insert does
+  template <class Pair>
+  iterator insert(const Pair & value);
+
+  /// @brief remove an order
+  /// @return an iterator to the order that followed the erased one
+  iterator erase(iterator pos);
+
+  /// @brief remove all orders
+  void clear();
+
+  /// @brief find the first order at exactly this price
+  iterator find(const ComparablePrice & key);
+  const_iterator find(const ComparablePrice & key) const;
+
+  /// @brief find the first order at this price or worse
+  iterator lower_bound(const ComparablePrice & key);
+  const_iterator lower_bound(const ComparablePrice & key) const;
+
+  /// @brief find the first order at a price worse than this one
+  iterator upper_bound(const ComparablePrice & key);
+  const_iterator upper_bound(const ComparablePrice & key) const;
+
+  iterator begin();
+  iterator end();
+  const_iterator begin() const;
+  const_iterator end() const;
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+  /// @brief number of orders in the ladder
+  size_t size() const;
+
+  /// @brief are there no orders in the ladder?
+  bool empty() const;
+
+  /// @brief number of distinct prices in the ladder
+  size_t level_count() const;
+
+  /// @brief index levels on a price band, if the Levels policy supports it.
+  /// Only allowed while the ladder is empty.
+  void set_price_band(bool buy_side, const PriceBand & band);
+
+private:
+  iterator make_iterator(typename LevelMap::iterator level);
+  const_iterator make_iterator(typename LevelMap::const_iterator level) const;
+
+  /// @brief squeeze dead entries out of a level.
+  void compact(Level & level);
+
+  LevelMap levels_;
+  size_t size_;
+};
+
+template <class Tracker, class Levels>
+PriceLadder<Tracker, Levels>::PriceLadder()
+: size_(0)
+{
+}
+
+template <class Tracker, class Levels>
+template <class T>
+typename PriceLadder<Tracker, Levels>::iterator
+PriceLadder<Tracker, Levels>::emplace(const ComparablePrice & key, T && tracker)
+{
+  typename LevelMap::iterator pos =
+    levels_.insert(std::make_pair(key, Level())).first;
+  Level & level = pos->second;
+  if(level.entries.size() - level.live > level.live)
+  {
+    compact(level);
+  }
+  level.entries.push_back(
+    Entry(key, std::forward<T>(tracker), level.next_seq++));
+  ++level.live;
+  ++size_;
+  return iterator(&levels_, pos, level.entries.size() - 1);
+}
+
+template <class Tracker, class Levels>
+template <class Pair>
+typename PriceLadder<Tracker, Levels>::iterator
+PriceLadder<Tracker, Levels>::insert(const Pair & value)
+{
+  return emplace(value.first, value.second);
+}
+
+template <class Tracker, class Levels>
+typename PriceLadder<Tracker, Levels>::iterator
+PriceLadder<Tracker, Levels>::erase(iterator pos)
+{
+  iterator next = pos;
+  ++next;
+  Level & level = pos.level_->second;
+  level.entries[pos.position()].live = false;
+  --level.live;
+  --size_;
+  if(level.live == 0)
+  {
+    levels_.erase(pos.level_);
+  }
+  else
+  {
+    // Neither of these moves a live entry, so other iterators stay valid.
+    while(!level.entries.back().live)
+    {
+      level.entries.pop_back();
+    }
+    while(!level.entries[level.head].live)
+    {
+      ++level.head;
+    }
+  }
+  return next;
+}
+
+template <class Tracker, class Levels>
+void
+PriceLadder<Tracker, Levels>::clear()
+{
+  levels_.clear();
+  size_ = 0;
+}
+
+template <class Tracker, class Levels>
+void
+PriceLadder<Tracker, Levels>::compact(Level & level)
+{
+  size_t kept = 0;
+  for(size_t pos = level.head; pos < level.entries.size(); ++pos)
+  {
+    if(level.entries[pos].live)
+    {
+      if(kept != pos)
+      {
+        level.entries[kept] = std::move(level.entries[pos]);
+      }
+      ++kept;
+    }
+  }
+  level.entries.erase(level.entries.begin() + kept, level.entries.end());
+  level.head = 0;
+}
+
+template <class Tracker, class Levels>
+typename PriceLadder<Tracker, Levels>::iterator
+PriceLadder<Tracker, Levels>::make_iterator(typename LevelMap::iterator level)
+{
+  return iterator(&levels_, level,
+    level == levels_.end() ? 0 : level->second.head);
+}
+
+template <class Tracker, class Levels>
+typename PriceLadder<Tracker, Levels>::const_iterator
+PriceLadder<Tracker, Levels>::make_iterator(typename LevelMap::const_iterator level) const
+{
+  return const_iterator(&levels_, level,
+    level == levels_.end() ? 0 : level->second.head);
+}
+
+template <class Tracker, class Levels>
+typename PriceLadder<Tracker, Levels>::iterator
+PriceLadder<Tracker, Levels>::find(const ComparablePrice & key)
+{
+  return make_iterator(levels_.find(key));
+}
+
+template <class Tracker, class Levels>
+typename PriceLadder<Tracker, Levels>::const_iterator
+PriceLadder<Tracker, Levels>::find(const ComparablePrice & key) const
+{
+  return make_iterator(levels_.find(key));
+}
+
+template <class Tracker, class Levels>
+typename PriceLadder<Tracker, Levels>::iterator
+PriceLadder<Tracker, Levels>::lower_bound(const ComparablePrice & key)
+{
+  return make_iterator(levels_.lower_bound(key));
+}
+
+template <class Tracker, class Levels>
+typename PriceLadder<Tracker, Levels>::const_iterator
+PriceLadder<Tracker, Levels>::lower_bound(const ComparablePrice & key) const
+{
+  return make_iterator(levels_.lower_bound(key));
+}
+
+template <class Tracker, class Levels>
+typename PriceLadder<Tracker, Levels>::iterator
+PriceLadder<Tracker, Levels>::upper_bound(const ComparablePrice & key)
+{
+  return make_iterator(levels_.upper_bound(key));
+}
+
+template <class Tracker, class Levels>
+typename PriceLadder<Tracker, Levels>::const_iterator
+PriceLadder<Tracker, Levels>::upper_bound(const ComparablePrice & key) const
+{
+  return make_iterator(levels_.upper_bound(key));
+}
+
+template <class Tracker, class Levels>
+typename PriceLadder<Tracker, Levels>::iterator
+PriceLadder<Tracker, Levels>::begin()
+{
+  return make_iterator(levels_.begin());
+}
+
+template <class Tracker, class Levels>
+typename PriceLadder<Tracker, Levels>::iterator
+PriceLadder<Tracker, Levels>::end()
+{
+  return make_iterator(levels_.end());
+}
+
+template <class Tracker, class Levels>
+typename PriceLadder<Tracker, Levels>::const_iterator
+PriceLadder<Tracker, Levels>::begin() const
+{
+  return make_iterator(levels_.begin());
+}
+
+template <class Tracker, class Levels>
+typename PriceLadder<Tracker, Levels>::const_iterator
+PriceLadder<Tracker, Levels>::end() const
+{
+  return make_iterator(levels_.end());
+}
+
+template <class Tracker, class Levels>
+size_t
+PriceLadder<Tracker, Levels>::size() const
+{
+  return size_;
+}
+
+template <class Tracker, class Levels>
+bool
+PriceLadder<Tracker, Levels>::empty() const
+{
+  return size_ == 0;
+}
+
+template <class Tracker, class Levels>
+size_t
+PriceLadder<Tracker, Levels>::level_count() const
+{
+  return levels_.size();
+}
+
+template <class Tracker, class Levels>
+void
+PriceLadder<Tracker, Levels>::set_price_band(bool buy_side, const PriceBand & band)
+{
+  configure_price_band(levels_, buy_side, band);
+}
+
+/// @brief index a PriceLadder's levels on a band.
+template <class Tracker, class Levels>
+void
+configure_price_band(PriceLadder<Tracker, Levels> & ladder,
+                     bool buy_side,
+                     const PriceBand & band)
+{
+  ladder.set_price_band(buy_side, band);
+}
+
+} }
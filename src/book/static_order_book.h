@@ -0,0 +1,447 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include "depth_order_book.h"
+
+namespace liquibook { namespace book {
+
+/// @brief listener for StaticOrderBook and StaticDepthOrderBook that
+///        ignores every event.
+///
+/// Derive a listener from this and declare the events it wants with the
+/// same names and parameters; they need not be virtual.  Events it does
+/// not declare compile to nothing.
+class StaticListener {
+public:
+  template <class OrderPtr>
+  void on_accept(const OrderPtr& order) {}
+
+  template <class OrderPtr>
+  void on_trigger_stop(const OrderPtr& order) {}
+
+  template <class OrderPtr>
+  void on_reject(const OrderPtr& order, const char* reason) {}
+
+  template <class OrderPtr>
+  void on_fill(const OrderPtr& order,
+               const OrderPtr& matched_order,
+               Quantity fill_qty,
+               Price fill_price) {}
+
+  template <class OrderPtr>
+  void on_cancel(const OrderPtr& order) {}
+
+  template <class OrderPtr>
+  void on_cancel_reject(const OrderPtr& order, const char* reason) {}
+
+  template <class OrderPtr>
+  void on_replace(const OrderPtr& order,
+                  const int64_t& size_delta,
+                  Price new_price) {}
+
+  template <class OrderPtr>
+  void on_replace_reject(const OrderPtr& order, const char* reason) {}
+
+  template <class Book>
+  void on_trade(const Book* book, Quantity qty, Price price) {}
+
+  template <class Book>
+  void on_order_book_change(const Book* book) {}
+
+  template <class Book, class DepthTracker>
+  void on_depth_change(const Book* book, const DepthTracker* depth) {}
+
+  template <class Book, class DepthTracker>
+  void on_bbo_change(const Book* book, const DepthTracker* depth) {}
+};
+
+/// @brief OrderBook whose listener is a template parameter.
+///
+/// The book calls the Listener's methods directly rather than through
+/// the OrderListener, TradeListener and OrderBookListener interfaces, so
+/// the whole path from matching to the listener can be inlined.  The
+/// events and their order are the same as for a runtime listener.
+/// The book holds its Listener by value.
+template <class OrderPtr, class Listener, class Storage = DefaultStorage>
+class StaticOrderBook final
+  : public OrderBook<OrderPtr, Storage,
+                     StaticOrderBook<OrderPtr, Listener, Storage> > {
+  typedef OrderBook<OrderPtr, Storage,
+                    StaticOrderBook<OrderPtr, Listener, Storage> > Base;
+  friend Base;
+public:
+  /// @brief construct
+  StaticOrderBook(const std::string & symbol = "unknown",
+                  const Listener & listener = Listener());
+
+  /// @brief access the listener
+  Listener & listener();
+
+  /// @brief access the listener
+  const Listener & listener() const;
+
+private:
+  virtual void on_accept(const OrderPtr& order, Quantity quantity);
+  virtual void on_accept_stop(const OrderPtr& order);
+  virtual void on_trigger_stop(const OrderPtr& order);
+  virtual void on_reject(const OrderPtr& order, const char* reason);
+  virtual void on_fill(const OrderPtr& order,
+    const OrderPtr& matched_order,
+    Quantity fill_qty,
+    Price fill_price,
+    bool inbound_order_filled,
+    bool matched_order_filled);
+  virtual void on_cancel(const OrderPtr& order, Quantity quantity);
+  virtual void on_cancel_stop(const OrderPtr& order);
+  virtual void on_cancel_reject(const OrderPtr& order, const char* reason);
+  virtual void on_replace(const OrderPtr& order,
+    Quantity current_qty,
+    Quantity new_qty,
+    Price new_price);
+  virtual void on_replace_reject(const OrderPtr& order, const char* reason);
+  virtual void on_trade(const Base* book, Quantity qty, Price price);
+  virtual void on_order_book_change();
+
+  Listener listener_;
+};
+
+/// @brief DepthOrderBook whose listener is a template parameter.
+///
+/// As StaticOrderBook, and the Listener also receives the depth and BBO
+/// changes.
+template <class OrderPtr, class Listener, int SIZE = 5,
+          class Storage = DefaultStorage>
+class StaticDepthOrderBook final
+  : public DepthOrderBook<OrderPtr, SIZE, Storage,
+                          StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage> > {
+  typedef DepthOrderBook<OrderPtr, SIZE, Storage,
+                         StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage> >
+    Base;
+  typedef OrderBook<OrderPtr, Storage,
+                    StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage> >
+    BookBase;
+  friend Base;
+  friend BookBase;
+public:
+  typedef typename Base::DepthTracker DepthTracker;
+
+  /// @brief construct
+  StaticDepthOrderBook(const std::string & symbol = "unknown",
+                       const Listener & listener = Listener());
+
+  /// @brief access the listener
+  Listener & listener();
+
+  /// @brief access the listener
+  const Listener & listener() const;
+
+private:
+  virtual void on_accept(const OrderPtr& order, Quantity quantity);
+  virtual void on_accept_stop(const OrderPtr& order);
+  virtual void on_trigger_stop(const OrderPtr& order);
+  virtual void on_reject(const OrderPtr& order, const char* reason);
+  virtual void on_fill(const OrderPtr& order,
+    const OrderPtr& matched_order,
+    Quantity fill_qty,
+    Price fill_price,
+    bool inbound_order_filled,
+    bool matched_order_filled);
+  virtual void on_cancel(const OrderPtr& order, Quantity quantity);
+  virtual void on_cancel_stop(const OrderPtr& order);
+  virtual void on_cancel_reject(const OrderPtr& order, const char* reason);
+  virtual void on_replace(const OrderPtr& order,
+    Quantity current_qty,
+    Quantity new_qty,
+    Price new_price);
+  virtual void on_replace_reject(const OrderPtr& order, const char* reason);
+  virtual void on_trade(const BookBase* book, Quantity qty, Price price);
+  virtual void on_order_book_change();
+  virtual void on_depth_change(const DepthTracker* depth);
+  virtual void on_bbo_change(const DepthTracker* depth);
+
+  Listener listener_;
+};
+
+template <class OrderPtr, class Listener, class Storage>
+StaticOrderBook<OrderPtr, Listener, Storage>::StaticOrderBook(
+  const std::string & symbol,
+  const Listener & listener)
+: Base(symbol),
+  listener_(listener)
+{
+}
+
+template <class OrderPtr, class Listener, class Storage>
+Listener &
+StaticOrderBook<OrderPtr, Listener, Storage>::listener()
+{
+  return listener_;
+}
+
+template <class OrderPtr, class Listener, class Storage>
+const Listener &
+StaticOrderBook<OrderPtr, Listener, Storage>::listener() const
+{
+  return listener_;
+}
+
+template <class OrderPtr, class Listener, class Storage>
+void
+StaticOrderBook<OrderPtr, Listener, Storage>::on_accept(
+  const OrderPtr& order, Quantity quantity)
+{
+  listener_.on_accept(order);
+}
+
+template <class OrderPtr, class Listener, class Storage>
+void
+StaticOrderBook<OrderPtr, Listener, Storage>::on_accept_stop(
+  const OrderPtr& order)
+{
+  listener_.on_accept(order);
+}
+
+template <class OrderPtr, class Listener, class Storage>
+void
+StaticOrderBook<OrderPtr, Listener, Storage>::on_trigger_stop(
+  const OrderPtr& order)
+{
+  listener_.on_trigger_stop(order);
+}
+
+template <class OrderPtr, class Listener, class Storage>
+void
+StaticOrderBook<OrderPtr, Listener, Storage>::on_reject(
+  const OrderPtr& order, const char* reason)
+{
+  listener_.on_reject(order, reason);
+}
+
+template <class OrderPtr, class Listener, class Storage>
+void
+StaticOrderBook<OrderPtr, Listener, Storage>::on_fill(
+  const OrderPtr& order,
+  const OrderPtr& matched_order,
+  Quantity fill_qty,
+  Price fill_price,
+  bool inbound_order_filled,
+  bool matched_order_filled)
+{
+  listener_.on_fill(order, matched_order, fill_qty, fill_price);
+}
+
+template <class OrderPtr, class Listener, class Storage>
+void
+StaticOrderBook<OrderPtr, Listener, Storage>::on_cancel(
+  const OrderPtr& order, Quantity quantity)
+{
+  listener_.on_cancel(order);
+}
+
+template <class OrderPtr, class Listener, class Storage>
+void
+StaticOrderBook<OrderPtr, Listener, Storage>::on_cancel_stop(
+  const OrderPtr& order)
+{
+  listener_.on_cancel(order);
+}
+
+template <class OrderPtr, class Listener, class Storage>
+void
+StaticOrderBook<OrderPtr, Listener, Storage>::on_cancel_reject(
+  const OrderPtr& order, const char* reason)
+{
+  listener_.on_cancel_reject(order, reason);
+}
+
+template <class OrderPtr, class Listener, class Storage>
+void
+StaticOrderBook<OrderPtr, Listener, Storage>::on_replace(
+  const OrderPtr& order,
+  Quantity current_qty,
+  Quantity new_qty,
+  Price new_price)
+{
+  listener_.on_replace(order, int64_t(new_qty) - int64_t(current_qty),
+    new_price);
+}
+
+template <class OrderPtr, class Listener, class Storage>
+void
+StaticOrderBook<OrderPtr, Listener, Storage>::on_replace_reject(
+  const OrderPtr& order, const char* reason)
+{
+  listener_.on_replace_reject(order, reason);
+}
+
+template <class OrderPtr, class Listener, class Storage>
+void
+StaticOrderBook<OrderPtr, Listener, Storage>::on_trade(
+  const Base* book, Quantity qty, Price price)
+{
+  listener_.on_trade(this, qty, price);
+}
+
+template <class OrderPtr, class Listener, class Storage>
+void
+StaticOrderBook<OrderPtr, Listener, Storage>::on_order_book_change()
+{
+  listener_.on_order_book_change(this);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::StaticDepthOrderBook(
+  const std::string & symbol,
+  const Listener & listener)
+: Base(symbol),
+  listener_(listener)
+{
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+Listener &
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::listener()
+{
+  return listener_;
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+const Listener &
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::listener() const
+{
+  return listener_;
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_accept(
+  const OrderPtr& order, Quantity quantity)
+{
+  Base::on_accept(order, quantity);
+  listener_.on_accept(order);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_accept_stop(
+  const OrderPtr& order)
+{
+  Base::on_accept_stop(order);
+  listener_.on_accept(order);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_trigger_stop(
+  const OrderPtr& order)
+{
+  Base::on_trigger_stop(order);
+  listener_.on_trigger_stop(order);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_reject(
+  const OrderPtr& order, const char* reason)
+{
+  listener_.on_reject(order, reason);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_fill(
+  const OrderPtr& order,
+  const OrderPtr& matched_order,
+  Quantity fill_qty,
+  Price fill_price,
+  bool inbound_order_filled,
+  bool matched_order_filled)
+{
+  Base::on_fill(order, matched_order, fill_qty, fill_price,
+    inbound_order_filled, matched_order_filled);
+  listener_.on_fill(order, matched_order, fill_qty, fill_price);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_cancel(
+  const OrderPtr& order, Quantity quantity)
+{
+  Base::on_cancel(order, quantity);
+  listener_.on_cancel(order);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_cancel_stop(
+  const OrderPtr& order)
+{
+  Base::on_cancel_stop(order);
+  listener_.on_cancel(order);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_cancel_reject(
+  const OrderPtr& order, const char* reason)
+{
+  listener_.on_cancel_reject(order, reason);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_replace(
+  const OrderPtr& order,
+  Quantity current_qty,
+  Quantity new_qty,
+  Price new_price)
+{
+  Base::on_replace(order, current_qty, new_qty, new_price);
+  listener_.on_replace(order, int64_t(new_qty) - int64_t(current_qty),
+    new_price);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_replace_reject(
+  const OrderPtr& order, const char* reason)
+{
+  listener_.on_replace_reject(order, reason);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_trade(
+  const BookBase* book, Quantity qty, Price price)
+{
+  listener_.on_trade(this, qty, price);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_order_book_change()
+{
+  // publishes depth and BBO changes first, as a runtime listener sees them
+  Base::on_order_book_change();
+  listener_.on_order_book_change(this);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_depth_change(
+  const DepthTracker* depth)
+{
+  listener_.on_depth_change(this, depth);
+}
+
+template <class OrderPtr, class Listener, int SIZE, class Storage>
+void
+StaticDepthOrderBook<OrderPtr, Listener, SIZE, Storage>::on_bbo_change(
+  const DepthTracker* depth)
+{
+  listener_.on_bbo_change(this, depth);
+}
+
+} }
@@ -0,0 +1,385 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include "comparable_price.h"
+#include "price_ladder.h"
+#include <vector>
+#include <iterator>
+#include <cstddef>
+#include <utility>
+
+namespace liquibook { namespace book {
+
+/// @brief Container for stop orders waiting for the market to reach their
+///        trigger price.
+///
+/// Stops are kept in buckets, one per trigger price, and each bucket is a
+/// FIFO list of slots in a slab that is reused as stops come and go.  A
+/// stop is named by its slot, which does not change while it waits, so
+/// erasing one given its slot takes constant time.  release() hands over
+/// every stop whose trigger has been reached and drops the buckets that
+/// held them, one bucket at a time rather than one stop at a time.  The
+/// Levels policy (see price_ladder.h) selects the container that maps
+/// trigger prices to buckets.
+///
+/// Trigger prices are ordered so the first to be reached comes first: a
+/// stop book of buy stops is keyed with sell-side ComparablePrices, lowest
+/// trigger first, and one of sell stops with buy-side ComparablePrices.
+/// Iteration follows that order, and within a trigger price arrival order.
+/// Dereferencing an iterator yields an Entry whose first is the trigger
+/// price and second the tracker, as a std::multimap would.
+template <class Tracker, class Levels = OrderedLevels>
+class StopBook {
+public:
+  typedef size_t Slot;
+  static const Slot npos = Slot(-1);
+
+private:
+  /// @brief the stops at one trigger price, in arrival order.
+  struct Bucket {
+    Bucket()
+      : head(npos)
+      , tail(npos)
+    {
+    }
+
+    Slot head;
+    Slot tail;
+  };
+  typedef typename Levels::template Bind<Bucket>::LevelMap BucketMap;
+
+public:
+  /// @brief a stop order in the book.
+  struct Entry {
+    template <class T>
+    Entry(const ComparablePrice & key, T && tracker)
+      : first(key)
+      , second(std::forward<T>(tracker))
+      , prev(npos)
+      , next(npos)
+    {
+    }
+
+    ComparablePrice first;
+    Tracker second;
+    typename BucketMap::iterator bucket;
+    Slot prev;
+    Slot next;  // or the next free slot once the entry has been erased
+  };
+
+  /// @brief forward iterator over the stops, first to be triggered first.
+  class const_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef const Entry value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Entry * pointer;
+    typedef const Entry & reference;
+
+    const_iterator()
+      : book_(nullptr)
+      , slot_(npos)
+    {
+    }
+
+    const_iterator(const StopBook * book,
+                   typename BucketMap::const_iterator bucket)
+      : book_(book)
+      , bucket_(bucket)
+      , slot_(bucket == book->buckets_.end() ? npos : bucket->second.head)
+    {
+    }
+
+    reference operator *() const
+    {
+      return book_->entries_[slot_];
+    }
+
+    pointer operator ->() const
+    {
+      return &**this;
+    }
+
+    const_iterator & operator ++()
+    {
+      slot_ = book_->entries_[slot_].next;
+      if(slot_ == npos)
+      {
+        ++bucket_;
+        slot_ = bucket_ == book_->buckets_.end() ? npos : bucket_->second.head;
+      }
+      return *this;
+    }
+
+    const_iterator operator ++(int)
+    {
+      const_iterator result(*this);
+      ++*this;
+      return result;
+    }
+
+    bool operator ==(const const_iterator & rhs) const
+    {
+      return slot_ == rhs.slot_;
+    }
+
+    bool operator !=(const const_iterator & rhs) const
+    {
+      return !(*this == rhs);
+    }
+
+  private:
+    const StopBook * book_;
+    typename BucketMap::const_iterator bucket_;
+    Slot slot_;
+  };
+  typedef const_iterator iterator;
+  typedef ComparablePrice key_type;
+  typedef Tracker mapped_type;
+  typedef Entry value_type;
+  typedef size_t size_type;
+
+  /// @brief construct an empty stop book
+  StopBook();
+
+  /// @brief add a stop behind all other stops with the same trigger price.
+  /// @return the stop's slot
+  template <class T>
+  Slot insert(const ComparablePrice & trigger, T && tracker);
+
+  /// @brief remove a stop
+  void erase(Slot slot);
+
+  /// @brief the stop in a slot
+  Entry & at(Slot slot);
+  const Entry & at(Slot slot) const;
+
+  /// @brief remove every stop whose trigger price does not come after
+  ///        until, in order.
+  /// @param visit called with each stop's tracker before it is removed
+  /// @return the number of stops released
+  template <class Visitor>
+  size_t release(const ComparablePrice & until, Visitor visit);
+
+  /// @brief remove all stops
+  void clear();
+
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  /// @brief number of stops in the book
+  size_t size() const;
+
+  /// @brief are there no stops in the book?
+  bool empty() const;
+
+  /// @brief number of distinct trigger prices in the book
+  size_t bucket_count() const;
+
+  /// @brief index buckets on a price band, if the Levels policy supports it.
+  /// Only allowed while the book is empty.
+  void set_price_band(bool buy_side, const PriceBand & band);
+
+private:
+  /// @brief put a slot on the free list
+  void free_slot(Slot slot);
+
+  BucketMap buckets_;
+  std::vector<Entry> entries_;
+  Slot free_;
+  size_t size_;
+};
+
+template <class Tracker, class Levels>
+const typename StopBook<Tracker, Levels>::Slot StopBook<Tracker, Levels>::npos;
+
+template <class Tracker, class Levels>
+StopBook<Tracker, Levels>::StopBook()
+: free_(npos),
+  size_(0)
+{
+}
+
+template <class Tracker, class Levels>
+template <class T>
+typename StopBook<Tracker, Levels>::Slot
+StopBook<Tracker, Levels>::insert(const ComparablePrice & trigger, T && tracker)
+{
+  Slot slot;
+  if(free_ != npos)
+  {
+    slot = free_;
+    Entry & entry = entries_[slot];
+    free_ = entry.next;
+    entry.first = trigger;
+    entry.second = std::forward<T>(tracker);
+  }
+  else
+  {
+    slot = entries_.size();
+    entries_.push_back(Entry(trigger, std::forward<T>(tracker)));
+  }
+  typename BucketMap::iterator bucket =
+    buckets_.insert(std::make_pair(trigger, Bucket())).first;
+  Entry & entry = entries_[slot];
+  entry.bucket = bucket;
+  entry.prev = bucket->second.tail;
+  entry.next = npos;
+  if(entry.prev == npos)
+  {
+    bucket->second.head = slot;
+  }
+  else
+  {
+    entries_[entry.prev].next = slot;
+  }
+  bucket->second.tail = slot;
+  ++size_;
+  return slot;
+}
+
+template <class Tracker, class Levels>
+void
+StopBook<Tracker, Levels>::erase(Slot slot)
+{
+  Entry & entry = entries_[slot];
+  Bucket & bucket = entry.bucket->second;
+  if(entry.prev == npos)
+  {
+    bucket.head = entry.next;
+  }
+  else
+  {
+    entries_[entry.prev].next = entry.next;
+  }
+  if(entry.next == npos)
+  {
+    bucket.tail = entry.prev;
+  }
+  else
+  {
+    entries_[entry.next].prev = entry.prev;
+  }
+  if(bucket.head == npos)
+  {
+    buckets_.erase(entry.bucket);
+  }
+  free_slot(slot);
+  --size_;
+}
+
+template <class Tracker, class Levels>
+typename StopBook<Tracker, Levels>::Entry &
+StopBook<Tracker, Levels>::at(Slot slot)
+{
+  return entries_[slot];
+}
+
+template <class Tracker, class Levels>
+const typename StopBook<Tracker, Levels>::Entry &
+StopBook<Tracker, Levels>::at(Slot slot) const
+{
+  return entries_[slot];
+}
+
+template <class Tracker, class Levels>
+template <class Visitor>
+size_t
+StopBook<Tracker, Levels>::release(const ComparablePrice & until, Visitor visit)
+{
+  size_t released = 0;
+  while(!buckets_.empty())
+  {
+    typename BucketMap::iterator bucket = buckets_.begin();
+    if(until < bucket->first)
+    {
+      break;
+    }
+    Slot slot = bucket->second.head;
+    while(slot != npos)
+    {
+      Slot next = entries_[slot].next;
+      visit(entries_[slot].second);
+      free_slot(slot);
+      ++released;
+      slot = next;
+    }
+    buckets_.erase(bucket);
+  }
+  size_ -= released;
+  return released;
+}
+
+template <class Tracker, class Levels>
+void
+StopBook<Tracker, Levels>::free_slot(Slot slot)
+{
+  entries_[slot].next = free_;
+  free_ = slot;
+}
+
+template <class Tracker, class Levels>
+void
+StopBook<Tracker, Levels>::clear()
+{
+  buckets_.clear();
+  entries_.clear();
+  free_ = npos;
+  size_ = 0;
+}
+
+template <class Tracker, class Levels>
+typename StopBook<Tracker, Levels>::const_iterator
+StopBook<Tracker, Levels>::begin() const
+{
+  return const_iterator(this, buckets_.begin());
+}
+
+template <class Tracker, class Levels>
+typename StopBook<Tracker, Levels>::const_iterator
+StopBook<Tracker, Levels>::end() const
+{
+  return const_iterator(this, buckets_.end());
+}
+
+template <class Tracker, class Levels>
+size_t
+StopBook<Tracker, Levels>::size() const
+{
+  return size_;
+}
+
+template <class Tracker, class Levels>
+bool
+StopBook<Tracker, Levels>::empty() const
+{
+  return size_ == 0;
+}
+
+template <class Tracker, class Levels>
+size_t
+StopBook<Tracker, Levels>::bucket_count() const
+{
+  return buckets_.size();
+}
+
+template <class Tracker, class Levels>
+void
+StopBook<Tracker, Levels>::set_price_band(bool buy_side, const PriceBand & band)
+{
+  configure_price_band(buckets_, buy_side, band);
+}
+
+/// @brief index a StopBook's buckets on a band.
+template <class Tracker, class Levels>
+void
+configure_price_band(StopBook<Tracker, Levels> & stops,
+                     bool buy_side,
+                     const PriceBand & band)
+{
+  stops.set_price_band(buy_side, band);
+}
+
+} }
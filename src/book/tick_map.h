@@ -0,0 +1,622 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include "comparable_price.h"
+#include "price_band.h"
+#include <map>
+#include <vector>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif // _MSC_VER
+
+namespace liquibook { namespace book {
+
+/// @brief Ordered map from ComparablePrice to Value that stores prices on
+///        a PriceBand in a flat array.
+///
+/// Prices on the band are stored at their tick offset in a vector, and a
+/// bitmap records which of them are present, so finding a price is array
+/// indexing and finding the next price scans the bitmap a word at a time.
+/// Other prices (market orders, prices outside the band or between its
+/// ticks) are kept in a std::map.  Iteration merges the two in
+/// ComparablePrice order, so the container behaves like a std::map.
+///
+/// Until a band is set, everything is kept in the std::map.  The band can
+/// only be changed while the map is empty.
+///
+/// Iterators remain valid until the element they refer to is erased.
+template <class Value>
+class TickMap {
+  typedef std::map<ComparablePrice, Value> SpillMap;
+  static const size_t npos = size_t(-1);
+
+public:
+  typedef ComparablePrice key_type;
+  typedef Value mapped_type;
+  typedef typename SpillMap::value_type value_type;
+  typedef size_t size_type;
+
+  /// @brief bidirectional iterator in ComparablePrice order.
+  template <class MapT, class SpillIter, class V>
+  class Iterator {
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef V value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef V * pointer;
+    typedef V & reference;
+
+    Iterator()
+      : map_(nullptr)
+      , rank_(npos)
+    {
+    }
+
+    /// @brief allow iterator to const_iterator conversion.
+    template <class M, class S, class W>
+    Iterator(const Iterator<M, S, W> & rhs)
+      : map_(rhs.map_)
+      , rank_(rhs.rank_)
+      , spill_(rhs.spill_)
+    {
+    }
+
+    reference operator *() const
+    {
+      return rank_ == npos ? *spill_ : map_->slots_[rank_];
+    }
+
+    pointer operator ->() const
+    {
+      return &**this;
+    }
+
+    Iterator & operator ++()
+    {
+      const ComparablePrice & key = (**this).first;
+      size_t rank;
+      SpillIter spill;
+      if(rank_ == npos)
+      {
+        rank = map_->next_rank(map_->rank_after(key));
+        spill = spill_;
+        ++spill;
+      }
+      else
+      {
+        rank = map_->next_rank(rank_ + 1);
+        spill = map_->spill_.empty() ?
+          map_->spill_.end() : map_->spill_.upper_bound(key);
+      }
+      *this = map_->first_of(rank, spill);
+      return *this;
+    }
+
+    Iterator operator ++(int)
+    {
+      Iterator result(*this);
+      ++*this;
+      return result;
+    }
+
+    Iterator & operator --()
+    {
+      size_t rank;
+      SpillIter spill;
+      if(rank_ == npos && spill_ == map_->spill_.end())
+      {
+        rank = map_->prev_rank(map_->slots_.size());
+        spill = spill_;
+      }
+      else if(rank_ == npos)
+      {
+        rank = map_->prev_rank(map_->rank_from(spill_->first));
+        spill = spill_;
+      }
+      else
+      {
+        rank = map_->prev_rank(rank_);
+        spill = map_->spill_.lower_bound(map_->slots_[rank_].first);
+      }
+      // the last spilled price before this position, if any
+      bool have_spill = spill != map_->spill_.begin();
+      if(have_spill)
+      {
+        --spill;
+      }
+      if(rank != npos &&
+        (!have_spill || spill->first < map_->slots_[rank].first))
+      {
+        rank_ = rank;
+      }
+      else
+      {
+        rank_ = npos;
+        spill_ = spill;
+      }
+      return *this;
+    }
+
+    Iterator operator --(int)
+    {
+      Iterator result(*this);
+      --*this;
+      return result;
+    }
+
+    bool operator ==(const Iterator & rhs) const
+    {
+      return rank_ == rhs.rank_ && (rank_ != npos || spill_ == rhs.spill_);
+    }
+
+    bool operator !=(const Iterator & rhs) const
+    {
+      return !(*this == rhs);
+    }
+
+  private:
+    template <class M, class S, class W> friend class Iterator;
+    friend class TickMap;
+
+    Iterator(MapT * map, size_t rank, SpillIter spill)
+      : map_(map)
+      , rank_(rank)
+      , spill_(spill)
+    {
+    }
+
+    MapT * map_;
+    size_t rank_;      // position on the band, or npos if spilled
+    SpillIter spill_;  // position in the spill map when rank_ is npos
+  };
+
+  typedef Iterator<TickMap, typename SpillMap::iterator, value_type> iterator;
+  typedef Iterator<const TickMap, typename SpillMap::const_iterator,
+    const value_type> const_iterator;
+
+  /// @brief construct an empty map with no band.
+  TickMap();
+
+  /// @brief index prices on a band.
+  /// @param buy_side true if this map holds buy side prices
+  /// @param band the prices to index; an empty band indexes nothing
+  /// @throws std::runtime_error if the map is not empty
+  void set_band(bool buy_side, const PriceBand & band);
+
+  /// @brief access the band
+  const PriceBand & band() const;
+
+  /// @brief insert if the key is not already present
+  std::pair<iterator, bool> insert(const value_type & value);
+
+  /// @brief insert, with the same (ignored) hint std::map accepts
+  iterator insert(const_iterator hint, const value_type & value);
+
+  /// @brief remove an element
+  void erase(iterator pos);
+
+  /// @brief remove the element with this key, if any
+  /// @return the number of elements removed
+  size_t erase(const ComparablePrice & key);
+
+  /// @brief remove all elements
+  void clear();
+
+  iterator find(const ComparablePrice & key);
+  const_iterator find(const ComparablePrice & key) const;
+  iterator lower_bound(const ComparablePrice & key);
+  const_iterator lower_bound(const ComparablePrice & key) const;
+  iterator upper_bound(const ComparablePrice & key);
+  const_iterator upper_bound(const ComparablePrice & key) const;
+
+  iterator begin();
+  iterator end();
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  /// @brief number of elements
+  size_t size() const;
+
+  /// @brief are there no elements?
+  bool empty() const;
+
+private:
+  /// @brief rank on the band of this key, or npos if it is not on the band
+  size_t rank_of(const ComparablePrice & key) const;
+  /// @brief lowest rank whose key is greater than this key
+  size_t rank_after(const ComparablePrice & key) const;
+  /// @brief lowest rank whose key is not less than this key
+  size_t rank_from(const ComparablePrice & key) const;
+  /// @brief lowest occupied rank at or after this one, or npos
+  size_t next_rank(size_t rank) const;
+  /// @brief highest occupied rank before this one, or npos
+  size_t prev_rank(size_t rank) const;
+
+  /// @brief the earlier of an occupied rank and a spill map position
+  iterator first_of(size_t rank, typename SpillMap::iterator spill);
+  const_iterator first_of(size_t rank,
+    typename SpillMap::const_iterator spill) const;
+
+  static size_t lowest_bit(uint64_t word);
+  static size_t highest_bit(uint64_t word);
+
+  PriceBand band_;
+  bool buy_side_;
+  std::vector<value_type> slots_;
+  std::vector<uint64_t> occupied_;
+  size_t band_size_;
+  SpillMap spill_;
+};
+
+template <class Value>
+TickMap<Value>::TickMap()
+: buy_side_(false),
+  band_size_(0)
+{
+}
+
+template <class Value>
+void
+TickMap<Value>::set_band(bool buy_side, const PriceBand & band)
+{
+  if(!empty())
+  {
+    throw std::runtime_error("Price band can only be set on an empty map");
+  }
+  band_ = band;
+  buy_side_ = buy_side;
+  size_t ticks = band.ticks();
+  std::vector<value_type> slots;
+  slots.reserve(ticks);
+  for(size_t rank = 0; rank < ticks; ++rank)
+  {
+    // ComparablePrice order: best price at rank 0
+    Price price = buy_side ? band.high() - rank * band.tick()
+                           : band.low() + rank * band.tick();
+    slots.emplace_back(ComparablePrice(buy_side, price), Value());
+  }
+  slots_.swap(slots);
+  occupied_.assign((ticks + 63) / 64, 0);
+}
+
+template <class Value>
+const PriceBand &
+TickMap<Value>::band() const
+{
+  return band_;
+}
+
+template <class Value>
+size_t
+TickMap<Value>::rank_of(const ComparablePrice & key) const
+{
+  if(key.isMarket() || !band_.contains(key.price()))
+  {
+    return npos;
+  }
+  size_t offset = size_t((key.price() - band_.low()) / band_.tick());
+  return buy_side_ ? slots_.size() - 1 - offset : offset;
+}
+
+template <class Value>
+size_t
+TickMap<Value>::rank_after(const ComparablePrice & key) const
+{
+  if(slots_.empty() || key.isMarket())
+  {
+    return 0;
+  }
+  Price price = key.price();
+  size_t ticks = slots_.size();
+  if(buy_side_)
+  {
+    // ranks after this key have lower prices
+    if(price > band_.high())
+    {
+      return 0;
+    }
+    Price past = (band_.high() - price) / band_.tick() + 1;
+    return past < ticks ? size_t(past) : ticks;
+  }
+  if(price < band_.low())
+  {
+    return 0;
+  }
+  Price past = (price - band_.low()) / band_.tick() + 1;
+  return past < ticks ? size_t(past) : ticks;
+}
+
+template <class Value>
+size_t
+TickMap<Value>::rank_from(const ComparablePrice & key) const
+{
+  size_t rank = rank_of(key);
+  return rank == npos ? rank_after(key) : rank;
+}
+
+template <class Value>
+size_t
+TickMap<Value>::lowest_bit(uint64_t word)
+{
+#ifdef _MSC_VER
+  unsigned long bit;
+  _BitScanForward64(&bit, word);
+  return bit;
+#else // _MSC_VER
+  return size_t(__builtin_ctzll(word));
+#endif // _MSC_VER
+}
+
+template <class Value>
+size_t
+TickMap<Value>::highest_bit(uint64_t word)
+{
+#ifdef _MSC_VER
+  unsigned long bit;
+  _BitScanReverse64(&bit, word);
+  return bit;
+#else // _MSC_VER
+  return size_t(63 - __builtin_clzll(word));
+#endif // _MSC_VER
+}
+
+template <class Value>
+size_t
+TickMap<Value>::next_rank(size_t rank) const
+{
+  if(band_size_ == 0 || rank >= slots_.size())
+  {
+    return npos;
+  }
+  size_t index = rank / 64;
+  uint64_t word = occupied_[index] & (~uint64_t(0) << (rank % 64));
+  while(word == 0)
+  {
+    if(++index == occupied_.size())
+    {
+      return npos;
+    }
+    word = occupied_[index];
+  }
+  return index * 64 + lowest_bit(word);
+}
+
+template <class Value>
+size_t
+TickMap<Value>::prev_rank(size_t rank) const
+{
+  if(band_size_ == 0 || rank == 0)
+  {
+    return npos;
+  }
+  --rank;
+  size_t index = rank / 64;
+  uint64_t word = occupied_[index] & (~uint64_t(0) >> (63 - rank % 64));
+  while(word == 0)
+  {
+    if(index-- == 0)
+    {
+      return npos;
+    }
+    word = occupied_[index];
+  }
+  return index * 64 + highest_bit(word);
+}
+
+template <class Value>
+typename TickMap<Value>::iterator
+TickMap<Value>::first_of(size_t rank, typename SpillMap::iterator spill)
+{
+  if(rank != npos &&
+    (spill == spill_.end() || slots_[rank].first < spill->first))
+  {
+    return iterator(this, rank, spill_.end());
+  }
+  return iterator(this, npos, spill);
+}
+
+template <class Value>
+typename TickMap<Value>::const_iterator
+TickMap<Value>::first_of(size_t rank,
+  typename SpillMap::const_iterator spill) const
+{
+  if(rank != npos &&
+    (spill == spill_.end() || slots_[rank].first < spill->first))
+  {
+    return const_iterator(this, rank, spill_.end());
+  }
+  return const_iterator(this, npos, spill);
+}
+
+template <class Value>
+std::pair<typename TickMap<Value>::iterator, bool>
+TickMap<Value>::insert(const value_type & value)
+{
+  size_t rank = rank_of(value.first);
+  if(rank == npos)
+  {
+    std::pair<typename SpillMap::iterator, bool> result = spill_.insert(value);
+    return std::make_pair(iterator(this, npos, result.first), result.second);
+  }
+  uint64_t bit = uint64_t(1) << (rank % 64);
+  uint64_t & word = occupied_[rank / 64];
+  bool inserted = (word & bit) == 0;
+  if(inserted)
+  {
+    word |= bit;
+    slots_[rank].second = value.second;
+    ++band_size_;
+  }
+  return std::make_pair(iterator(this, rank, spill_.end()), inserted);
+}
+
+template <class Value>
+typename TickMap<Value>::iterator
+TickMap<Value>::insert(const_iterator hint, const value_type & value)
+{
+  return insert(value).first;
+}
+
+template <class Value>
+void
+TickMap<Value>::erase(iterator pos)
+{
+  if(pos.rank_ == npos)
+  {
+    spill_.erase(pos.spill_);
+  }
+  else
+  {
+    occupied_[pos.rank_ / 64] &= ~(uint64_t(1) << (pos.rank_ % 64));
+    // release whatever the value holds
+    slots_[pos.rank_].second = Value();
+    --band_size_;
+  }
+}
+
+template <class Value>
+size_t
+TickMap<Value>::erase(const ComparablePrice & key)
+{
+  iterator pos = find(key);
+  if(pos == end())
+  {
+    return 0;
+  }
+  erase(pos);
+  return 1;
+}
+
+template <class Value>
+void
+TickMap<Value>::clear()
+{
+  for(size_t rank = next_rank(0); rank != npos; rank = next_rank(rank + 1))
+  {
+    slots_[rank].second = Value();
+  }
+  occupied_.assign(occupied_.size(), 0);
+  band_size_ = 0;
+  spill_.clear();
+}
+
+template <class Value>
+typename TickMap<Value>::iterator
+TickMap<Value>::find(const ComparablePrice & key)
+{
+  size_t rank = rank_of(key);
+  if(rank == npos)
+  {
+    return iterator(this, npos, spill_.find(key));
+  }
+  if(occupied_[rank / 64] & (uint64_t(1) << (rank % 64)))
+  {
+    return iterator(this, rank, spill_.end());
+  }
+  return end();
+}
+
+template <class Value>
+typename TickMap<Value>::const_iterator
+TickMap<Value>::find(const ComparablePrice & key) const
+{
+  size_t rank = rank_of(key);
+  if(rank == npos)
+  {
+    return const_iterator(this, npos, spill_.find(key));
+  }
+  if(occupied_[rank / 64] & (uint64_t(1) << (rank % 64)))
+  {
+    return const_iterator(this, rank, spill_.end());
+  }
+  return end();
+}
+
+template <class Value>
+typename TickMap<Value>::iterator
+TickMap<Value>::lower_bound(const ComparablePrice & key)
+{
+  return first_of(next_rank(rank_from(key)), spill_.lower_bound(key));
+}
+
+template <class Value>
+typename TickMap<Value>::const_iterator
+TickMap<Value>::lower_bound(const ComparablePrice & key) const
+{
+  return first_of(next_rank(rank_from(key)), spill_.lower_bound(key));
+}
+
+template <class Value>
+typename TickMap<Value>::iterator
+TickMap<Value>::upper_bound(const ComparablePrice & key)
+{
+  return first_of(next_rank(rank_after(key)), spill_.upper_bound(key));
+}
+
+template <class Value>
+typename TickMap<Value>::const_iterator
+TickMap<Value>::upper_bound(const ComparablePrice & key) const
+{
+  return first_of(next_rank(rank_after(key)), spill_.upper_bound(key));
+}
+
+template <class Value>
+typename TickMap<Value>::iterator
+TickMap<Value>::begin()
+{
+  return first_of(next_rank(0), spill_.begin());
+}
+
+template <class Value>
+typename TickMap<Value>::iterator
+TickMap<Value>::end()
+{
+  return iterator(this, npos, spill_.end());
+}
+
+template <class Value>
+typename TickMap<Value>::const_iterator
+TickMap<Value>::begin() const
+{
+  return first_of(next_rank(0), spill_.begin());
+}
+
+template <class Value>
+typename TickMap<Value>::const_iterator
+TickMap<Value>::end() const
+{
+  return const_iterator(this, npos, spill_.end());
+}
+
+template <class Value>
+size_t
+TickMap<Value>::size() const
+{
+  return band_size_ + spill_.size();
+}
+
+template <class Value>
+bool
+TickMap<Value>::empty() const
+{
+  return size() == 0;
+}
+
+/// @brief index a TickMap's levels on a band.
+template <class Value>
+void
+configure_price_band(TickMap<Value> & map,
+                     bool buy_side,
+                     const PriceBand & band)
+{
+  map.set_band(buy_side, band);
+}
+
+} }
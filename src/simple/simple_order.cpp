@@ -33,47 +33,6 @@ SimpleOrder::state() const
   return state_;
 }
 
-bool 
-SimpleOrder::is_buy() const
-{
-  return is_buy_;
-}
-
-book::Price
-SimpleOrder::price() const
-{
-  return price_;
-}
-
-book::Price
-SimpleOrder::stop_price() const
-{
-  return stop_price_;
-}
-
-book::OrderConditions
-SimpleOrder::conditions() const
-{
-  return conditions_;
-}
-
-bool
-SimpleOrder::all_or_none() const
-{
-  return (conditions_ & book::OrderCondition::oc_all_or_none) != 0;
-}
-
-bool
-SimpleOrder::immediate_or_cancel() const
-{
-  return (conditions_ & book::OrderCondition::oc_immediate_or_cancel) != 0;
-}
-book::Quantity
-SimpleOrder::order_qty() const
-{
-  return order_qty_;
-}
-
 book::Quantity
 SimpleOrder::open_qty() const
 {
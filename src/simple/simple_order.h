@@ -17,8 +17,8 @@ enum OrderState {
   os_rejected
 };
 
-/// @brief impelementation of the Order interface for testing purposes.
-class SimpleOrder : public book::Order {
+/// @brief implementation of the Order concept for testing purposes.
+class SimpleOrder final : public book::Order {
 public:
   SimpleOrder(bool is_buy,
               book::Price price,
@@ -30,21 +30,21 @@ public:
   const OrderState& state() const;
 
   /// @brief is this order a buy?
-  virtual bool is_buy() const;
+  bool is_buy() const;
 
   /// @brief get the limit price of this order
-  virtual book::Price price() const;
+  book::Price price() const;
 
-  virtual book::Price stop_price()const;
+  book::Price stop_price() const;
 
   /// @brief get the quantity of this order
-  virtual book::Quantity order_qty() const;
+  book::Quantity order_qty() const;
 
   /// @brief get the open quantity of this order
-  virtual book::Quantity open_qty() const;
+  book::Quantity open_qty() const;
 
   /// @brief get the filled quantity of this order
-  virtual const book::Quantity& filled_qty() const;
+  const book::Quantity& filled_qty() const;
 
   /// @brief get the total filled cost of this order
   const book::Cost& filled_cost() const;
@@ -53,21 +53,21 @@ public:
   /// @param fill_qty the number of shares in this fill
   /// @param fill_cost the total amount of this fill
   /// @fill_id the unique identifier of this fill
-  virtual void fill(book::Quantity fill_qty, 
-                    book::Cost fill_cost,
-                    book::FillId fill_id);
+  void fill(book::Quantity fill_qty, 
+            book::Cost fill_cost,
+            book::FillId fill_id);
 
   /// @brief get order conditions as a bit mask
-  virtual book::OrderConditions conditions() const;
+  book::OrderConditions conditions() const;
 
   /// @brief if no trades should happen until the order
   /// can be filled completely.
   /// Note: one or more trades may be used to fill the order.
-  virtual bool all_or_none() const;
+  bool all_or_none() const;
 
   /// @brief After generating as many trades as possible against
   /// orders already on the market, cancel any remaining quantity.
-  virtual bool immediate_or_cancel() const;
+  bool immediate_or_cancel() const;
 
   /// @brief exchange accepted this order
   void accept();
@@ -94,4 +94,53 @@ public:
   const uint32_t order_id_;
 };
 
+inline
+bool 
+SimpleOrder::is_buy() const
+{
+  return is_buy_;
+}
+
+inline
+book::Price
+SimpleOrder::price() const
+{
+  return price_;
+}
+
+inline
+book::Price
+SimpleOrder::stop_price() const
+{
+  return stop_price_;
+}
+
+inline
+book::OrderConditions
+SimpleOrder::conditions() const
+{
+  return conditions_;
+}
+
+inline
+bool
+SimpleOrder::all_or_none() const
+{
+  return (conditions_ & book::OrderCondition::oc_all_or_none) != 0;
+}
+
+inline
+bool
+SimpleOrder::immediate_or_cancel() const
+{
+  return (conditions_ & book::OrderCondition::oc_immediate_or_cancel) != 0;
+}
+
+inline
+book::Quantity
+SimpleOrder::order_qty() const
+{
+  return order_qty_;
+}
+
 } }
@@ -10,8 +10,8 @@
 namespace liquibook { namespace simple {
 
 // @brief binding of DepthOrderBook template with SimpleOrder* order pointer.
-template <int SIZE = 5>
-class SimpleOrderBook : public book::DepthOrderBook<SimpleOrder*, SIZE> {
+template <int SIZE = 5, class Storage = book::DefaultStorage>
+class SimpleOrderBook : public book::DepthOrderBook<SimpleOrder*, SIZE, Storage> {
 public:
   typedef book::Callback<SimpleOrder*> SimpleCallback;
   typedef uint32_t FillId;
@@ -24,17 +24,17 @@ private:
   FillId fill_id_;
 };
 
-template <int SIZE>
-SimpleOrderBook<SIZE>::SimpleOrderBook() 
+template <int SIZE, class Storage>
+SimpleOrderBook<SIZE, Storage>::SimpleOrderBook() 
 : fill_id_(0)
 {
 }
 
-template <int SIZE>
+template <int SIZE, class Storage>
 inline void
-SimpleOrderBook<SIZE>::perform_callback(SimpleCallback& cb)
+SimpleOrderBook<SIZE, Storage>::perform_callback(SimpleCallback& cb)
 {
-  book::DepthOrderBook<SimpleOrder*, SIZE>::perform_callback(cb);
+  book::DepthOrderBook<SimpleOrder*, SIZE, Storage>::perform_callback(cb);
   switch(cb.type) {
     case SimpleCallback::cb_order_accept:
       cb.order->accept();
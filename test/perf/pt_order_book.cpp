@@ -2,10 +2,13 @@
 // All rights reserved.
 // See the file license.txt for licensing information.
 #include <simple/simple_order_book.h>
+#include <book/static_order_book.h>
 #include <book/types.h>
 
 #include <iostream>
 #include <stdexcept>
+#include <vector>
+#include <algorithm>
 #include <stdlib.h>
 #include <time.h>
 
@@ -15,13 +18,110 @@ using namespace liquibook::book;
 typedef simple::SimpleOrderBook<5> FullDepthOrderBook;
 typedef simple::SimpleOrderBook<1> BboOrderBook;
 typedef book::OrderBook<simple::SimpleOrder*> NoDepthOrderBook;
+typedef simple::SimpleOrderBook<5, book::LadderStorage> LadderFullDepthOrderBook;
+typedef simple::SimpleOrderBook<1, book::LadderStorage> LadderBboOrderBook;
+typedef book::OrderBook<simple::SimpleOrder*, book::LadderStorage>
+  LadderNoDepthOrderBook;
+typedef simple::SimpleOrderBook<5, book::TickLadderStorage>
+  TickFullDepthOrderBook;
+typedef simple::SimpleOrderBook<1, book::TickLadderStorage> TickBboOrderBook;
+typedef book::OrderBook<simple::SimpleOrder*, book::TickLadderStorage>
+  TickNoDepthOrderBook;
+typedef simple::SimpleOrderBook<5, book::PooledStorage>
+  PooledFullDepthOrderBook;
+
+typedef simple::SimpleOrder* OrderPtr;
+typedef book::DepthOrderBook<OrderPtr> RuntimeDepthBase;
+typedef book::OrderBook<OrderPtr> RuntimeBase;
+
+// Counts the events a feed would publish.  The runtime and static
+// listener books below do the same counting, so the difference between
+// them is the cost of dispatch.
+struct EventCounts {
+  EventCounts() : accepts(0), fills(0), trades(0), changes(0) {}
+  uint64_t accepts;
+  uint64_t fills;
+  uint64_t trades;
+  uint64_t changes;
+};
+
+class RuntimeCounter : public OrderListener<OrderPtr>,
+                       public TradeListener<RuntimeBase>,
+                       public OrderBookListener<RuntimeBase>,
+                       public DepthListener<RuntimeDepthBase> {
+public:
+  virtual void on_accept(const OrderPtr&) { ++counts.accepts; }
+  virtual void on_reject(const OrderPtr&, const char*) {}
+  virtual void on_fill(const OrderPtr&, const OrderPtr&, Quantity, Price) {
+    ++counts.fills;
+  }
+  virtual void on_cancel(const OrderPtr&) {}
+  virtual void on_cancel_reject(const OrderPtr&, const char*) {}
+  virtual void on_replace(const OrderPtr&, const int64_t&, Price) {}
+  virtual void on_replace_reject(const OrderPtr&, const char*) {}
+  virtual void on_trade(const RuntimeBase*, Quantity, Price) {
+    ++counts.trades;
+  }
+  virtual void on_order_book_change(const RuntimeBase*) {}
+  virtual void on_depth_change(const RuntimeDepthBase*,
+                               const RuntimeDepthBase::DepthTracker*) {
+    ++counts.changes;
+  }
+  EventCounts counts;
+};
+
+class StaticCounter : public book::StaticListener {
+public:
+  void on_accept(const OrderPtr&) { ++counts.accepts; }
+  void on_fill(const OrderPtr&, const OrderPtr&, Quantity, Price) {
+    ++counts.fills;
+  }
+  template <class Book>
+  void on_trade(const Book*, Quantity, Price) { ++counts.trades; }
+  template <class Book, class Depth>
+  void on_depth_change(const Book*, const Depth*) { ++counts.changes; }
+  EventCounts counts;
+};
+
+// Book with runtime listeners attached
+class RuntimeListenerDepthOrderBook : public RuntimeDepthBase {
+public:
+  RuntimeListenerDepthOrderBook() {
+    set_order_listener(&counter_);
+    set_trade_listener(&counter_);
+    set_order_book_listener(&counter_);
+    set_depth_listener(&counter_);
+  }
+private:
+  RuntimeCounter counter_;
+};
+
+class RuntimeListenerNoDepthOrderBook : public RuntimeBase {
+public:
+  RuntimeListenerNoDepthOrderBook() {
+    set_order_listener(&counter_);
+    set_trade_listener(&counter_);
+    set_order_book_listener(&counter_);
+  }
+private:
+  RuntimeCounter counter_;
+};
+
+typedef book::StaticDepthOrderBook<OrderPtr, StaticCounter>
+  StaticListenerDepthOrderBook;
+typedef book::StaticOrderBook<OrderPtr, StaticCounter>
+  StaticListenerNoDepthOrderBook;
+
+// Every price generated below is in this band
+const PriceBand band(1880, 1893, 1);
 
 template <class TypedOrderBook, class TypedOrder>
-int run_test(TypedOrderBook& order_book, TypedOrder** orders, clock_t end) {
+int run_test(TypedOrderBook& order_book, TypedOrder** orders,
+             const OrderConditions* conditions, clock_t end) {
   int count = 0;
   TypedOrder** pp_order = orders;
   do {
-    order_book.add(*pp_order);
+    order_book.add(*pp_order, conditions[pp_order - orders]);
     ++pp_order;
     if (*pp_order == nullptr) {
       return -1;
@@ -32,10 +132,13 @@ int run_test(TypedOrderBook& order_book, TypedOrder** orders, clock_t end) {
 }
 
 template <class TypedOrderBook>
-bool build_and_run_test(uint32_t dur_sec, uint32_t num_to_try) {
+bool build_and_run_test(uint32_t dur_sec, uint32_t num_to_try,
+                        const PriceBand& price_band, uint32_t aon_every) {
   std::cout << "trying run of " << num_to_try << " orders";
   TypedOrderBook order_book;
+  order_book.set_price_band(price_band);
   simple::SimpleOrder** orders = new simple::SimpleOrder*[num_to_try + 1];
+  std::vector<OrderConditions> conditions(num_to_try + 1, oc_no_conditions);
   
   for (uint32_t i = 0; i <= num_to_try; ++i) {
     bool is_buy((i % 2) == 0);
@@ -66,13 +169,16 @@ bool build_and_run_test(uint32_t dur_sec, uint32_t num_to_try) {
     
     Quantity qty = ((rand() % 10) + 1) * 100;
     orders[i] = new simple::SimpleOrder(is_buy, price, qty);
+    if (aon_every && (rand() % aon_every) == 0) {
+      conditions[i] = oc_all_or_none;
+    }
   }
   orders[num_to_try] = nullptr; // Final null
   
   clock_t start = clock();
   clock_t stop = start + (dur_sec * CLOCKS_PER_SEC);
 
-  int count = run_test(order_book, orders, stop);
+  int count = run_test(order_book, orders, &conditions[0], stop);
   for (uint32_t i = 0; i <= num_to_try; ++i) {
     delete orders[i];
   }
@@ -93,6 +199,85 @@ bool build_and_run_test(uint32_t dur_sec, uint32_t num_to_try) {
   return count > 0;
 }
 
+template <class TypedOrderBook>
+void run_until_complete(const char* description, uint32_t dur_sec,
+                        const PriceBand& price_band = PriceBand(),
+                        uint32_t aon_every = 0) {
+  std::cout << "testing order book " << description << std::endl;
+  uint32_t num_to_try = dur_sec * 125000;
+  while (!build_and_run_test<TypedOrderBook>(dur_sec, num_to_try,
+                                             price_band, aon_every)) {
+    num_to_try *= 2;
+  }
+}
+
+// Cancel every order in one deep queue, in random order, so most
+// cancels hit the middle of the queue.
+template <class TypedOrderBook>
+void run_cancel_test(const char* description, uint32_t queue_depth) {
+  TypedOrderBook order_book;
+  std::vector<simple::SimpleOrder*> orders;
+  orders.reserve(queue_depth);
+  for (uint32_t i = 0; i < queue_depth; ++i) {
+    orders.push_back(new simple::SimpleOrder(true, 1880, 100));
+    order_book.add(orders.back());
+  }
+  for (uint32_t i = queue_depth - 1; i > 0; --i) {
+    std::swap(orders[i], orders[rand() % (i + 1)]);
+  }
+
+  clock_t start = clock();
+  for (uint32_t i = 0; i < queue_depth; ++i) {
+    order_book.cancel(orders[i]);
+  }
+  clock_t elapsed = (std::max)(clock() - start, clock_t(1));
+
+  for (uint32_t i = 0; i < queue_depth; ++i) {
+    delete orders[i];
+  }
+  double secs = double(elapsed) / CLOCKS_PER_SEC;
+  std::cout << "Cancelled " << queue_depth << " orders " << description
+            << " in " << secs << " seconds, or "
+            << uint64_t(queue_depth / secs) << " cancels per sec"
+            << std::endl;
+}
+
+// Rest num_stops buy stops a few ticks above the market, then time the
+// one trade that triggers all of them.  Each triggered stop trades with
+// a deep ask above the stops, so the cascade stops there.
+template <class TypedOrderBook>
+void run_stop_storm_test(const char* description, uint32_t num_stops) {
+  TypedOrderBook order_book;
+  std::vector<simple::SimpleOrder*> orders;
+  orders.reserve(num_stops + 3);
+  orders.push_back(new simple::SimpleOrder(false, 1890, num_stops * 100));
+  order_book.add(orders.back());
+  orders.push_back(new simple::SimpleOrder(true, 1885, 1));
+  order_book.add(orders.back());
+  order_book.set_market_price(1880);
+  for (uint32_t i = 0; i < num_stops; ++i) {
+    orders.push_back(new simple::SimpleOrder(true, 0, 100, 1881 + i % 5));
+    order_book.add(orders.back());
+  }
+  orders.push_back(new simple::SimpleOrder(false, 1885, 1));
+
+  clock_t start = clock();
+  order_book.add(orders.back());
+  clock_t elapsed = (std::max)(clock() - start, clock_t(1));
+
+  if (!order_book.stopBids().empty() || !order_book.asks().empty()) {
+    throw std::runtime_error("stops were not all triggered");
+  }
+  for (size_t i = 0; i < orders.size(); ++i) {
+    delete orders[i];
+  }
+  double secs = double(elapsed) / CLOCKS_PER_SEC;
+  std::cout << "Triggered " << num_stops << " stops " << description
+            << " in " << secs << " seconds, or "
+            << uint64_t(num_stops / secs) << " stops per sec"
+            << std::endl;
+}
+
 int main(int argc, const char* argv[])
 {
   uint32_t dur_sec = 3;
@@ -106,41 +291,48 @@ int main(int argc, const char* argv[])
   
   srand(dur_sec);
 
-  {
-    std::cout << "testing order book with depth" << std::endl;
-    uint32_t num_to_try = dur_sec * 125000;
-    while (true) {
-      if (build_and_run_test<FullDepthOrderBook>(dur_sec, num_to_try)) {
-        break;
-      } else {
-        num_to_try *= 2;
-      }
-    }
-  }
+  run_until_complete<FullDepthOrderBook>("with depth", dur_sec);
+  run_until_complete<BboOrderBook>("with bbo", dur_sec);
+  run_until_complete<NoDepthOrderBook>("without depth", dur_sec);
+  run_until_complete<LadderFullDepthOrderBook>("with depth (ladder)", dur_sec);
+  run_until_complete<LadderBboOrderBook>("with bbo (ladder)", dur_sec);
+  run_until_complete<LadderNoDepthOrderBook>("without depth (ladder)", dur_sec);
+  run_until_complete<TickFullDepthOrderBook>("with depth (tick ladder)",
+                                             dur_sec, band);
+  run_until_complete<TickBboOrderBook>("with bbo (tick ladder)", dur_sec, band);
+  run_until_complete<TickNoDepthOrderBook>("without depth (tick ladder)",
+                                           dur_sec, band);
+  run_until_complete<PooledFullDepthOrderBook>("with depth (pooled)", dur_sec);
 
-  {
-    std::cout << "testing order book with bbo" << std::endl;
-    uint32_t num_to_try = dur_sec * 125000;
-    while (true) {
-      if (build_and_run_test<BboOrderBook>(dur_sec, num_to_try)) {
-        break;
-      } else {
-        num_to_try *= 2;
-      }
-    }
-  }
+  // About one order in four is all or none
+  run_until_complete<FullDepthOrderBook>("with depth and AON orders",
+                                         dur_sec, PriceBand(), 4);
+  run_until_complete<PooledFullDepthOrderBook>(
+    "with depth and AON orders (pooled)", dur_sec, PriceBand(), 4);
 
-  {
-    std::cout << "testing order book without depth" << std::endl;
-    uint32_t num_to_try = dur_sec * 125000;
-    while (true) {
-      if (build_and_run_test<NoDepthOrderBook>(dur_sec, num_to_try)) {
-        break;
-      } else {
-        num_to_try *= 2;
-      }
-    }
+  std::cout << "testing listener dispatch" << std::endl;
+  run_until_complete<RuntimeListenerDepthOrderBook>(
+    "with depth (runtime listeners)", dur_sec);
+  run_until_complete<StaticListenerDepthOrderBook>(
+    "with depth (static listeners)", dur_sec);
+  run_until_complete<RuntimeListenerNoDepthOrderBook>(
+    "without depth (runtime listeners)", dur_sec);
+  run_until_complete<StaticListenerNoDepthOrderBook>(
+    "without depth (static listeners)", dur_sec);
+
+  std::cout << "testing cancels from one price level" << std::endl;
+  for (uint32_t depth = 1000; depth <= 100000; depth *= 10) {
+    run_cancel_test<FullDepthOrderBook>("with depth", depth);
+    run_cancel_test<LadderFullDepthOrderBook>("with depth (ladder)", depth);
+    run_cancel_test<PooledFullDepthOrderBook>("with depth (pooled)", depth);
   }
 
+  std::cout << "testing stops triggered by one trade" << std::endl;
+  for (uint32_t stops = 1000; stops <= 100000; stops *= 10) {
+    run_stop_storm_test<FullDepthOrderBook>("with depth", stops);
+    run_stop_storm_test<NoDepthOrderBook>("without depth", stops);
+    run_stop_storm_test<LadderNoDepthOrderBook>("without depth (ladder)",
+                                                stops);
+  }
 }
 
@@ -0,0 +1,57 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+
+#include "ut_alloc_counter.h"
+#include <cstdlib>
+#include <new>
+
+// Count heap allocations made while counting is on.
+// These replace the global operators for the whole test program.
+namespace
+{
+  bool counting_allocations = false;
+  size_t allocation_count = 0;
+}
+
+void * operator new(size_t size)
+{
+  if(counting_allocations)
+  {
+    ++allocation_count;
+  }
+  void * block = std::malloc(size ? size : 1);
+  if(block == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return block;
+}
+
+void operator delete(void * block) noexcept
+{
+  std::free(block);
+}
+
+void operator delete(void * block, size_t) noexcept
+{
+  std::free(block);
+}
+
+namespace liquibook {
+namespace alloc_counter {
+
+void start()
+{
+  allocation_count = 0;
+  counting_allocations = true;
+}
+
+size_t stop()
+{
+  counting_allocations = false;
+  return allocation_count;
+}
+
+} // namespace alloc_counter
+} // namespace liquibook
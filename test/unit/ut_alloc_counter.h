@@ -0,0 +1,23 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+#pragma once
+
+#include <cstddef>
+
+namespace liquibook {
+
+/// @brief Heap allocation counting for the allocation tests.
+/// The counting global operator new and delete live in ut_alloc_counter.cpp,
+/// a translation unit of their own, so the compiler never sees a replaced
+/// operator new paired with its own operator delete.
+namespace alloc_counter {
+
+/// @brief start counting from zero
+void start();
+
+/// @brief stop counting and return the allocations made since start()
+size_t stop();
+
+} // namespace alloc_counter
+} // namespace liquibook
@@ -0,0 +1,156 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+
+#define BOOST_TEST_NO_MAIN LiquibookTest
+#include <boost/test/unit_test.hpp>
+
+#include "ut_utils.h"
+#include <book/order_book.h>
+#include <simple/simple_order.h>
+#include "ut_alloc_counter.h"
+#include <vector>
+
+namespace liquibook {
+
+using simple::SimpleOrder;
+
+namespace
+{
+  /// @brief count the allocations made by one call of a function
+  template <class Function>
+  size_t allocations_during(Function function)
+  {
+    alloc_counter::start();
+    function();
+    return alloc_counter::stop();
+  }
+
+  /// @brief orders for one pass of exercise_book
+  std::vector<SimpleOrder> make_orders()
+  {
+    std::vector<SimpleOrder> orders;
+    for(Price price = 1247; price <= 1250; ++price)
+    {
+      orders.push_back(SimpleOrder(true, price, 100));
+      orders.push_back(SimpleOrder(true, price, 200));
+    }
+    for(Price price = 1251; price <= 1254; ++price)
+    {
+      orders.push_back(SimpleOrder(false, price, 100));
+    }
+    // Crosses the two best bid levels and part of the third
+    orders.push_back(SimpleOrder(false, 1248, 700));
+    return orders;
+  }
+
+  /// @brief add, replace, fill and cancel orders, leaving the book empty
+  template <class OrderBook>
+  void exercise_book(OrderBook & order_book, std::vector<SimpleOrder> & orders)
+  {
+    for(size_t index = 0; index < 12; ++index)
+    {
+      order_book.add(&orders[index]);
+    }
+    order_book.replace(&orders[0], 50);
+    order_book.replace(&orders[1], 0, 1246);
+    order_book.cancel(&orders[8]);
+    order_book.add(&orders[12]);
+    for(size_t index = 0; index < 12; ++index)
+    {
+      order_book.cancel(&orders[index]);
+    }
+  }
+
+  /// @brief orders for one pass of exercise_aon_book
+  std::vector<SimpleOrder> make_aon_orders()
+  {
+    std::vector<SimpleOrder> orders;
+    orders.push_back(SimpleOrder(true,  1250, 300));
+    orders.push_back(SimpleOrder(true,  1250, 100));
+    orders.push_back(SimpleOrder(true,  1249, 200));
+    orders.push_back(SimpleOrder(false, 1249, 100));
+    orders.push_back(SimpleOrder(false, 1249, 500));
+    orders.push_back(SimpleOrder(false, 1251, 400));
+    orders.push_back(SimpleOrder(true,  1251, 100));
+    orders.push_back(SimpleOrder(true,  1251, 300));
+    return orders;
+  }
+
+  /// @brief match all or none orders on both sides, leaving the book empty
+  template <class OrderBook>
+  void exercise_aon_book(OrderBook & order_book,
+                         std::vector<SimpleOrder> & orders)
+  {
+    const book::OrderConditions aon = book::oc_all_or_none;
+    order_book.add(&orders[0], aon);
+    order_book.add(&orders[1]);
+    order_book.add(&orders[2], aon);
+    // skips the AON bid, fills the regular one
+    order_book.add(&orders[3]);
+    // AON against AON: defers the first bid, then fills both
+    order_book.add(&orders[4], aon);
+    order_book.add(&orders[5], aon);
+    // rests; the AON ask is deferred but cannot fill yet
+    order_book.add(&orders[6]);
+    // rests, then the deferred AON ask fills against both bids
+    order_book.add(&orders[7]);
+  }
+
+  template <class OrderBook>
+  size_t steady_state_allocations(std::vector<SimpleOrder> (*make)(),
+    void (*exercise)(OrderBook &, std::vector<SimpleOrder> &),
+    Price last_trade)
+  {
+    OrderBook order_book;
+    std::vector<SimpleOrder> warm_up = make();
+    std::vector<SimpleOrder> measured = make();
+    exercise(order_book, warm_up);
+    BOOST_CHECK(order_book.bids().empty());
+    BOOST_CHECK(order_book.asks().empty());
+    size_t count = allocations_during([&]() {
+      exercise(order_book, measured);
+    });
+    BOOST_CHECK(order_book.bids().empty());
+    BOOST_CHECK(order_book.asks().empty());
+    BOOST_CHECK_EQUAL(last_trade, order_book.market_price());
+    return count;
+  }
+
+  template <class OrderBook>
+  size_t steady_state_allocations()
+  {
+    // the last fill was at the third bid level
+    return steady_state_allocations<OrderBook>(
+      make_orders, exercise_book<OrderBook>, 1248);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestPooledStorageDoesNotAllocate)
+{
+  typedef simple::SimpleOrderBook<5, book::PooledStorage> PooledBook;
+  BOOST_CHECK_EQUAL(0, steady_state_allocations<PooledBook>());
+}
+
+BOOST_AUTO_TEST_CASE(TestPooledStorageNoDepthDoesNotAllocate)
+{
+  typedef book::OrderBook<SimpleOrder*, book::PooledStorage> PooledBook;
+  BOOST_CHECK_EQUAL(0, steady_state_allocations<PooledBook>());
+}
+
+BOOST_AUTO_TEST_CASE(TestAllOrNoneMatchingDoesNotAllocate)
+{
+  // nothing is cancelled, so an empty book means every order filled
+  typedef simple::SimpleOrderBook<5, book::PooledStorage> PooledBook;
+  BOOST_CHECK_EQUAL(0, steady_state_allocations<PooledBook>(
+    make_aon_orders, exercise_aon_book<PooledBook>, 1251));
+}
+
+BOOST_AUTO_TEST_CASE(TestMultimapStorageAllocates)
+{
+  // Make sure the counter sees the per-order multimap nodes
+  typedef simple::SimpleOrderBook<5, book::MultimapStorage> MultimapBook;
+  BOOST_CHECK(steady_state_allocations<MultimapBook>() > 0);
+}
+
+} // namespace
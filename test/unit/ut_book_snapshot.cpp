@@ -0,0 +1,211 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+
+#define BOOST_TEST_NO_MAIN LiquibookTest
+#include <boost/test/unit_test.hpp>
+
+#include "ut_utils.h"
+#include <book/book_snapshot.h>
+#include <simple/simple_order.h>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace liquibook {
+
+using book::BookSnapshotOrder;
+using book::BookSnapshotView;
+using simple::SimpleOrder;
+
+namespace
+{
+  typedef std::vector<SimpleOrder*> Orders;
+  typedef std::tuple<uint32_t, Price, Quantity> Entry;
+  typedef std::vector<Entry> Side;
+
+  const OrderConditions AON(oc_all_or_none);
+
+  // Orders are saved by their position in the application's table.
+  struct RefOf {
+    std::map<const SimpleOrder*, uint64_t> refs;
+
+    explicit RefOf(const Orders & orders)
+    {
+      for(size_t i = 0; i < orders.size(); ++i)
+      {
+        refs[orders[i]] = i;
+      }
+    }
+
+    uint64_t operator()(SimpleOrder* order) const
+    {
+      return refs.find(order)->second;
+    }
+  };
+
+  // A restored book gets its own copies, so it can trade independently.
+  struct CopyFor {
+    std::vector<SimpleOrder> & copies;
+
+    SimpleOrder* operator()(const BookSnapshotOrder & saved) const
+    {
+      return &copies[saved.order_ref];
+    }
+  };
+
+  template <class Trackers>
+  Side side(const Trackers & trackers)
+  {
+    Side result;
+    for(auto pos = trackers.begin(); pos != trackers.end(); ++pos)
+    {
+      result.push_back(Entry(pos->second.ptr()->order_id_,
+        pos->second.price(), pos->second.open_qty()));
+    }
+    return result;
+  }
+
+  template <class Book>
+  bool same_orders(const Book & lhs, const Book & rhs)
+  {
+    return side(lhs.bids()) == side(rhs.bids()) &&
+      side(lhs.asks()) == side(rhs.asks()) &&
+      side(lhs.stopBids()) == side(rhs.stopBids()) &&
+      side(lhs.stopAsks()) == side(rhs.stopAsks()) &&
+      lhs.bidQuantities().total() == rhs.bidQuantities().total() &&
+      lhs.askQuantities().total() == rhs.askQuantities().total() &&
+      lhs.market_price() == rhs.market_price();
+  }
+
+  bool same_depth(const SimpleDepth & lhs, const SimpleDepth & rhs)
+  {
+    for(const DepthLevel * l = lhs.bids(), * r = rhs.bids();
+        l != lhs.end(); ++l, ++r)
+    {
+      if(l->price() != r->price() ||
+        l->aggregate_qty() != r->aggregate_qty() ||
+        l->order_count() != r->order_count())
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestSnapshotRestoresBook)
+{
+  SimpleOrderBook order_book;
+  order_book.set_market_price(1250);
+  SimpleOrder ask0(false, 1252, 100);
+  SimpleOrder ask1(false, 1251, 200);
+  SimpleOrder ask2(false, 1251, 100);
+  SimpleOrder ask3(false, 1253, 300);
+  SimpleOrder bid0(true, 1250, 300);
+  SimpleOrder bid1(true, 1249, 100);
+  SimpleOrder bid2(true, 1250, 200);
+  SimpleOrder bid3(true, 1251, 150);
+  SimpleOrder stop_bid(true, 1262, 100, 1260);
+  SimpleOrder stop_ask(false, 1238, 100, 1240);
+  BOOST_CHECK(add_and_verify(order_book, &ask0, false));
+  BOOST_CHECK(add_and_verify(order_book, &ask1, false));
+  BOOST_CHECK(add_and_verify(order_book, &ask2, false, false, AON));
+  BOOST_CHECK(add_and_verify(order_book, &ask3, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid0, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid1, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid2, false));
+  // Partially fills ask1
+  BOOST_CHECK(add_and_verify(order_book, &bid3, true, true));
+  BOOST_CHECK(replace_and_verify(order_book, &bid1, 50, 1248));
+  BOOST_CHECK(!order_book.add(&stop_bid));
+  BOOST_CHECK(!order_book.add(&stop_ask));
+  BOOST_CHECK_EQUAL(50u, ask1.open_qty());
+  BOOST_CHECK_EQUAL(1u, order_book.stopBids().size());
+  BOOST_CHECK_EQUAL(1u, order_book.stopAsks().size());
+
+  Orders orders = { &ask0, &ask1, &ask2, &ask3, &bid0, &bid1, &bid2,
+    &stop_bid, &stop_ask };
+  std::vector<uint64_t> image;
+  book::write_book_snapshot(order_book, RefOf(orders), image);
+
+  BookSnapshotView view(image.data(), image.size() * sizeof(uint64_t));
+  BOOST_CHECK_EQUAL(3u, view.header().bid_count);
+  BOOST_CHECK_EQUAL(4u, view.header().ask_count);
+  BOOST_CHECK_EQUAL(5u, view.header().depth_size);
+  BOOST_CHECK_EQUAL(1251u, view.header().market_price);
+  // Best first, then time priority
+  BOOST_CHECK_EQUAL(4u, view.bids()[0].order_ref);
+  BOOST_CHECK_EQUAL(6u, view.bids()[1].order_ref);
+  BOOST_CHECK_EQUAL(1248u, view.bids()[2].price);
+  BOOST_CHECK_EQUAL(150u, view.bids()[2].open_qty);
+  BOOST_CHECK_EQUAL(AON, view.asks()[1].conditions);
+  BOOST_CHECK_EQUAL(1260u, view.stop_bids()[0].stop_price);
+  BOOST_CHECK_EQUAL(1251u, view.depth_asks()[0].price);
+  BOOST_CHECK_EQUAL(150u, view.depth_asks()[0].aggregate_qty);
+  BOOST_CHECK_EQUAL(2u, view.depth_asks()[0].order_count);
+
+  std::vector<SimpleOrder> copies;
+  for(auto pos = orders.begin(); pos != orders.end(); ++pos)
+  {
+    copies.push_back(**pos);
+  }
+  SimpleOrderBook restored;
+  book::restore_book_snapshot(restored, view, CopyFor{copies});
+  BOOST_CHECK(same_orders(order_book, restored));
+  BOOST_CHECK(same_depth(order_book.depth(), restored.depth()));
+
+  // Both books trade the same way from here on
+  SimpleOrder ask4(false, 1250, 400);
+  SimpleOrder ask4_copy(ask4);
+  BOOST_CHECK(add_and_verify(order_book, &ask4, true, true));
+  BOOST_CHECK(add_and_verify(restored, &ask4_copy, true, true));
+  BOOST_CHECK_EQUAL(100u, copies[6].open_qty());
+  SimpleOrder bid4(true, 1262, 600);
+  SimpleOrder bid4_copy(bid4);
+  BOOST_CHECK(add_and_verify(order_book, &bid4, true));
+  BOOST_CHECK(add_and_verify(restored, &bid4_copy, true));
+  // Trading at 1262 triggers the restored stop bid
+  SimpleOrder ask5(false, 1260, 50);
+  SimpleOrder ask5_copy(ask5);
+  BOOST_CHECK(add_and_verify(order_book, &ask5, true, true));
+  BOOST_CHECK(add_and_verify(restored, &ask5_copy, true, true));
+  BOOST_CHECK(restored.stopBids().empty());
+  BOOST_CHECK_EQUAL(100u, copies[7].open_qty());
+  BOOST_CHECK(same_orders(order_book, restored));
+  BOOST_CHECK(same_depth(order_book.depth(), restored.depth()));
+}
+
+BOOST_AUTO_TEST_CASE(TestSnapshotChecksImage)
+{
+  book::OrderBook<SimpleOrder*> order_book;
+  SimpleOrder bid0(true, 1250, 100);
+  BOOST_CHECK(!order_book.add(&bid0));
+
+  Orders orders = { &bid0 };
+  std::vector<uint64_t> image;
+  book::write_book_snapshot(order_book, RefOf(orders), image);
+  const size_t size = image.size() * sizeof(uint64_t);
+  BookSnapshotView view(image.data(), size);
+  BOOST_CHECK_EQUAL(0u, view.header().depth_size);
+  BOOST_CHECK_EQUAL(size, BookSnapshotView::image_size(1, 0, 0, 0, 0));
+
+  // A book can only be restored once
+  std::vector<SimpleOrder> copies(1, bid0);
+  book::OrderBook<SimpleOrder*> restored;
+  book::restore_book_snapshot(restored, view, CopyFor{copies});
+  BOOST_CHECK_EQUAL(1u, restored.bids().size());
+  BOOST_CHECK_THROW(
+    book::restore_book_snapshot(restored, view, CopyFor{copies}),
+    std::runtime_error);
+
+  BOOST_CHECK_THROW(BookSnapshotView(image.data(), size - 8),
+    std::runtime_error);
+  std::vector<uint64_t> other(image);
+  reinterpret_cast<book::BookSnapshotHeader *>(other.data())->version += 1;
+  BOOST_CHECK_THROW(BookSnapshotView(other.data(), size), std::runtime_error);
+  other[0] = 0;
+  BOOST_CHECK_THROW(BookSnapshotView(other.data(), size), std::runtime_error);
+}
+
+} // namespace
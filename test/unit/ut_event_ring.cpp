@@ -0,0 +1,165 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+
+#define BOOST_TEST_NO_MAIN LiquibookTest
+#include <boost/test/unit_test.hpp>
+
+#include "ut_utils.h"
+#include <book/event_ring.h>
+#include <simple/simple_order_book.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace liquibook {
+
+using book::EventRing;
+using simple::SimpleOrder;
+
+typedef simple::SimpleOrderBook<5> SimpleOrderBook;
+typedef SimpleOrderBook::TypedEventRing SimpleEventRing;
+typedef SimpleOrderBook::TypedCallback SimpleCallback;
+
+BOOST_AUTO_TEST_CASE(TestEventRingWraps)
+{
+  EventRing<int> ring(5);
+  BOOST_CHECK_EQUAL(8, ring.capacity());
+  BOOST_CHECK(ring.empty());
+
+  int next_in = 0;
+  int next_out = 0;
+  for(int pass = 0; pass < 10; ++pass)
+  {
+    while(ring.try_push(next_in))
+    {
+      ++next_in;
+    }
+    BOOST_CHECK_EQUAL(8, ring.size());
+    // take a few singly, and the rest in one drain
+    int value = -1;
+    BOOST_CHECK(ring.try_pop(value));
+    BOOST_CHECK_EQUAL(next_out++, value);
+    BOOST_CHECK(ring.try_pop(value));
+    BOOST_CHECK_EQUAL(next_out++, value);
+    size_t drained = ring.drain([&](const int & event) {
+      BOOST_CHECK_EQUAL(next_out++, event);
+    }, 3);
+    BOOST_CHECK_EQUAL(3, drained);
+    BOOST_CHECK_EQUAL(3, ring.size());
+    ring.drain([&](const int & event) {
+      BOOST_CHECK_EQUAL(next_out++, event);
+    });
+    BOOST_CHECK(ring.empty());
+    BOOST_CHECK(!ring.try_pop(value));
+  }
+  BOOST_CHECK_EQUAL(next_in, next_out);
+}
+
+BOOST_AUTO_TEST_CASE(TestEventRingAcrossThreads)
+{
+  const size_t count = 200000;
+  EventRing<size_t> ring(64);
+  std::thread producer([&]() {
+    for(size_t value = 0; value < count; ++value)
+    {
+      ring.push(value);
+    }
+  });
+
+  size_t expected = 0;
+  bool in_order = true;
+  while(expected < count)
+  {
+    ring.drain([&](const size_t & value) {
+      in_order = in_order && value == expected;
+      ++expected;
+    });
+  }
+  producer.join();
+  BOOST_CHECK(in_order);
+  BOOST_CHECK(ring.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestOrderBookPublishesToRing)
+{
+  SimpleEventRing ring(16);
+  SimpleOrderBook order_book;
+  order_book.set_event_ring(&ring);
+  SimpleOrder ask0(false, 1252, 100);
+  SimpleOrder bid0(true,  1252, 100);
+  SimpleOrder bid1(true,  1251, 0);
+
+  BOOST_CHECK(add_and_verify(order_book, &ask0, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid0, true, true));
+  order_book.add(&bid1);  // rejected
+
+  std::vector<SimpleCallback> events;
+  ring.drain([&](const SimpleCallback & event) {
+    events.push_back(event);
+  });
+  BOOST_REQUIRE_EQUAL(6, events.size());
+  BOOST_CHECK_EQUAL(SimpleCallback::cb_order_accept, events[0].type);
+  BOOST_CHECK_EQUAL(&ask0, events[0].order);
+  BOOST_CHECK_EQUAL(SimpleCallback::cb_book_update, events[1].type);
+  BOOST_CHECK_EQUAL(SimpleCallback::cb_order_accept, events[2].type);
+  BOOST_CHECK_EQUAL(&bid0, events[2].order);
+  BOOST_CHECK_EQUAL(SimpleCallback::cb_order_fill, events[3].type);
+  BOOST_CHECK_EQUAL(100, events[3].quantity);
+  BOOST_CHECK_EQUAL(1252, events[3].price);
+  BOOST_CHECK_EQUAL(SimpleCallback::cb_book_update, events[4].type);
+  BOOST_CHECK_EQUAL(SimpleCallback::cb_order_reject, events[5].type);
+  BOOST_CHECK_EQUAL(&bid1, events[5].order);
+
+  // The book is still maintained on the matching thread
+  BOOST_CHECK_EQUAL(simple::os_complete, ask0.state());
+  BOOST_CHECK_EQUAL(1252, order_book.market_price());
+
+  order_book.set_event_ring(nullptr);
+  SimpleOrder ask1(false, 1253, 100);
+  BOOST_CHECK(add_and_verify(order_book, &ask1, false));
+  BOOST_CHECK(ring.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestOrderBookRingConsumerThread)
+{
+  // A ring smaller than the event stream makes the book wait for the
+  // consumer
+  SimpleEventRing ring(8);
+  SimpleOrderBook order_book;
+  order_book.set_event_ring(&ring);
+  std::vector<SimpleOrder> orders;
+  for(int index = 0; index < 1000; ++index)
+  {
+    orders.push_back(SimpleOrder(index % 2 == 0, 1250, 100));
+  }
+
+  size_t fills = 0;
+  size_t events = 0;
+  std::atomic<bool> done(false);
+  std::thread consumer([&]() {
+    while(!done || !ring.empty())
+    {
+      events += ring.drain([&](const SimpleCallback & event) {
+        if(event.type == SimpleCallback::cb_order_fill)
+        {
+          ++fills;
+        }
+      });
+      std::this_thread::yield();
+    }
+  });
+  for(auto order = orders.begin(); order != orders.end(); ++order)
+  {
+    order_book.add(&*order);
+  }
+  done = true;
+  consumer.join();
+  // accept and book update for each order, and a fill for every pair
+  BOOST_CHECK_EQUAL(500, fills);
+  BOOST_CHECK_EQUAL(2500, events);
+  BOOST_CHECK(order_book.bids().empty());
+  BOOST_CHECK(order_book.asks().empty());
+}
+
+} // namespace liquibook
@@ -0,0 +1,115 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+
+#define BOOST_TEST_NO_MAIN LiquibookTest
+#include <boost/test/unit_test.hpp>
+
+#include "ut_utils.h"
+#include <book/level_quantities.h>
+#include <simple/simple_order.h>
+
+namespace liquibook {
+
+using book::ComparablePrice;
+using book::LevelQuantities;
+using simple::SimpleOrder;
+
+namespace
+{
+  ComparablePrice askLevel(Price price)
+  {
+    return ComparablePrice(false, price);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestLevelQuantitiesKeepTotals)
+{
+  LevelQuantities<> asks;
+  asks.add(askLevel(1251), 200);
+  asks.add(askLevel(1250), 100);
+  asks.add(askLevel(1251), 300);
+  BOOST_CHECK_EQUAL(2u, asks.level_count());
+  BOOST_CHECK_EQUAL(500u, asks.at(askLevel(1251)));
+  BOOST_CHECK_EQUAL(600u, asks.total());
+
+  // An emptied level is dropped
+  asks.remove(askLevel(1250), 100);
+  BOOST_CHECK_EQUAL(1u, asks.level_count());
+  BOOST_CHECK_EQUAL(0u, asks.at(askLevel(1250)));
+  BOOST_CHECK_EQUAL(500u, asks.total());
+
+  BOOST_CHECK_THROW(asks.remove(askLevel(1251), 501), std::runtime_error);
+  BOOST_CHECK_THROW(asks.remove(askLevel(1252), 1), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(TestLevelQuantitiesAvailable)
+{
+  LevelQuantities<> asks;
+  asks.add(askLevel(1250), 100);
+  asks.add(askLevel(1251), 200);
+  asks.add(askLevel(1253), 400);
+
+  // Only levels an order at the price could trade with are counted
+  BOOST_CHECK_EQUAL(0u, asks.available(1249, 100));
+  BOOST_CHECK_EQUAL(300u, asks.available(1252, 500));
+  BOOST_CHECK_EQUAL(250u, asks.available(1252, 250));
+  BOOST_CHECK_EQUAL(700u, asks.available(MARKET_ORDER_PRICE, 700));
+  // Too much for the whole side
+  BOOST_CHECK_EQUAL(700u, asks.available(MARKET_ORDER_PRICE, 701));
+}
+
+BOOST_AUTO_TEST_CASE(TestBookQuantitiesFollowOrders)
+{
+  SimpleOrderBook order_book;
+  SimpleOrder ask0(false, 1252, 100);
+  SimpleOrder ask1(false, 1251, 300);
+  SimpleOrder ask2(false, 1251, 200);
+  SimpleOrder bid0(true, 1250, 400);
+  BOOST_CHECK(add_and_verify(order_book, &ask0, false));
+  BOOST_CHECK(add_and_verify(order_book, &ask1, false));
+  BOOST_CHECK(add_and_verify(order_book, &ask2, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid0, false));
+  BOOST_CHECK_EQUAL(600u, order_book.askQuantities().total());
+  BOOST_CHECK_EQUAL(500u, order_book.askQuantities().at(askLevel(1251)));
+  BOOST_CHECK_EQUAL(400u, order_book.bidQuantities().total());
+
+  // Partial fill
+  SimpleOrder bid1(true, 1251, 350);
+  BOOST_CHECK(add_and_verify(order_book, &bid1, true, true));
+  BOOST_CHECK_EQUAL(150u, order_book.askQuantities().at(askLevel(1251)));
+  BOOST_CHECK_EQUAL(250u, order_book.askQuantities().total());
+
+  // Replace and cancel
+  BOOST_CHECK(replace_and_verify(order_book, &ask0, 50));
+  BOOST_CHECK_EQUAL(300u, order_book.askQuantities().total());
+  BOOST_CHECK(cancel_and_verify(order_book, &ask2, simple::os_cancelled));
+  BOOST_CHECK_EQUAL(0u, order_book.askQuantities().at(askLevel(1251)));
+  BOOST_CHECK_EQUAL(150u, order_book.askQuantities().total());
+  BOOST_CHECK_EQUAL(1u, order_book.askQuantities().level_count());
+}
+
+BOOST_AUTO_TEST_CASE(TestFillOrKillRejectedFromQuantities)
+{
+  SimpleOrderBook order_book;
+  SimpleOrder ask0(false, 1251, 100);
+  SimpleOrder ask1(false, 1252, 100);
+  SimpleOrder ask2(false, 1254, 500);
+  BOOST_CHECK(add_and_verify(order_book, &ask0, false));
+  BOOST_CHECK(add_and_verify(order_book, &ask1, false));
+  BOOST_CHECK(add_and_verify(order_book, &ask2, false));
+
+  // Enough on the side but not at matching prices
+  OrderConditions fok(oc_all_or_none | oc_immediate_or_cancel);
+  SimpleOrder bid0(true, 1253, 300);
+  BOOST_CHECK(add_and_verify(order_book, &bid0, false, false, fok));
+  BOOST_CHECK_EQUAL(700u, order_book.askQuantities().total());
+  BOOST_CHECK_EQUAL(0u, ask0.filled_qty());
+
+  // Enough at matching prices
+  SimpleOrder bid1(true, 1254, 300);
+  BOOST_CHECK(add_and_verify(order_book, &bid1, true, true, fok));
+  BOOST_CHECK_EQUAL(400u, order_book.askQuantities().total());
+}
+
+} // namespace
@@ -8,7 +8,9 @@
 #include "ut_utils.h"
 #include "changed_checker.h"
 #include <book/order_book.h>
+#include <book/static_order_book.h>
 #include <simple/simple_order.h>
+#include <string>
 
 namespace liquibook {
 
@@ -423,4 +425,243 @@ BOOST_AUTO_TEST_CASE(TestTradeCallbacks)
   BOOST_CHECK_EQUAL(0, listener.quantities_.size());
 }
 
+BOOST_AUTO_TEST_CASE(TestBatchCallbacks)
+{
+  typedef TypedOrderBook::TypedCommand Command;
+  SimpleOrder buy0(true, 3250, 100);
+  SimpleOrder buy1(true, 3249, 800);
+  SimpleOrder buy2(true, 3248, 300);
+  SimpleOrder sell0(false, 3251, 200);
+  SimpleOrder sell1(false, 3250, 300);
+
+  OrderCbListener order_listener;
+  OrderBookCbListener book_listener;
+  DepthCbListener depth_listener;
+  BboCbListener bbo_listener;
+  TypedDepthOrderBook order_book;
+  order_book.set_order_listener(&order_listener);
+  order_book.set_order_book_listener(&book_listener);
+  order_book.set_depth_listener(&depth_listener);
+  order_book.set_bbo_listener(&bbo_listener);
+
+  std::vector<Command> commands;
+  commands.push_back(Command::add(&buy0));
+  commands.push_back(Command::add(&buy1));
+  commands.push_back(Command::add(&buy2));
+  commands.push_back(Command::add(&sell0));
+  commands.push_back(Command::replace(&buy2, 0, 3247));
+  commands.push_back(Command::cancel(&buy1));
+  // fills buy0 and rests at 3250
+  commands.push_back(Command::add(&sell1));
+  BOOST_CHECK(order_book.apply_batch(&commands[0], commands.size()));
+
+  // order callbacks as if each command had been applied on its own
+  BOOST_REQUIRE_EQUAL(5, order_listener.accepts_.size());
+  BOOST_CHECK_EQUAL(&buy0, order_listener.accepts_[0]);
+  BOOST_CHECK_EQUAL(&sell1, order_listener.accepts_[4]);
+  BOOST_CHECK_EQUAL(1, order_listener.replaces_.size());
+  BOOST_CHECK_EQUAL(1, order_listener.cancels_.size());
+  BOOST_CHECK_EQUAL(1, order_listener.fills_.size());
+
+  // but the book is published once
+  BOOST_CHECK_EQUAL(1, book_listener.changes_.size());
+  BOOST_CHECK_EQUAL(1, depth_listener.changes_.size());
+  BOOST_CHECK_EQUAL(1, bbo_listener.changes_.size());
+
+  DepthCheck<TypedDepthOrderBook> dc(order_book.depth());
+  BOOST_CHECK(dc.verify_bid(3247, 1, 300));
+  BOOST_CHECK(dc.verify_ask(3250, 1, 200));
+  BOOST_CHECK(dc.verify_ask(3251, 1, 200));
+
+  // A batch that changes nothing publishes nothing
+  order_listener.reset();
+  book_listener.reset();
+  depth_listener.reset();
+  bbo_listener.reset();
+  Command rejected = Command::cancel(&buy1);
+  BOOST_CHECK(!order_book.apply_batch(&rejected, 1));
+  BOOST_CHECK_EQUAL(1, order_listener.cancel_rejects_.size());
+  BOOST_CHECK_EQUAL(0, book_listener.changes_.size());
+  BOOST_CHECK_EQUAL(0, depth_listener.changes_.size());
+  BOOST_CHECK_EQUAL(0, bbo_listener.changes_.size());
+
+  // Single commands still publish every change
+  order_book.add(&buy1);
+  BOOST_CHECK_EQUAL(1, book_listener.changes_.size());
+  BOOST_CHECK_EQUAL(1, depth_listener.changes_.size());
+}
+
+// Records events from the runtime listener interfaces
+class RuntimeEventLog
+      : public OrderListener<OrderPtr>,
+        public TradeListener<TypedOrderBook>,
+        public OrderBookListener<TypedOrderBook>,
+        public TypedDepthOrderBook::TypedDepthListener,
+        public TypedDepthOrderBook::TypedBboListener
+{
+public:
+  virtual void on_accept(const OrderPtr& ) { events_.push_back("accept"); }
+  virtual void on_trigger_stop(const OrderPtr& ) { events_.push_back("trigger"); }
+  virtual void on_reject(const OrderPtr& , const char* ) { events_.push_back("reject"); }
+  virtual void on_fill(const OrderPtr& , const OrderPtr& , Quantity , Price )
+  {
+    events_.push_back("fill");
+  }
+  virtual void on_cancel(const OrderPtr& ) { events_.push_back("cancel"); }
+  virtual void on_cancel_reject(const OrderPtr& , const char* )
+  {
+    events_.push_back("cancel reject");
+  }
+  virtual void on_replace(const OrderPtr& , const int64_t& , Price )
+  {
+    events_.push_back("replace");
+  }
+  virtual void on_replace_reject(const OrderPtr& , const char* )
+  {
+    events_.push_back("replace reject");
+  }
+  virtual void on_trade(const TypedOrderBook* , Quantity , Price )
+  {
+    events_.push_back("trade");
+  }
+  virtual void on_order_book_change(const TypedOrderBook* )
+  {
+    events_.push_back("book");
+  }
+  virtual void on_depth_change(const TypedDepthOrderBook* ,
+                               const DepthTracker* )
+  {
+    events_.push_back("depth");
+  }
+  virtual void on_bbo_change(const TypedDepthOrderBook* ,
+                             const DepthTracker* )
+  {
+    events_.push_back("bbo");
+  }
+
+  std::vector<std::string> events_;
+};
+
+// Records the same events, bound at compile time
+class StaticEventLog : public book::StaticListener
+{
+public:
+  void on_accept(const OrderPtr& ) { events_.push_back("accept"); }
+  void on_trigger_stop(const OrderPtr& ) { events_.push_back("trigger"); }
+  void on_reject(const OrderPtr& , const char* ) { events_.push_back("reject"); }
+  void on_fill(const OrderPtr& , const OrderPtr& , Quantity , Price )
+  {
+    events_.push_back("fill");
+  }
+  void on_cancel(const OrderPtr& ) { events_.push_back("cancel"); }
+  void on_cancel_reject(const OrderPtr& , const char* )
+  {
+    events_.push_back("cancel reject");
+  }
+  void on_replace(const OrderPtr& , const int64_t& , Price )
+  {
+    events_.push_back("replace");
+  }
+  void on_replace_reject(const OrderPtr& , const char* )
+  {
+    events_.push_back("replace reject");
+  }
+  template <class Book>
+  void on_trade(const Book* , Quantity , Price )
+  {
+    events_.push_back("trade");
+  }
+  template <class Book>
+  void on_order_book_change(const Book* )
+  {
+    events_.push_back("book");
+  }
+  template <class Book, class Depth>
+  void on_depth_change(const Book* , const Depth* )
+  {
+    events_.push_back("depth");
+  }
+  template <class Book, class Depth>
+  void on_bbo_change(const Book* , const Depth* )
+  {
+    events_.push_back("bbo");
+  }
+
+  std::vector<std::string> events_;
+};
+
+template <class OrderBook>
+void exercise_listeners(OrderBook & order_book)
+{
+  // Separate orders for each book, since the books do not update them
+  SimpleOrder buy0(true, 3250, 100);
+  SimpleOrder buy1(true, 3249, 800);
+  SimpleOrder buy2(true, 3240, 300);
+  SimpleOrder sell0(false, 3251, 200);
+  SimpleOrder sell1(false, 3249, 500);
+  SimpleOrder sell2(false, 3250, 50);
+  SimpleOrder invalid(false, 3230, 0);
+  SimpleOrder stop(false, 3245, 100, 3249);
+
+  order_book.add(&buy0);
+  order_book.add(&buy1);
+  order_book.add(&buy2);
+  order_book.add(&sell0);
+  // trades at 3250, setting the market price
+  order_book.add(&sell2);
+  order_book.add(&invalid);
+  order_book.add(&stop);
+  order_book.replace(&sell0, 100, 3252);
+  order_book.replace(&invalid, 100);
+  // trades at 3250 and 3249, triggering the stop
+  order_book.add(&sell1);
+  order_book.cancel(&buy2);
+  order_book.cancel(&buy0);
+}
+
+BOOST_AUTO_TEST_CASE(TestStaticListenerCallbacks)
+{
+  typedef book::StaticDepthOrderBook<OrderPtr, StaticEventLog> StaticBook;
+  RuntimeEventLog runtime;
+  TypedDepthOrderBook runtime_book;
+  runtime_book.set_order_listener(&runtime);
+  runtime_book.set_trade_listener(&runtime);
+  runtime_book.set_order_book_listener(&runtime);
+  runtime_book.set_depth_listener(&runtime);
+  runtime_book.set_bbo_listener(&runtime);
+  exercise_listeners(runtime_book);
+
+  StaticBook static_book;
+  exercise_listeners(static_book);
+
+  const std::vector<std::string> & expected = runtime.events_;
+  const std::vector<std::string> & actual = static_book.listener().events_;
+  BOOST_CHECK(std::find(expected.begin(), expected.end(), "trigger")
+    != expected.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(),
+                                actual.begin(), actual.end());
+  BOOST_CHECK_EQUAL(runtime_book.market_price(), static_book.market_price());
+  BOOST_CHECK_EQUAL(runtime_book.bids().size(), static_book.bids().size());
+  BOOST_CHECK_EQUAL(runtime_book.asks().size(), static_book.asks().size());
+}
+
+BOOST_AUTO_TEST_CASE(TestStaticListenerWithoutDepth)
+{
+  typedef book::StaticOrderBook<OrderPtr, StaticEventLog> StaticBook;
+  RuntimeEventLog runtime;
+  TypedOrderBook runtime_book;
+  runtime_book.set_order_listener(&runtime);
+  runtime_book.set_trade_listener(&runtime);
+  runtime_book.set_order_book_listener(&runtime);
+  exercise_listeners(runtime_book);
+
+  StaticBook static_book;
+  exercise_listeners(static_book);
+
+  const std::vector<std::string> & expected = runtime.events_;
+  const std::vector<std::string> & actual = static_book.listener().events_;
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(),
+                                actual.begin(), actual.end());
+}
+
 } // namespace liquibook
@@ -0,0 +1,223 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+
+#define BOOST_TEST_NO_MAIN LiquibookTest
+#include <boost/test/unit_test.hpp>
+
+#include "ut_utils.h"
+#include <book/market_by_order_listener.h>
+#include <simple/simple_order.h>
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace liquibook {
+
+using book::ComparablePrice;
+using simple::SimpleOrder;
+
+namespace
+{
+  typedef book::OrderBook<SimpleOrder*> Book;
+  typedef Book::TypedBookEvent Event;
+  typedef std::tuple<const SimpleOrder*, Price, Quantity> Entry;
+  typedef std::vector<Entry> Side;
+
+  static_assert(std::is_trivially_copyable<Event>::value,
+    "book events are trivially copyable");
+
+  const OrderConditions AON(oc_all_or_none);
+
+  // Keeps a copy of the resting orders from book events alone.
+  class Mirror : public book::MarketByOrderListener<Book> {
+  public:
+    Mirror()
+      : sequence_(0)
+      , modified_(0)
+    {
+    }
+
+    virtual void on_book_event(const Book* book, const Event& event)
+    {
+      BOOST_CHECK_EQUAL(sequence_ + 1, event.sequence);
+      sequence_ = event.sequence;
+      auto pos = orders_.find(event.order);
+      switch(event.type)
+      {
+        case Event::be_add:
+        {
+          BOOST_CHECK(pos == orders_.end());
+          Resting & order = orders_[event.order];
+          order.is_buy = event.is_buy;
+          order.price = event.price;
+          order.qty = event.open_qty;
+          order.arrival = event.sequence;
+          break;
+        }
+        case Event::be_modify:
+          BOOST_REQUIRE(pos != orders_.end());
+          ++modified_;
+          pos->second.price = event.price;
+          pos->second.qty = event.open_qty;
+          pos->second.arrival = event.sequence;
+          break;
+        case Event::be_execute:
+          BOOST_REQUIRE(pos != orders_.end());
+          BOOST_CHECK_EQUAL(pos->second.qty - event.quantity, event.open_qty);
+          pos->second.qty = event.open_qty;
+          if(event.open_qty == 0)
+          {
+            orders_.erase(pos);
+          }
+          break;
+        case Event::be_delete:
+          BOOST_REQUIRE(pos != orders_.end());
+          BOOST_CHECK_EQUAL(pos->second.qty, event.quantity);
+          orders_.erase(pos);
+          break;
+      }
+    }
+
+    // one side in the order the book keeps it
+    Side side(bool is_buy) const
+    {
+      std::vector<std::pair<std::pair<ComparablePrice, uint64_t>, Entry> > sorted;
+      for(auto pos = orders_.begin(); pos != orders_.end(); ++pos)
+      {
+        const Resting & order = pos->second;
+        if(order.is_buy == is_buy)
+        {
+          sorted.push_back(std::make_pair(
+            std::make_pair(ComparablePrice(is_buy, order.price), order.arrival),
+            Entry(pos->first, order.price, order.qty)));
+        }
+      }
+      std::sort(sorted.begin(), sorted.end(),
+        [](const decltype(sorted[0]) & lhs, const decltype(sorted[0]) & rhs)
+        {
+          return lhs.first.first < rhs.first.first ||
+            (!(rhs.first.first < lhs.first.first) &&
+             lhs.first.second < rhs.first.second);
+        });
+      Side result;
+      for(auto pos = sorted.begin(); pos != sorted.end(); ++pos)
+      {
+        result.push_back(pos->second);
+      }
+      return result;
+    }
+
+    uint64_t sequence() const { return sequence_; }
+    size_t modified() const { return modified_; }
+
+  private:
+    struct Resting {
+      bool is_buy;
+      Price price;
+      Quantity qty;
+      uint64_t arrival;
+    };
+    std::map<const SimpleOrder*, Resting> orders_;
+    uint64_t sequence_;
+    size_t modified_;
+  };
+
+  template <class Trackers>
+  Side book_side(const Trackers & trackers)
+  {
+    Side result;
+    for(auto pos = trackers.begin(); pos != trackers.end(); ++pos)
+    {
+      result.push_back(Entry(pos->second.ptr(), pos->second.price(),
+        pos->second.open_qty()));
+    }
+    return result;
+  }
+
+  bool mirrors(const Mirror & mirror, const SimpleOrderBook & book)
+  {
+    return mirror.side(true) == book_side(book.bids()) &&
+      mirror.side(false) == book_side(book.asks()) &&
+      mirror.sequence() == book.event_sequence();
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestMarketByOrderMirrorsBook)
+{
+  SimpleOrderBook order_book;
+  Mirror mirror;
+  order_book.set_market_by_order_listener(&mirror);
+
+  SimpleOrder ask0(false, 1252, 100);
+  SimpleOrder ask1(false, 1251, 200);
+  SimpleOrder ask2(false, 1251, 100);
+  SimpleOrder bid0(true, 1250, 300);
+  SimpleOrder bid1(true, 1249, 100);
+  BOOST_CHECK(add_and_verify(order_book, &ask0, false));
+  BOOST_CHECK(add_and_verify(order_book, &ask1, false));
+  BOOST_CHECK(add_and_verify(order_book, &ask2, false, false, AON));
+  BOOST_CHECK(add_and_verify(order_book, &bid0, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid1, false));
+  BOOST_CHECK_EQUAL(5u, order_book.event_sequence());
+  BOOST_CHECK(mirrors(mirror, order_book));
+
+  // Partial fill of a resting order
+  SimpleOrder bid2(true, 1251, 150);
+  BOOST_CHECK(add_and_verify(order_book, &bid2, true, true));
+  BOOST_CHECK(mirrors(mirror, order_book));
+
+  // Fills a resting order and a resting AON order
+  SimpleOrder bid3(true, 1251, 150);
+  BOOST_CHECK(add_and_verify(order_book, &bid3, true, true));
+  BOOST_CHECK(mirrors(mirror, order_book));
+
+  // A resting AON ask is filled once enough bids rest
+  SimpleOrder ask3(false, 1252, 300);
+  SimpleOrder bid4(true, 1252, 200);
+  SimpleOrder bid5(true, 1252, 200);
+  BOOST_CHECK(add_and_verify(order_book, &ask3, false, false, AON));
+  BOOST_CHECK(add_and_verify(order_book, &bid4, true));
+  BOOST_CHECK(mirrors(mirror, order_book));
+  BOOST_CHECK(add_and_verify(order_book, &bid5, true, true));
+  BOOST_CHECK_EQUAL(0u, ask3.open_qty());
+  BOOST_CHECK(order_book.asks().empty());
+  BOOST_CHECK(mirrors(mirror, order_book));
+
+  // Replaced orders that rest again are modified
+  BOOST_CHECK(replace_and_verify(order_book, &bid0, 100));
+  BOOST_CHECK(replace_and_verify(order_book, &bid1, 0, 1251));
+  BOOST_CHECK_EQUAL(2u, mirror.modified());
+  BOOST_CHECK(mirrors(mirror, order_book));
+
+  // A replaced order that trades away is deleted
+  SimpleOrder ask4(false, 1255, 100);
+  BOOST_CHECK(add_and_verify(order_book, &ask4, false));
+  BOOST_CHECK(replace_and_verify(order_book, &bid1, 0, 1255,
+    simple::os_complete, 100));
+  BOOST_CHECK(mirrors(mirror, order_book));
+
+  // Replaced to nothing, and cancelled
+  SimpleOrder bid6(true, 1248, 100);
+  BOOST_CHECK(add_and_verify(order_book, &bid6, false));
+  BOOST_CHECK(replace_and_verify(order_book, &bid0, -400,
+    PRICE_UNCHANGED, simple::os_cancelled));
+  BOOST_CHECK(cancel_and_verify(order_book, &bid6, simple::os_cancelled));
+  BOOST_CHECK(mirrors(mirror, order_book));
+  BOOST_CHECK(order_book.bids().empty());
+  BOOST_CHECK_EQUAL(2u, mirror.modified());
+}
+
+BOOST_AUTO_TEST_CASE(TestNoBookEventsWithoutListener)
+{
+  SimpleOrderBook order_book;
+  SimpleOrder ask0(false, 1252, 100);
+  SimpleOrder bid0(true, 1252, 100);
+  BOOST_CHECK(add_and_verify(order_book, &ask0, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid0, true, true));
+  BOOST_CHECK_EQUAL(0u, order_book.event_sequence());
+}
+
+} // namespace
@@ -1041,6 +1041,59 @@ BOOST_AUTO_TEST_CASE(TestCancelAskAndMatch)
   BOOST_CHECK_EQUAL(0, order_book.asks().size());
 }
 
+BOOST_AUTO_TEST_CASE(TestCancelDeepLevel)
+{
+  SimpleOrderBook order_book;
+  const size_t count = 40;
+  std::vector<SimpleOrder> bids;
+  bids.reserve(count + 4);
+  for(size_t i = 0; i < count; ++i)
+  {
+    bids.push_back(SimpleOrder(true, 1250, 100));
+  }
+  for(size_t i = 0; i < count; ++i)
+  {
+    BOOST_CHECK(add_and_verify(order_book, &bids[i], false));
+  }
+
+  // Cancel from the front, back and middle of the queue
+  for(size_t i = 0; i < count; i += 2)
+  {
+    BOOST_CHECK(cancel_and_verify(order_book, &bids[i], simple::os_cancelled));
+  }
+  BOOST_CHECK(cancel_and_verify(order_book, &bids[count - 1], simple::os_cancelled));
+  BOOST_CHECK(cancel_and_verify(order_book, &bids[5], simple::os_cancelled));
+  BOOST_CHECK_EQUAL(count / 2 - 2, order_book.bids().size());
+
+  // Join the queue after the cancels, then cancel older orders
+  for(size_t i = 0; i < 4; ++i)
+  {
+    bids.push_back(SimpleOrder(true, 1250, 100));
+    BOOST_CHECK(add_and_verify(order_book, &bids.back(), false));
+  }
+  BOOST_CHECK(cancel_and_verify(order_book, &bids[1], simple::os_cancelled));
+  BOOST_CHECK(cancel_and_verify(order_book, &bids[count + 1], simple::os_cancelled));
+
+  // Cancelling again is rejected
+  BOOST_CHECK(cancel_and_verify(order_book, &bids[1], simple::os_cancelled));
+  BOOST_CHECK_EQUAL(count / 2, order_book.bids().size());
+
+  // Verify depth
+  DepthCheck<SimpleOrderBook> dc(order_book.depth());
+  BOOST_CHECK(dc.verify_bid(1250, count / 2, count / 2 * 100));
+
+  // Time priority survives the cancels
+  SimpleOrder ask0(false, 1250, 100);
+  {
+    SimpleFillCheck fc1(&bids[3], 100, 125000);
+    SimpleFillCheck fc2(&ask0, 100, 125000);
+    BOOST_CHECK(add_and_verify(order_book, &ask0, true, true));
+  }
+  BOOST_CHECK(cancel_and_verify(order_book, &bids[count], simple::os_cancelled));
+  BOOST_CHECK(replace_and_verify(order_book, &bids[count + 3], -50));
+  BOOST_CHECK_EQUAL(count / 2 - 2, order_book.bids().size());
+}
+
 BOOST_AUTO_TEST_CASE(TestCancelBidFail)
 {
   SimpleOrderBook order_book;
@@ -2354,6 +2407,36 @@ BOOST_AUTO_TEST_CASE(TestReplaceAskPriceChangeErase)
   BOOST_CHECK(dc.verify_ask(1256, 1, 330));
 }
 
+BOOST_AUTO_TEST_CASE(TestReplacePartiallyFilledPriceChange)
+{
+  SimpleOrderBook order_book;
+  SimpleOrder bid0(true,  1250, 100);
+  SimpleOrder ask0(false, 1250, 40);
+  SimpleOrder ask1(false, 1251, 60);
+
+  // Partial fill leaves 60 open
+  BOOST_CHECK(add_and_verify(order_book, &bid0, false));
+  BOOST_CHECK(add_and_verify(order_book, &ask0, true, true));
+
+  DepthCheck<SimpleOrderBook> dc(order_book.depth());
+  BOOST_CHECK(dc.verify_bid(1250, 1, 60));
+
+  // Depth moves the open quantity, not the original quantity
+  BOOST_CHECK(replace_and_verify(order_book, &bid0, SIZE_UNCHANGED, 1251));
+  BOOST_CHECK_EQUAL(1251, bid0.price());
+  BOOST_CHECK_EQUAL(100, bid0.order_qty());
+  dc.reset();
+  BOOST_CHECK(dc.verify_bid(1251, 1, 60));
+  BOOST_CHECK(dc.verify_bid(   0, 0,  0));
+
+  // Trades at the new price and leaves no depth behind
+  BOOST_CHECK(add_and_verify(order_book, &ask1, true, true));
+  BOOST_CHECK_EQUAL(simple::os_complete, bid0.state());
+  dc.reset();
+  BOOST_CHECK(dc.verify_bid(   0, 0,  0));
+  BOOST_CHECK(dc.verify_ask(   0, 0,  0));
+}
+
 // A potential problem
 // When restroing a level into the depth, the orders (and thus the restored
 // level already reflect the post-fill quantity, but the fill callback has 
@@ -2650,4 +2733,56 @@ BOOST_AUTO_TEST_CASE(TestReplaceAskMatch)
   BOOST_CHECK(cc.verify_ask_changed(true, true, true, false, false));
 }
 
+namespace
+{
+  // An order whose price never changes after it is created: the book
+  // must keep track of a replaced price itself.
+  class FixedOrder final : public book::Order
+  {
+  public:
+    FixedOrder(bool buy, Price price, Quantity qty)
+      : buy_(buy), price_(price), qty_(qty)
+    {
+    }
+    bool is_buy() const { return buy_; }
+    Price price() const { return price_; }
+    Quantity order_qty() const { return qty_; }
+  private:
+    bool buy_;
+    Price price_;
+    Quantity qty_;
+  };
+
+  class FixedOrderBook : public OrderBook<FixedOrder*>
+  {
+  public:
+    virtual void on_trade(const OrderBook<FixedOrder*>* book,
+                          Quantity qty,
+                          Price price)
+    {
+      trade_prices_.push_back(price);
+    }
+    std::vector<Price> trade_prices_;
+  };
+}
+
+static_assert(book::is_order<FixedOrder>::value, "FixedOrder is an Order");
+static_assert(!book::is_order<OrderTracker<FixedOrder*> >::value,
+  "a tracker is not an Order");
+
+BOOST_AUTO_TEST_CASE(TestReplacedPriceUsedForTrades)
+{
+  FixedOrderBook order_book;
+  FixedOrder ask(false, 1252, 100);
+  FixedOrder bid(true, book::MARKET_ORDER_PRICE, 100);
+  order_book.add(&ask);
+
+  // The ask moves down to 1251, so a market bid trades at 1251
+  BOOST_CHECK(!order_book.replace(&ask, 0, 1251));
+  BOOST_CHECK(order_book.add(&bid));
+  BOOST_REQUIRE_EQUAL(1u, order_book.trade_prices_.size());
+  BOOST_CHECK_EQUAL(1251, order_book.trade_prices_[0]);
+  BOOST_CHECK_EQUAL(0, order_book.asks().size());
+}
+
 } // namespace
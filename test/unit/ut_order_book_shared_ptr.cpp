@@ -8,9 +8,12 @@
 #include "ut_utils.h"
 #include "changed_checker.h"
 #include <book/order_book.h>
+#include <book/order_listener.h>
 #include <simple/simple_order.h>
 #include <simple/simple_order_book.h>
 #include <memory>
+#include <type_traits>
+#include <vector>
 
 namespace liquibook {
 
@@ -103,4 +106,144 @@ BOOST_AUTO_TEST_CASE(TestSharedCancelBid)
   BOOST_CHECK_EQUAL(2, order_book.asks().size());
 }
 
+static_assert(
+  std::is_trivially_copyable<OrderBook<SimpleOrderPtr>::TypedCallback>::value,
+  "queueing a callback must not copy a shared_ptr");
+
+class SharedFillListener : public book::OrderListener<SimpleOrderPtr>
+{
+public:
+  virtual void on_accept(const SimpleOrderPtr& order)
+  {
+    accepted_.push_back(order);
+  }
+  virtual void on_reject(const SimpleOrderPtr& order, const char* reason)
+  {
+  }
+  virtual void on_fill(const SimpleOrderPtr& order,
+                       const SimpleOrderPtr& matched_order,
+                       Quantity fill_qty,
+                       Price fill_price)
+  {
+    filled_.push_back(order);
+    filled_.push_back(matched_order);
+  }
+  virtual void on_cancel(const SimpleOrderPtr& order)
+  {
+    cancelled_.push_back(order);
+  }
+  virtual void on_cancel_reject(const SimpleOrderPtr& order, const char* reason)
+  {
+  }
+  virtual void on_replace(const SimpleOrderPtr& order,
+                          const int64_t& size_delta,
+                          Price new_price)
+  {
+  }
+  virtual void on_replace_reject(const SimpleOrderPtr& order, const char* reason)
+  {
+  }
+
+  std::vector<SimpleOrderPtr> accepted_;
+  std::vector<SimpleOrderPtr> filled_;
+  std::vector<SimpleOrderPtr> cancelled_;
+};
+
+BOOST_AUTO_TEST_CASE(TestSharedOrdersHeldForCallbacks)
+{
+  // The application keeps no references, so the orders handed to the
+  // listener are only alive because the book holds them for callbacks.
+  OrderBook<SimpleOrderPtr> order_book;
+  SharedFillListener listener;
+  order_book.set_order_listener(&listener);
+
+  std::weak_ptr<SimpleOrder> ask;
+  {
+    SimpleOrderPtr order(new SimpleOrder(false, 1251, 100));
+    ask = order;
+    order_book.add(order);
+  }
+  BOOST_CHECK(!ask.expired());
+
+  std::weak_ptr<SimpleOrder> bid;
+  {
+    SimpleOrderPtr order(new SimpleOrder(true, 1251, 100));
+    bid = order;
+    order_book.add(order);
+  }
+  BOOST_CHECK_EQUAL(0, order_book.asks().size());
+  BOOST_REQUIRE_EQUAL(2u, listener.filled_.size());
+  BOOST_CHECK(listener.filled_[0] == bid.lock());
+  BOOST_CHECK(listener.filled_[1] == ask.lock());
+
+  // once the listener lets go the book holds nothing
+  listener.accepted_.clear();
+  listener.filled_.clear();
+  BOOST_CHECK(ask.expired());
+  BOOST_CHECK(bid.expired());
+
+  // an order that is rejected is not kept either
+  SimpleOrderPtr unknown(new SimpleOrder(true, 1250, 100));
+  order_book.cancel(unknown);
+  BOOST_CHECK_EQUAL(1, unknown.use_count());
+}
+
+class ReentrantFillListener : public SharedFillListener
+{
+public:
+  explicit ReentrantFillListener(OrderBook<SimpleOrderPtr> & book)
+  : book_(book)
+  {
+  }
+  // On the first fill, trade enough new orders that the book has to grow
+  // the storage it keeps filled orders in before the listener looks at
+  // the orders it was handed.
+  virtual void on_fill(const SimpleOrderPtr& order,
+                       const SimpleOrderPtr& matched_order,
+                       Quantity fill_qty,
+                       Price fill_price)
+  {
+    if(!reentered_)
+    {
+      reentered_ = true;
+      for(int i = 0; i < 64; ++i)
+      {
+        book_.add(SimpleOrderPtr(new SimpleOrder(false, 1260, 100)));
+      }
+      book_.add(SimpleOrderPtr(new SimpleOrder(true, 1260, 6400)));
+    }
+    SharedFillListener::on_fill(order, matched_order, fill_qty, fill_price);
+  }
+
+private:
+  OrderBook<SimpleOrderPtr> & book_;
+  bool reentered_ = false;
+};
+
+BOOST_AUTO_TEST_CASE(TestSharedFillListenerReentersAdd)
+{
+  OrderBook<SimpleOrderPtr> order_book;
+  ReentrantFillListener listener(order_book);
+  order_book.set_order_listener(&listener);
+
+  SimpleOrderPtr ask(new SimpleOrder(false, 1251, 100));
+  SimpleOrderPtr bid(new SimpleOrder(true, 1251, 100));
+  order_book.add(ask);
+  order_book.add(bid);
+
+  // the first fill is reported with the orders it was queued for
+  BOOST_REQUIRE_EQUAL(2u + 2 * 64, listener.filled_.size());
+  BOOST_CHECK(listener.filled_[0] == bid);
+  BOOST_CHECK(listener.filled_[1] == ask);
+  BOOST_CHECK_EQUAL(1251, listener.filled_[1]->price());
+  for(size_t i = 2; i < listener.filled_.size(); i += 2)
+  {
+    BOOST_CHECK(listener.filled_[i]->is_buy());
+    BOOST_CHECK_EQUAL(6400, listener.filled_[i]->order_qty());
+    BOOST_CHECK(!listener.filled_[i + 1]->is_buy());
+  }
+  BOOST_CHECK_EQUAL(0, order_book.bids().size());
+  BOOST_CHECK_EQUAL(0, order_book.asks().size());
+}
+
 } // namespace
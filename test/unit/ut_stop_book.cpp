@@ -0,0 +1,142 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+
+#define BOOST_TEST_NO_MAIN LiquibookTest
+#include <boost/test/unit_test.hpp>
+
+#include "ut_utils.h"
+#include <book/order_book.h>
+#include <book/stop_book.h>
+#include <simple/simple_order.h>
+#include <vector>
+
+namespace liquibook {
+
+using book::ComparablePrice;
+using book::StopBook;
+using simple::SimpleOrder;
+
+typedef StopBook<int> IntStops;
+
+namespace
+{
+  // Buy stops: the lowest trigger price is reached first
+  ComparablePrice buyStop(Price price)
+  {
+    return ComparablePrice(false, price);
+  }
+
+  std::vector<int> contents(const IntStops & stops)
+  {
+    std::vector<int> result;
+    for(auto pos = stops.begin(); pos != stops.end(); ++pos)
+    {
+      result.push_back(pos->second);
+    }
+    return result;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestStopBookKeepsTriggerAndArrivalOrder)
+{
+  IntStops stops;
+  stops.insert(buyStop(57), 1);
+  stops.insert(buyStop(56), 2);
+  stops.insert(buyStop(57), 3);
+  stops.insert(buyStop(58), 4);
+  stops.insert(buyStop(56), 5);
+  BOOST_CHECK_EQUAL(5u, stops.size());
+  BOOST_CHECK_EQUAL(3u, stops.bucket_count());
+
+  std::vector<int> expected = {2, 5, 1, 3, 4};
+  std::vector<int> actual = contents(stops);
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(),
+                                actual.begin(), actual.end());
+}
+
+BOOST_AUTO_TEST_CASE(TestStopBookEraseBySlot)
+{
+  IntStops stops;
+  IntStops::Slot first = stops.insert(buyStop(56), 1);
+  IntStops::Slot middle = stops.insert(buyStop(56), 2);
+  IntStops::Slot last = stops.insert(buyStop(56), 3);
+  IntStops::Slot alone = stops.insert(buyStop(57), 4);
+
+  stops.erase(middle);
+  BOOST_CHECK_EQUAL(3u, stops.size());
+  BOOST_CHECK_EQUAL(1, stops.at(first).second);
+  BOOST_CHECK_EQUAL(3, stops.at(last).second);
+
+  // Erasing the only stop at a price drops its bucket
+  stops.erase(alone);
+  BOOST_CHECK_EQUAL(1u, stops.bucket_count());
+
+  // Freed slots are reused
+  IntStops::Slot reused = stops.insert(buyStop(55), 5);
+  BOOST_CHECK(reused == alone || reused == middle);
+
+  std::vector<int> expected = {5, 1, 3};
+  std::vector<int> actual = contents(stops);
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(),
+                                actual.begin(), actual.end());
+}
+
+BOOST_AUTO_TEST_CASE(TestStopBookReleasesReachedBuckets)
+{
+  IntStops stops;
+  stops.insert(buyStop(58), 1);
+  stops.insert(buyStop(56), 2);
+  stops.insert(buyStop(57), 3);
+  stops.insert(buyStop(56), 4);
+
+  std::vector<int> released;
+  auto collect = [&released](int & stop) { released.push_back(stop); };
+
+  // Nothing triggers below the lowest stop
+  BOOST_CHECK_EQUAL(0u, stops.release(buyStop(55), collect));
+
+  BOOST_CHECK_EQUAL(3u, stops.release(buyStop(57), collect));
+  std::vector<int> expected = {2, 4, 3};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(),
+                                released.begin(), released.end());
+  BOOST_CHECK_EQUAL(1u, stops.size());
+  BOOST_CHECK_EQUAL(1u, stops.bucket_count());
+  BOOST_CHECK_EQUAL(1, stops.begin()->second);
+}
+
+BOOST_AUTO_TEST_CASE(TestStopsTriggerPastAFartherStop)
+{
+  simple::SimpleOrderBook<5> book;
+  book.set_market_price(55);
+  SimpleOrder ask(false, 60, 300);
+  SimpleOrder bid(true, 57, 1);
+  SimpleOrder near(true, 0, 100, 56);
+  SimpleOrder far(true, 0, 100, 61);
+  SimpleOrder cancelled(true, 0, 100, 56);
+  SimpleOrder later(true, 0, 100, 56);
+  BOOST_CHECK(add_and_verify(book, &ask, false));
+  BOOST_CHECK(add_and_verify(book, &bid, false));
+  book.add(&near);
+  book.add(&far);
+  book.add(&cancelled);
+  book.add(&later);
+  BOOST_CHECK_EQUAL(4u, book.stopBids().size());
+
+  book.cancel(&cancelled);
+  BOOST_CHECK_EQUAL(3u, book.stopBids().size());
+
+  // A trade at 57 triggers both stops at 56, though the stop at 61 is
+  // not reached, and they trade with the ask in the order they arrived.
+  SimpleOrder seller(false, 57, 1);
+  BOOST_CHECK(add_and_verify(book, &seller, true, true));
+  BOOST_CHECK_EQUAL(60u, book.market_price());
+  BOOST_CHECK_EQUAL(100u, near.filled_qty());
+  BOOST_CHECK_EQUAL(100u, later.filled_qty());
+  BOOST_CHECK_EQUAL(0u, far.filled_qty());
+  BOOST_CHECK_EQUAL(0u, cancelled.filled_qty());
+  BOOST_CHECK_EQUAL(100u, ask.open_qty());
+  BOOST_CHECK_EQUAL(1u, book.stopBids().size());
+}
+
+} // namespace
@@ -0,0 +1,151 @@
+// Copyright (c) 2017 Object Computing, Inc.
+// All rights reserved.
+// See the file license.txt for licensing information.
+
+#define BOOST_TEST_NO_MAIN LiquibookTest
+#include <boost/test/unit_test.hpp>
+
+#include "ut_utils.h"
+#include <book/order_book.h>
+#include <simple/simple_order.h>
+
+namespace liquibook {
+
+using simple::SimpleOrder;
+
+typedef simple::SimpleOrderBook<5, book::TickLadderStorage> TickOrderBook;
+typedef FillCheck<SimpleOrder*> SimpleFillCheck;
+
+namespace
+{
+  // Even prices from 1240 through 1260 are on the band
+  const PriceBand band(1240, 1260, 2);
+}
+
+BOOST_AUTO_TEST_CASE(TestTickLadderSweepsInPriceOrder)
+{
+  TickOrderBook order_book;
+  order_book.set_price_band(band);
+  SimpleOrder ask0(false, 1252, 100);  // on the band
+  SimpleOrder ask1(false, 1251, 100);  // between ticks
+  SimpleOrder ask2(false, 1250, 100);  // on the band
+  SimpleOrder ask3(false, 1262, 100);  // above the band
+  SimpleOrder ask4(false, 1238, 100);  // below the band
+  SimpleOrder bid0(true,  1262, 400);
+
+  BOOST_CHECK(add_and_verify(order_book, &ask0, false));
+  BOOST_CHECK(add_and_verify(order_book, &ask1, false));
+  BOOST_CHECK(add_and_verify(order_book, &ask2, false));
+  BOOST_CHECK(add_and_verify(order_book, &ask3, false));
+  BOOST_CHECK(add_and_verify(order_book, &ask4, false));
+
+  // Verify depth
+  DepthCheck<TickOrderBook> dc(order_book.depth());
+  BOOST_CHECK(dc.verify_ask(1238, 1, 100));
+  BOOST_CHECK(dc.verify_ask(1250, 1, 100));
+  BOOST_CHECK(dc.verify_ask(1251, 1, 100));
+  BOOST_CHECK(dc.verify_ask(1252, 1, 100));
+  BOOST_CHECK(dc.verify_ask(1262, 1, 100));
+
+  // Match the best four asks
+  {
+    SimpleFillCheck fc0(&ask0, 100, 125200);
+    SimpleFillCheck fc1(&ask1, 100, 125100);
+    SimpleFillCheck fc2(&ask2, 100, 125000);
+    SimpleFillCheck fc3(&ask3,   0,      0);
+    SimpleFillCheck fc4(&ask4, 100, 123800);
+    SimpleFillCheck fc5(&bid0, 400, 499100);
+    BOOST_CHECK(add_and_verify(order_book, &bid0, true, true));
+  }
+
+  BOOST_CHECK_EQUAL(0, order_book.bids().size());
+  BOOST_CHECK_EQUAL(1, order_book.asks().size());
+  dc.reset();
+  BOOST_CHECK(dc.verify_ask(1262, 1, 100));
+  BOOST_CHECK(dc.verify_ask(   0, 0,   0));
+}
+
+BOOST_AUTO_TEST_CASE(TestTickLadderDepthRestore)
+{
+  TickOrderBook order_book;
+  order_book.set_price_band(band);
+  SimpleOrder bid0(true, 1260, 100);
+  SimpleOrder bid1(true, 1258, 200);
+  SimpleOrder bid2(true, 1256, 300);
+  SimpleOrder bid3(true, 1254, 400);
+  SimpleOrder bid4(true, 1252, 500);
+  SimpleOrder bid5(true, 1251, 600);  // between ticks
+  SimpleOrder bid6(true, 1250, 700);
+  SimpleOrder bid7(true, 1230, 800);  // below the band
+
+  BOOST_CHECK(add_and_verify(order_book, &bid7, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid6, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid5, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid4, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid3, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid2, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid1, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid0, false));
+
+  // Cancel the best three levels; excess levels are restored in order
+  BOOST_CHECK(cancel_and_verify(order_book, &bid0, simple::os_cancelled));
+  BOOST_CHECK(cancel_and_verify(order_book, &bid1, simple::os_cancelled));
+  BOOST_CHECK(cancel_and_verify(order_book, &bid2, simple::os_cancelled));
+
+  DepthCheck<TickOrderBook> dc(order_book.depth());
+  BOOST_CHECK(dc.verify_bid(1254, 1, 400));
+  BOOST_CHECK(dc.verify_bid(1252, 1, 500));
+  BOOST_CHECK(dc.verify_bid(1251, 1, 600));
+  BOOST_CHECK(dc.verify_bid(1250, 1, 700));
+  BOOST_CHECK(dc.verify_bid(1230, 1, 800));
+  BOOST_CHECK_EQUAL(5, order_book.bids().size());
+}
+
+BOOST_AUTO_TEST_CASE(TestTickLadderStopTrigger)
+{
+  TickOrderBook order_book;
+  order_book.set_price_band(band);
+  SimpleOrder ask0(false, 1250, 100);
+  SimpleOrder bid0(true,  1250, 100);
+  SimpleOrder stop0(true, 1258, 100, 1254);  // stop on the band
+  SimpleOrder stop1(true, 1258, 200, 1255);  // stop between ticks
+  SimpleOrder ask1(false, 1256, 100);
+  SimpleOrder bid1(true,  1256, 100);
+
+  // Establish the market price
+  BOOST_CHECK(add_and_verify(order_book, &ask0, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid0, true, true));
+  BOOST_CHECK_EQUAL(1250, order_book.market_price());
+
+  order_book.add(&stop0);
+  order_book.add(&stop1);
+  BOOST_CHECK_EQUAL(2, order_book.stopBids().size());
+  BOOST_CHECK_EQUAL(0, order_book.bids().size());
+
+  // Trade at 1256 triggers both stops
+  BOOST_CHECK(add_and_verify(order_book, &ask1, false));
+  BOOST_CHECK(add_and_verify(order_book, &bid1, true, true));
+  BOOST_CHECK_EQUAL(1256, order_book.market_price());
+  BOOST_CHECK_EQUAL(0, order_book.stopBids().size());
+  BOOST_CHECK_EQUAL(2, order_book.bids().size());
+
+  DepthCheck<TickOrderBook> dc(order_book.depth());
+  BOOST_CHECK(dc.verify_bid(1258, 2, 300));
+}
+
+BOOST_AUTO_TEST_CASE(TestTickLadderBandNeedsEmptyBook)
+{
+  TickOrderBook order_book;
+  SimpleOrder bid0(true, 1250, 100);
+  SimpleOrder ask0(false, 1250, 100);
+  BOOST_CHECK(add_and_verify(order_book, &bid0, false));
+  BOOST_CHECK_THROW(order_book.set_price_band(band), std::runtime_error);
+
+  BOOST_CHECK(cancel_and_verify(order_book, &bid0, simple::os_cancelled));
+  order_book.set_price_band(band);
+  BOOST_CHECK(add_and_verify(order_book, &ask0, false));
+  DepthCheck<TickOrderBook> dc(order_book.depth());
+  BOOST_CHECK(dc.verify_ask(1250, 1, 100));
+}
+
+} // namespace
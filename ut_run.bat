@@ -1 +1,2 @@
 bin\test\liquibook_unit_test.exe
+bin\test\liquibook_unit_test_ladder.exe
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+namespace aws_wrapper {
+
+// === 힙 할당 카운터 ===
+// alloc_counter.cpp 가 전역 operator new 를 바꿔 호출 수를 센다.
+// 이 파일을 링크한 실행파일에서만 쓴다 (matching_engine).
+uint64_t heapAllocations();
+
+} // namespace aws_wrapper
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace aws_wrapper {
+namespace binary_io {
+
+// 저널과 스냅샷 파일이 함께 쓰는 인코딩 도우미 (호스트 바이트 순서)
+
+// CRC32 (IEEE 802.3, reflected)
+inline uint32_t crc32(const char* data, size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    crc ^= 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+// u16 길이 + 바이트. u16 에 담기지 않는 문자열은 쓰지 않고 false
+inline bool putString(std::string& out, const std::string& value) {
+    if (value.size() > UINT16_MAX) return false;
+    put<uint16_t>(out, static_cast<uint16_t>(value.size()));
+    out.append(value);
+    return true;
+}
+
+template <typename T>
+bool get(const char*& p, const char* end, T& value) {
+    if (end - p < static_cast<ptrdiff_t>(sizeof(T))) return false;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+inline bool getString(const char*& p, const char* end, std::string& value) {
+    uint16_t size = 0;
+    if (!get(p, end, size) || end - p < size) return false;
+    value.assign(p, size);
+    p += size;
+    return true;
+}
+
+} // namespace binary_io
+} // namespace aws_wrapper
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "engine_core.h"
+#include "journal.h"
+#include "market_data_handler.h"
+#include "source_offsets.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace aws_wrapper {
+
+class RedisClient;
+
+// === 체크포인트 (매칭을 멈추지 않는 스냅샷) ===
+// 라이브 엔진 대신 저널을 따라가는 섀도 엔진에서 스냅샷을 만든다.
+// checkpoint() 는 마지막 체크포인트 이후 저널에 추가된 명령만 섀도 엔진에
+// 적용하고 (비용은 그 사이 명령 수에 비례), 그동안 바뀐 오더북만 다시 기록한다.
+// 라이브 엔진의 락은 잡지 않으므로 스냅샷 중에도 addOrder 는 멈추지 않는다.
+// 섀도 엔진은 sequence 시점까지 라이브 엔진과 같은 상태이므로 각 스냅샷은
+// 그 오더북의 sequence 시점 그대로다. 대신 오더북 메모리를 한 벌 더 쓴다.
+// 오더북과 함께 섀도 엔진이 반영한 Kafka 입력 위치 (source_offsets.h) 도 기록하므로
+// 저널 없이 스냅샷만으로 시작해도 스냅샷 이후 메시지만 다시 읽는다.
+class Checkpointer {
+public:
+    // snapshot_dir 이 비어 있으면 바이너리 스냅샷, redis 가 nullptr 이면
+    // Redis JSON 스냅샷을 기록하지 않는다
+    Checkpointer(const std::string& journal_path,
+                 const std::string& snapshot_dir,
+                 RedisClient* redis);
+
+    // 섀도 엔진. 시작할 때 라이브 엔진과 같은 스냅샷을 복원해 둔다
+    EngineCore& engine() { return engine_; }
+    // 섀도 엔진이 반영한 입력 위치. 시작할 때 스냅샷의 입력 위치를 넣어 둔다
+    SourceOffsets& offsets() { return offsets_; }
+
+    // 저널 tail 을 적용하고 바뀐 오더북의 스냅샷을 기록. 기록한 오더북 수 반환
+    size_t checkpoint();
+
+private:
+    // 섀도 엔진이 적용한 sequence 까지만 입력 위치에 반영한다
+    void followOffsets(uint64_t up_to);
+
+    MarketDataHandler quiet_;
+    EngineCore engine_;
+    std::string journal_path_;
+    std::string snapshot_dir_;
+    RedisClient* redis_;
+    std::unique_ptr<JournalReader> reader_;
+    std::map<std::string, uint64_t> saved_sequences_;  // 오더북별 마지막 기록 sequence
+
+    SourceOffsets offsets_;
+    std::unique_ptr<JournalReader> offsets_reader_;
+    JournalRecord pending_;        // up_to 를 넘어 읽은 레코드 (다음 체크포인트에 반영)
+    bool has_pending_ = false;
+};
+
+} // namespace aws_wrapper
@@ -31,10 +31,16 @@ public:
     static constexpr const char* KAFKA_TRADES_TOPIC = "KAFKA_TRADES_TOPIC";
     static constexpr const char* KAFKA_DEPTH_TOPIC = "KAFKA_DEPTH_TOPIC";
     static constexpr const char* KAFKA_GROUP_ID = "KAFKA_GROUP_ID";
+    static constexpr const char* KAFKA_BATCH_SIZE = "KAFKA_BATCH_SIZE";
     static constexpr const char* GRPC_PORT = "GRPC_PORT";
     static constexpr const char* REDIS_HOST = "REDIS_HOST";
     static constexpr const char* REDIS_PORT = "REDIS_PORT";
     static constexpr const char* LOG_LEVEL = "LOG_LEVEL";
+    static constexpr const char* JOURNAL_PATH = "JOURNAL_PATH";
+    static constexpr const char* JOURNAL_FSYNC = "JOURNAL_FSYNC";
+    static constexpr const char* SNAPSHOT_DIR = "SNAPSHOT_DIR";
+    static constexpr const char* ENGINE_SHARDS = "ENGINE_SHARDS";
+    static constexpr const char* ENGINE_BOOK_CAPACITY = "ENGINE_BOOK_CAPACITY";
 };
 
 } // namespace aws_wrapper
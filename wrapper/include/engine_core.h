@@ -3,35 +3,154 @@
 #include <book/depth_order_book.h>
 #include "order.h"
 #include "market_data_handler.h"
-#include <map>
+#include "journal.h"
+#include "order_index.h"
+#include "symbol_table.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <mutex>
 #include <string>
 #include <vector>
 
 namespace aws_wrapper {
 
+// === 엔진 오더북 ===
+// 자기 주문 인덱스를 갖는 DepthOrderBook (Depth levels: 10 bid + 10 ask).
+// 주문이 오더북을 떠나면 (전량 체결, 취소, IOC 잔량 취소, 거부) 오더북 콜백에서
+// 인덱스에서 빼므로, 인덱스 크기는 누적 주문 수가 아니라 미체결 주문 수를 따라간다.
+// 콜백이 끝날 때까지는 오더북이 주문을 잡아 두므로 콜백 안에서 빼도 안전하다.
+class EngineBook : public liquibook::book::DepthOrderBook<OrderPtr, 10> {
+public:
+    using Base = liquibook::book::DepthOrderBook<OrderPtr, 10>;
+    
+    OrderIndex& orders() { return orders_; }
+    const OrderIndex& orders() const { return orders_; }
+    
+protected:
+    void on_reject(const OrderPtr& order, const char* reason) override {
+        Base::on_reject(order, reason);
+        orders_.erase(order);
+    }
+    
+    void on_fill(const OrderPtr& order,
+                 const OrderPtr& matched_order,
+                 liquibook::book::Quantity fill_qty,
+                 liquibook::book::Price fill_price,
+                 bool inbound_order_filled,
+                 bool matched_order_filled) override {
+        Base::on_fill(order, matched_order, fill_qty, fill_price,
+                      inbound_order_filled, matched_order_filled);
+        if (inbound_order_filled) orders_.erase(order);
+        if (matched_order_filled) orders_.erase(matched_order);
+    }
+    
+    // 정정된 주문은 새 가격 / 수량으로 매칭되므로 주문에도 반영한다
+    // (depth 는 Base 에서 주문의 이전 가격으로 옮기고, 이후 체결 / 취소 /
+    // 스냅샷은 주문의 가격을 읽는다)
+    void on_replace(const OrderPtr& order,
+                    liquibook::book::Quantity current_qty,
+                    liquibook::book::Quantity new_qty,
+                    liquibook::book::Price new_price) override {
+        Base::on_replace(order, current_qty, new_qty, new_price);
+        // current_qty / new_qty 는 미체결 수량이므로 차이만 주문 수량에 더한다
+        order->setOrderQty(order->order_qty() + new_qty - current_qty);
+        order->setPrice(new_price);
+    }
+    
+    void on_cancel(const OrderPtr& order, liquibook::book::Quantity quantity) override {
+        Base::on_cancel(order, quantity);
+        orders_.erase(order);
+    }
+    
+    void on_cancel_stop(const OrderPtr& order) override {
+        Base::on_cancel_stop(order);
+        orders_.erase(order);
+    }
+    
+private:
+    OrderIndex orders_;
+};
+
 class EngineCore {
 public:
-    // Depth levels: 10 bid + 10 ask
-    using OrderBook = liquibook::book::DepthOrderBook<OrderPtr, 10>;
+    using OrderBook = EngineBook;
     using OrderBookPtr = std::shared_ptr<OrderBook>;
+    // 재생할 종목을 고른다 (샤드가 자기 종목만 재생할 때)
+    using SymbolFilter = std::function<bool(const std::string&)>;
     
-    explicit EngineCore(MarketDataHandler* handler);
+    // 주문 명령 하나 (applyBatch 로 묶어서 적용)
+    struct Command {
+        JournalOp op = JournalOp::ADD;
+        OrderPtr order;                        // ADD
+        std::string symbol;                    // CANCEL, REPLACE
+        std::string order_id;
+        int64_t qty_delta = 0;                 // REPLACE
+        liquibook::book::Price new_price = 0;
+        SourcePosition source;
+    };
+    
+    // 오더북마다 처음부터 잡아 둘 주문 인덱스 크기
+    static constexpr size_t DEFAULT_BOOK_CAPACITY = 4096;
+    
+    explicit EngineCore(MarketDataHandler* handler,
+                        size_t book_capacity = DEFAULT_BOOK_CAPACITY);
     
     // === 주문 API ===
-    bool addOrder(OrderPtr order);
-    bool cancelOrder(const std::string& symbol, const std::string& order_id);
+    // source 는 명령이 온 Kafka 메시지 위치 (저널에 함께 기록)
+    bool addOrder(OrderPtr order, SourcePosition source = SourcePosition());
+    bool cancelOrder(const std::string& symbol, const std::string& order_id,
+                     SourcePosition source = SourcePosition());
     bool replaceOrder(const std::string& symbol, const std::string& order_id,
-                      int64_t qty_delta, liquibook::book::Price new_price);
+                      int64_t qty_delta, liquibook::book::Price new_price,
+                      SourcePosition source = SourcePosition());
+    // 명령을 종목별로 모아 종목마다 OrderBook::apply_batch 로 적용한다.
+    // 종목 안의 순서는 그대로이고 depth / BBO 는 종목마다 한 번만 발행된다.
+    // 저널 레코드는 매칭 전에 묶음 전체를 한 번에 기록한다.
+    // 취소 / 정정 대상은 묶음을 적용하기 전에 찾으므로, 같은 묶음의 앞선 명령에
+    // 전량 체결된 주문이면 저널에는 남고 오더북에서 거부된다 (재생 결과는 같다).
+    // 적용한 명령 수 반환
+    size_t applyBatch(std::vector<Command>& commands);
+    
+    // === 저널 API ===
+    // 설정하면 모든 주문 명령을 매칭 전에 저널에 기록한다
+    // (sequence 는 저널이 부여하므로 여러 엔진이 한 저널을 함께 쓸 수 있다)
+    void setJournal(JournalWriter* journal);
+    // 저널 재생: 각 오더북의 스냅샷 sequence 이후 명령만 적용
+    // symbol이 비어 있으면 전체, up_to까지의 명령만 적용
+    size_t replayJournal(const std::string& path,
+                         const std::string& symbol = "",
+                         uint64_t up_to = UINT64_MAX);
+    // 열어 둔 reader로 재생. 다시 호출하면 그 사이 추가된 명령만 적용한다
+    size_t replayJournal(JournalReader& reader,
+                         const std::string& symbol = "",
+                         uint64_t up_to = UINT64_MAX);
+    // filter 가 true 인 종목의 명령만 적용
+    size_t replayJournal(JournalReader& reader,
+                         const SymbolFilter& filter,
+                         uint64_t up_to = UINT64_MAX);
+    uint64_t lastSequence() const;
+    // 오더북에 마지막으로 적용한 sequence (없으면 0)
+    uint64_t bookSequence(const std::string& symbol) const;
     
     // === 스냅샷 API (gRPC용) ===
     std::string snapshotOrderBook(const std::string& symbol);
     bool restoreOrderBook(const std::string& symbol, const std::string& data);
     bool removeOrderBook(const std::string& symbol);
     
+    // === 바이너리 스냅샷 API (snapshot_file.h) ===
+    // 시간 우선순위, 부분 체결, stop 주문, 시장가까지 한 번의 순회로 기록
+    // (파일 쓰기는 락 밖에서). 종목이 isValidSymbol 이 아니거나 path 가 비었거나
+    // 주문 문자열이 테이블에 담기지 않으면 파일을 쓰지 않고 false
+    bool saveBookSnapshot(const std::string& symbol, const std::string& path);
+    // 파일을 mmap 해서 매칭 없이 오더북을 다시 만든다
+    // 복원한 종목을 반환 (실패 시 빈 문자열)
+    std::string loadBookSnapshot(const std::string& path);
+    
     // === 메트릭 API ===
     size_t getSymbolCount() const;
     size_t getOrderCount(const std::string& symbol) const;
+    size_t getActiveOrderCount() const;
     std::vector<std::string> getAllSymbols() const;
     uint64_t getTotalOrdersProcessed() const { return total_orders_processed_; }
     uint64_t getTotalTradesExecuted() const { return total_trades_executed_; }
@@ -39,16 +158,67 @@ public:
     void incrementTradeCount() { ++total_trades_executed_; }
     
 private:
-    OrderBookPtr getOrCreateBook(const std::string& symbol);
+    // 종목별 상태 (종목 id 로 인덱스)
+    struct BookState {
+        OrderBookPtr book;       // nullptr 이면 오더북 없음 (주문 인덱스는 오더북에)
+        uint64_t sequence = 0;   // 마지막으로 적용한 저널 sequence
+    };
+    
+    // 종목을 인턴하고 상태를 돌려준다 (새 종목이면 books_ 가 커지므로
+    // 반환한 참조는 다른 종목을 인턴하기 전까지만 쓴다)
+    BookState& stateFor(const std::string& symbol);
+    // 오더북이 있는 종목의 상태, 없으면 nullptr
+    BookState* findBook(const std::string& symbol);
+    const BookState* findBook(const std::string& symbol) const;
+    BookState& getOrCreateBook(const std::string& symbol);
     OrderPtr findOrder(const std::string& symbol, const std::string& order_id);
+    void attachListeners(OrderBook& book);
+    
+    // 저널 기록 (락 안에서 호출). 저널이 담을 수 없는 레코드면 false
+    bool journal(JournalRecord& record);
+    static JournalRecord addRecord(const Order& order, SourcePosition source);
+    static JournalRecord cancelRecord(const std::string& symbol,
+                                      const std::string& order_id,
+                                      SourcePosition source);
+    static JournalRecord replaceRecord(const std::string& symbol,
+                                       const std::string& order_id,
+                                       int64_t qty_delta,
+                                       liquibook::book::Price new_price,
+                                       SourcePosition source);
     
-    std::map<std::string, OrderBookPtr> books_;
-    std::map<std::string, std::map<std::string, OrderPtr>> order_maps_;
+    // 명령 적용 (락 안에서 호출, 저널 기록 없음)
+    void applyAdd(const OrderPtr& order);
+    bool applyCancel(const std::string& symbol, const std::string& order_id);
+    bool applyReplace(const std::string& symbol, const std::string& order_id,
+                      int64_t qty_delta, liquibook::book::Price new_price);
+    
+    SymbolTable symbols_;
+    std::vector<BookState> books_;
+    // applyBatch 작업 공간 (명령마다 할당하지 않도록 재사용)
+    struct BatchGroup {
+        SymbolTable::Id id;
+        size_t begin;            // batch_commands_ 안의 범위
+        size_t end;
+        size_t last_record;      // 이 종목의 마지막 저널 레코드 (batch_journal_ 안)
+    };
+    std::vector<std::pair<SymbolTable::Id, size_t>> batch_order_;
+    std::vector<OrderBook::TypedCommand> batch_commands_;
+    std::vector<BatchGroup> batch_groups_;
+    JournalBatch batch_journal_;
+    size_t book_capacity_;
     mutable std::mutex mutex_;
     MarketDataHandler* handler_;
+    // 오더북에 붙일 핸들러 (재생 중에는 발행 없이 체결 상태만 갱신)
+    MarketDataHandler* order_listener_;
+    MarketDataHandler* depth_listener_;
+    
+    // 저널
+    JournalWriter* journal_ = nullptr;
+    uint64_t sequence_ = 0;                          // 마지막으로 부여한 sequence
     
-    uint64_t total_orders_processed_ = 0;
-    uint64_t total_trades_executed_ = 0;
+    // 샤드 워커 밖에서도 읽으므로 atomic
+    std::atomic<uint64_t> total_orders_processed_{0};
+    std::atomic<uint64_t> total_trades_executed_{0};
 };
 
 } // namespace aws_wrapper
@@ -2,7 +2,7 @@
 
 #include <grpcpp/grpcpp.h>
 #include "snapshot.grpc.pb.h"
-#include "engine_core.h"
+#include "sharded_engine.h"
 #include "redis_client.h"
 #include <thread>
 #include <atomic>
@@ -12,7 +12,7 @@ namespace aws_wrapper {
 
 class GrpcServiceImpl final : public SnapshotService::Service {
 public:
-    GrpcServiceImpl(EngineCore* engine, RedisClient* redis);
+    GrpcServiceImpl(ShardedEngine* engine, RedisClient* redis);
     
     grpc::Status CreateSnapshot(grpc::ServerContext* context,
                                  const SnapshotRequest* request,
@@ -31,14 +31,14 @@ public:
                               HealthResponse* response) override;
 
 private:
-    EngineCore* engine_;
+    ShardedEngine* engine_;
     RedisClient* redis_;
     std::chrono::steady_clock::time_point start_time_;
 };
 
 class GrpcService {
 public:
-    GrpcService(EngineCore* engine, RedisClient* redis);
+    GrpcService(ShardedEngine* engine, RedisClient* redis);
     ~GrpcService();
     
     void start(int port);
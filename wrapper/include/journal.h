@@ -0,0 +1,154 @@
+#pragma once
+
+#include <book/types.h>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace aws_wrapper {
+
+// === 입력 명령 저널 ===
+// 엔진이 매칭 전에 기록하는 append-only 바이너리 로그.
+// 마지막 스냅샷 + 저널 tail 재생으로 오더북을 정확히 복구한다.
+//
+// 레코드 포맷 (little-endian):
+//   u32 payload 길이 | u32 CRC32(payload) | payload
+// payload:
+//   u64 sequence | u8 op | u8 is_buy | u32 conditions |
+//   u64 price | u64 quantity | u64 stop_price | i64 timestamp |
+//   i64 qty_delta | u64 new_price |
+//   (u16 길이 + 바이트) symbol, order_id, user_id |
+//   i32 source partition | i64 source offset
+// (source 필드가 없는 예전 레코드는 source 없음으로 읽는다)
+
+enum class JournalOp : uint8_t {
+    ADD = 1,
+    CANCEL = 2,
+    REPLACE = 3,
+    // 주문 명령이 아닌 입력 위치 표시: source 파티션의 source offset 미만
+    // 메시지는 모두 처리됐다 (source_offsets.h)
+    OFFSET = 4
+};
+
+// 명령이 온 Kafka 메시지 위치 (partition 이 -1 이면 없음)
+struct SourcePosition {
+    int32_t partition = -1;
+    int64_t offset = -1;
+};
+
+struct JournalRecord {
+    uint64_t sequence = 0;
+    JournalOp op = JournalOp::ADD;
+    std::string symbol;
+    std::string order_id;
+    std::string user_id;
+    bool is_buy = true;
+    liquibook::book::Price price = 0;
+    liquibook::book::Quantity quantity = 0;
+    liquibook::book::Price stop_price = 0;
+    liquibook::book::OrderConditions conditions = 0;
+    int64_t timestamp = 0;
+    int64_t qty_delta = 0;              // REPLACE
+    liquibook::book::Price new_price = 0;  // REPLACE
+    SourcePosition source;
+};
+
+// 저널 읽기. 끝이 잘린(쓰다 만) 레코드나 CRC가 맞지 않는 레코드에서 멈춘다.
+// 멈춘 뒤 다시 next()를 부르면 그 레코드부터 다시 읽으므로, 쓰는 중인 저널을
+// 따라 읽을 수 있다.
+class JournalReader {
+public:
+    explicit JournalReader(const std::string& path);
+    ~JournalReader();
+
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    bool isOpen() const { return file_ != nullptr; }
+
+    // 다음 레코드. 더 이상 온전한 레코드가 없으면 false
+    bool next(JournalRecord& record);
+
+    // 마지막으로 읽은 온전한 레코드의 끝 위치 (바이트)
+    uint64_t validBytes() const { return valid_bytes_; }
+
+private:
+    bool read(JournalRecord& record);
+
+    std::FILE* file_ = nullptr;
+    std::string payload_;
+    uint64_t valid_bytes_ = 0;
+};
+
+// 저널 레코드로 쓸 수 있는가. 문자열은 u16 길이까지, payload 는 64KB 까지이고
+// 넘는 레코드는 읽을 때 거부되므로 쓰지 않는다
+bool journalRecordFits(const JournalRecord& record);
+
+// 한 번에 기록할 레코드 묶음. 샤드 워커가 꺼낸 명령 묶음의 레코드를 락 없이
+// 자기 버퍼에 인코딩해 두고 JournalWriter::append(JournalBatch&) 로 한 번에 쓴다.
+// 샤드마다 하나씩 쓰고 스레드 안전하지 않다.
+class JournalBatch {
+public:
+    JournalBatch() { buffer_.reserve(4096); }
+
+    // record.sequence 는 무시하고 기록할 때 부여한다.
+    // journalRecordFits 가 false 인 레코드는 넣지 않고 false
+    bool add(const JournalRecord& record);
+    size_t size() const { return offsets_.size(); }
+    bool empty() const { return offsets_.empty(); }
+    void clear();
+
+    // 기록한 뒤 index 번째 레코드의 sequence (묶음 안에서 연속)
+    uint64_t sequence(size_t index) const { return first_sequence_ + index; }
+
+private:
+    friend class JournalWriter;
+
+    std::string buffer_;
+    std::vector<size_t> offsets_;      // 레코드마다 buffer_ 안의 시작 위치
+    uint64_t first_sequence_ = 0;
+};
+
+// 저널 쓰기. 열 때 기존 저널의 잘린 tail을 잘라내고 이어서 쓴다.
+// 여러 엔진 샤드가 함께 쓰므로 append 는 스레드 안전하고 sequence 도 여기서
+// 부여한다 (파일 안의 sequence 는 항상 증가).
+class JournalWriter {
+public:
+    // sync_each: append 마다 fdatasync (기본은 OS 페이지 캐시까지만 기록)
+    explicit JournalWriter(const std::string& path, bool sync_each = false);
+    ~JournalWriter();
+
+    JournalWriter(const JournalWriter&) = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+
+    bool isOpen() const { return file_ != nullptr; }
+
+    // 다음 sequence 를 record.sequence 에 부여하고 추가.
+    // 반환 전에 커널로 write 된다. journalRecordFits 가 false 면 sequence 를
+    // 부여하지 않고 false
+    bool append(JournalRecord& record);
+    // 묶음의 레코드에 연속된 sequence 를 부여하고 write 한 번으로 추가
+    // (락 한 번, flush 한 번. 파일 안의 sequence 순서는 그대로다)
+    bool append(JournalBatch& batch);
+
+    // 디스크까지 flush
+    void sync();
+
+    // 저널의 마지막 sequence (없으면 0)
+    uint64_t lastSequence() const;
+
+    // 다음 sequence 가 sequence 보다 크게 한다 (저널이 스냅샷보다 짧을 때,
+    // 새 명령이 스냅샷에 이미 반영된 명령으로 보이지 않도록)
+    void advanceTo(uint64_t sequence);
+
+private:
+    mutable std::mutex mutex_;
+    std::FILE* file_ = nullptr;
+    std::string buffer_;
+    bool sync_each_;
+    uint64_t last_sequence_ = 0;
+};
+
+} // namespace aws_wrapper
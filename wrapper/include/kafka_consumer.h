@@ -2,36 +2,122 @@
 
 #include <librdkafka/rdkafkacpp.h>
 #include <string>
+#include <string_view>
 #include <functional>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
 
 namespace aws_wrapper {
 
+// 한 번 poll 로 받은 메시지 묶음. librdkafka 메시지 버퍼를 그대로 들고 있어
+// key/value 를 복사 없이 본다 (배치가 살아 있는 동안만 유효).
+class MessageBatch {
+public:
+    size_t size() const { return messages_.size(); }
+    bool empty() const { return messages_.empty(); }
+    std::string_view key(size_t index) const;
+    std::string_view value(size_t index) const;
+    int32_t partition(size_t index) const { return messages_[index]->partition(); }
+    int64_t offset(size_t index) const { return messages_[index]->offset(); }
+
+private:
+    friend class KafkaConsumer;
+    std::vector<std::unique_ptr<RdKafka::Message>> messages_;
+};
+
 class KafkaConsumer {
 public:
     using MessageCallback = std::function<void(const std::string& key,
                                                 const std::string& value)>;
-    
+    // applied 는 배치의 명령이 오더북에 반영된 뒤 한 번 부른다 (다른 스레드에서도 된다).
+    // 그 뒤에야 배치의 offset 을 커밋한다.
+    using BatchCallback = std::function<void(const MessageBatch& batch,
+                                              std::function<void()> applied)>;
+
+    // batch_size 가 0 이면 메시지마다 콜백 (auto commit).
+    // 0 보다 크면 배치 모드: 할당받은 파티션마다 전용 큐와 스레드를 두고, 그 스레드가
+    // 최대 batch_size 개씩 받아 BatchCallback 을 부른다 (수동 commit).
+    // 배치 하나에는 한 파티션의 메시지만 들어 있고, 여러 파티션의 콜백은 동시에 불린다.
     KafkaConsumer(const std::string& brokers,
                   const std::string& topic,
-                  const std::string& group_id);
+                  const std::string& group_id,
+                  size_t batch_size = 0);
     ~KafkaConsumer();
-    
+
     void setCallback(MessageCallback callback) { callback_ = std::move(callback); }
+    void setBatchCallback(BatchCallback callback) { batch_callback_ = std::move(callback); }
+    // 배치 모드에서 파티션을 처음 할당받을 때 커밋된 offset 대신 이 offset 부터 읽는다
+    // (스냅샷과 저널이 반영한 입력 위치, source_offsets.h). start() 전에 부른다
+    void setStartOffsets(std::map<int32_t, int64_t> offsets) { start_offsets_ = std::move(offsets); }
     void start();
     void stop();
     bool isRunning() const { return running_; }
-    
+
 private:
     void consumeLoop();
-    
+
+    // === 배치 모드 ===
+    // 파티션 하나를 맡는 스레드. librdkafka 파티션 큐를 consumer 큐로 넘기지 않고 직접 읽는다
+    struct PartitionWorker {
+        int32_t partition = 0;
+        std::unique_ptr<RdKafka::Queue> queue;
+        std::atomic<bool> running{true};
+        std::thread thread;
+    };
+
+    // 그룹 리밸런스 콜백 (consumer_->consume() 을 부른 poll 스레드에서 불린다)
+    class Rebalancer : public RdKafka::RebalanceCb {
+    public:
+        explicit Rebalancer(KafkaConsumer* owner) : owner_(owner) {}
+        void rebalance_cb(RdKafka::KafkaConsumer* consumer,
+                          RdKafka::ErrorCode err,
+                          std::vector<RdKafka::TopicPartition*>& partitions) override {
+            owner_->rebalance(consumer, err, partitions);
+        }
+    private:
+        KafkaConsumer* owner_;
+    };
+
+    void pollLoop();
+    void partitionLoop(PartitionWorker* worker);
+    void rebalance(RdKafka::KafkaConsumer* consumer,
+                   RdKafka::ErrorCode err,
+                   std::vector<RdKafka::TopicPartition*>& partitions);
+    void startPartition(RdKafka::TopicPartition* partition);
+    // 파티션 스레드를 멈추고, 넘긴 배치가 반영되면 커밋한 뒤 소유를 내려놓는다
+    void stopPartition(int32_t partition);
+    std::unique_ptr<MessageBatch> pollBatch(RdKafka::Queue& queue);
+    void dispatch(int32_t partition, std::unique_ptr<MessageBatch> batch);
+    void markApplied(int32_t partition, int64_t offset);
+    // 넘긴 배치가 반영될 때까지 기다린다 (partition 이 -1 이면 모든 파티션)
+    bool waitApplied(int32_t partition);
+    // 반영된 offset 커밋 (poll 스레드, 리밸런스와 종료 시에는 sync)
+    void commitApplied(bool sync);
+
     std::unique_ptr<RdKafka::KafkaConsumer> consumer_;
     MessageCallback callback_;
+    BatchCallback batch_callback_;
     std::thread worker_;
     std::atomic<bool> running_{false};
     std::string topic_;
+
+    size_t batch_size_;
+    Rebalancer rebalancer_{this};
+    // poll 스레드 (리밸런스 콜백) 와 stop() 만 건드린다
+    std::map<int32_t, std::unique_ptr<PartitionWorker>> workers_;
+    std::map<int32_t, int64_t> start_offsets_;   // 아직 할당받지 않은 파티션의 시작 offset
+
+    std::mutex commit_mutex_;
+    std::condition_variable commit_done_;   // 넘긴 배치가 반영됨
+    std::set<int32_t> assigned_;                    // 지금 소유한 파티션
+    std::map<int32_t, int64_t> applied_offsets_;   // 파티션 → 커밋할 다음 offset
+    std::map<int32_t, size_t> outstanding_;        // 콜백에 넘겼지만 아직 반영 전인 배치
 };
 
 } // namespace aws_wrapper
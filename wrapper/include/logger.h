@@ -3,6 +3,7 @@
 #include <iostream>
 #include <string>
 #include <chrono>
+#include <ctime>
 #include <iomanip>
 #include <sstream>
 
@@ -46,11 +47,13 @@ private:
     static std::string timestamp() {
         auto now = std::chrono::system_clock::now();
         auto time = std::chrono::system_clock::to_time_t(now);
+        std::tm tm{};
+        localtime_r(&time, &tm);
         auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
             now.time_since_epoch()) % 1000;
         
         std::stringstream ss;
-        ss << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S");
+        ss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
         ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
         return ss.str();
     }
@@ -60,10 +63,12 @@ private:
                     const std::string& msg, Args&&... args) {
         if (level < level_) return;
         
-        std::cout << "[" << timestamp() << "] [" << levelStr << "] " 
-                  << msg;
-        ((std::cout << " " << args), ...);
-        std::cout << std::endl;
+        // 엔진 샤드 스레드끼리 줄이 섞이지 않도록 한 번에 쓴다
+        std::ostringstream line;
+        line << "[" << timestamp() << "] [" << levelStr << "] " << msg;
+        ((line << " " << args), ...);
+        line << '\n';
+        std::cout << line.str() << std::flush;
     }
 };
 
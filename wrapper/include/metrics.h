@@ -31,6 +31,9 @@ public:
     // 게이지
     void setSymbolCount(size_t count) { symbol_count_ = count; }
     void setActiveOrders(size_t count) { active_orders_ = count; }
+    void setQueuedCommands(size_t count) { queued_commands_ = count; }
+    void setHeapAllocations(uint64_t count) { heap_allocations_ = count; }
+    void setOrderAllocations(uint64_t count) { order_allocations_ = count; }
     
     // 리포트 (CloudWatch용)
     std::string toJson() const;
@@ -54,6 +57,9 @@ private:
     
     std::atomic<size_t> symbol_count_{0};
     std::atomic<size_t> active_orders_{0};
+    std::atomic<size_t> queued_commands_{0};   // 엔진 샤드 큐에서 대기 중인 명령
+    std::atomic<uint64_t> heap_allocations_{0};   // 프로세스 전체 operator new 호출 수
+    std::atomic<uint64_t> order_allocations_{0};  // OrderPool 이 새로 만든 주문 수
     
     // 레이턴시 통계
     mutable std::mutex latency_mutex_;
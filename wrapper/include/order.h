@@ -3,31 +3,46 @@
 #include <book/order.h>
 #include <book/types.h>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <cstdint>
 #include <nlohmann/json.hpp>
 
 namespace aws_wrapper {
 
-class Order : public liquibook::book::Order {
+// order_id, user_id, symbol 의 최대 길이 (바이너리 주문 메시지의 u8 길이와 같다).
+// 입력 디코딩에서 넘는 주문을 거부하므로 저널 / 스냅샷 레코드가 항상 담을 수 있다
+constexpr size_t MAX_ORDER_FIELD_LENGTH = 255;
+
+// 종목은 스냅샷 파일 이름 (<dir>/<symbol>.snap) 이 되므로 1~255자의
+// [A-Za-z0-9._-] 만 받고 '.' 으로 시작하면 안 된다 ("..", 숨김 파일 방지).
+// 입력 디코딩에서 이를 어기는 주문을 거부한다
+bool isValidSymbol(std::string_view symbol);
+
+class Order final : public liquibook::book::Order {
 public:
     Order() = default;
     
-    // Kafka JSON에서 파싱하여 생성
+    // Kafka JSON에서 파싱하여 생성 (OrderPool 에서 꺼낸 주문에 채운다)
+    // 문자열 필드가 MAX_ORDER_FIELD_LENGTH 를 넘거나 종목이 isValidSymbol 이 아니면
+    // std::runtime_error
     static std::shared_ptr<Order> fromJson(const nlohmann::json& j);
     
+    // 모든 필드를 기본값으로 (문자열 버퍼 용량은 유지, OrderPool 재사용용)
+    void reset();
+    
     // JSON으로 직렬화 (스냅샷용)
     nlohmann::json toJson() const;
     
-    // === Liquibook Order 인터페이스 구현 ===
-    bool is_buy() const override { return is_buy_; }
-    liquibook::book::Price price() const override { return price_; }
-    liquibook::book::Quantity order_qty() const override { return order_qty_; }
-    liquibook::book::Price stop_price() const override { return stop_price_; }
-    bool all_or_none() const override { 
+    // === Liquibook Order concept 구현 (non-virtual, 인라인) ===
+    bool is_buy() const { return is_buy_; }
+    liquibook::book::Price price() const { return price_; }
+    liquibook::book::Quantity order_qty() const { return order_qty_; }
+    liquibook::book::Price stop_price() const { return stop_price_; }
+    bool all_or_none() const { 
         return (conditions_ & liquibook::book::oc_all_or_none) != 0; 
     }
-    bool immediate_or_cancel() const override { 
+    bool immediate_or_cancel() const { 
         return (conditions_ & liquibook::book::oc_immediate_or_cancel) != 0; 
     }
     
@@ -53,15 +68,20 @@ public:
     liquibook::book::Cost filled_cost() const { return filled_cost_; }
     
     // Setters (for testing/restoration)
-    void setOrderId(const std::string& id) { order_id_ = id; }
-    void setUserId(const std::string& id) { user_id_ = id; }
-    void setSymbol(const std::string& sym) { symbol_ = sym; }
+    // string_view 로 받아 기존 버퍼에 복사한다 (풀에서 꺼낸 주문의 용량 재사용)
+    void setOrderId(std::string_view id) { order_id_ = id; }
+    void setUserId(std::string_view id) { user_id_ = id; }
+    void setSymbol(std::string_view sym) { symbol_ = sym; }
     void setIsBuy(bool buy) { is_buy_ = buy; }
     void setPrice(liquibook::book::Price p) { price_ = p; }
     void setOrderQty(liquibook::book::Quantity q) { order_qty_ = q; }
     void setStopPrice(liquibook::book::Price p) { stop_price_ = p; }
     void setConditions(liquibook::book::OrderConditions c) { conditions_ = c; }
     void setTimestamp(int64_t ts) { timestamp_ = ts; }
+    void setFilled(liquibook::book::Quantity qty, liquibook::book::Cost cost) {
+        filled_qty_ = qty;
+        filled_cost_ = cost;
+    }
 
 private:
     std::string order_id_;
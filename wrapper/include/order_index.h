@@ -0,0 +1,69 @@
+#pragma once
+
+#include "order.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace aws_wrapper {
+
+// === 주문 ID 인덱스 ===
+// 오더북 하나의 order_id → 주문. open addressing (linear probing) 해시 테이블로
+// 슬롯에 해시 값을 함께 두어 문자열 비교는 해시가 같을 때만 한다.
+// 키는 주문의 order_id() 를 그대로 쓰므로 문자열을 따로 복사해 두지 않는다.
+// 삭제는 뒤 슬롯을 당겨 채우므로 (backward shift) tombstone 이 쌓이지 않는다.
+// 부하율 3/4 를 넘으면 두 배로 늘린다. reserve() 로 미리 잡아 두면 그만큼은
+// 다시 할당하지 않는다.
+class OrderIndex {
+public:
+    OrderIndex() = default;
+    explicit OrderIndex(size_t capacity) { reserve(capacity); }
+
+    // count 개까지 다시 할당하지 않도록 슬롯을 잡는다
+    void reserve(size_t count);
+
+    // 없으면 nullptr. 다음 insert/erase 전까지만 유효
+    const OrderPtr* find(const std::string& order_id) const;
+
+    // 같은 order_id 가 있으면 교체
+    void insert(const OrderPtr& order);
+
+    bool erase(const std::string& order_id);
+    // 그 order_id 로 인덱스된 주문이 바로 이 주문일 때만 뺀다
+    bool erase(const OrderPtr& order);
+
+    // 슬롯은 그대로 두고 비운다
+    void clear();
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return slots_.size(); }
+
+    // 모든 주문 (순서는 정해져 있지 않다)
+    template <typename Visit>
+    void forEach(Visit&& visit) const {
+        for (const auto& slot : slots_) {
+            if (slot.order) {
+                visit(slot.order);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        size_t hash = 0;
+        OrderPtr order;    // nullptr 이면 빈 슬롯
+    };
+
+    static size_t hashOf(const std::string& order_id);
+    // order_id 가 있는 슬롯, 없으면 탐색이 멈춘 빈 슬롯
+    size_t probe(const std::string& order_id, size_t hash) const;
+    void eraseAt(size_t hole);
+    void rehash(size_t slot_count);
+
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace aws_wrapper
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "order_wire.h"
+#include <string_view>
+
+namespace aws_wrapper {
+
+// === 주문 JSON 빠른 경로 ===
+// Lambda 주문 라우터가 보내는 평평한 주문 객체만 nlohmann::json DOM 없이 읽는다.
+// 문자열은 SIMD (SSE2) 로 따옴표/이스케이프/제어 문자를 한 번에 16바이트씩 찾고,
+// 알려진 필드는 풀에서 꺼낸 Order 에 바로 채운다. 모르는 키의 스칼라 값은 건너뛴다.
+//
+// 이스케이프나 비 ASCII 문자열, 소수/지수, 중첩 객체 (conditions 등), null,
+// 범위를 넘는 정수, 모르는 action, MAX_ORDER_FIELD_LENGTH 를 넘는 문자열,
+// isValidSymbol 이 아닌 종목처럼 처리하지 않는 모양이면 false 를 돌려준다.
+// 그때는 호출자가 nlohmann 경로로 다시 읽는다 (결과는 두 경로가 같다).
+bool decodeOrderJson(std::string_view value, OrderMessage& message);
+
+} // namespace aws_wrapper
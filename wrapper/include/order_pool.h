@@ -0,0 +1,112 @@
+#pragma once
+
+#include "order.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace aws_wrapper {
+
+// === 주문 객체 풀 ===
+// 마지막 OrderPtr 가 사라지면 Order 를 지우지 않고 reset() 해서 풀에 돌려준다.
+// 문자열 멤버는 clear() 만 하므로 order_id 같은 버퍼 용량이 다음 주문에 그대로
+// 재사용된다. shared_ptr 제어 블록도 같은 크기의 블록 free list 에서 꺼내므로,
+// 풀이 데워진 뒤에는 acquire() 가 힙 할당을 하지 않는다.
+//
+// consumer 스레드에서 꺼내고 샤드 워커에서 돌려주므로 스레드마다 작은 캐시를 두고,
+// 락으로 보호하는 공유 free list 와는 TRANSFER 개씩 한꺼번에 주고받는다
+// (락은 주문마다가 아니라 TRANSFER 개마다 한 번). 스레드가 끝나면 캐시는 공유
+// free list 로 돌아간다. 공유 free list 에 쌓아 두는 개수는 max_free 까지이고,
+// 넘치면 그냥 해제한다.
+class OrderPool {
+public:
+    // 제어 블록 크기 상한 (deleter, allocator 가 포인터 하나씩이라 충분하다)
+    static constexpr size_t BLOCK_SIZE = 64;
+    static constexpr size_t DEFAULT_MAX_FREE = 1 << 20;
+    // 스레드 캐시와 공유 free list 사이에 한 번에 옮기는 개수
+    // (스레드 캐시는 종류마다 2 * TRANSFER 개까지 갖는다)
+    static constexpr size_t TRANSFER = 64;
+
+    // 프로세스 전체에서 쓰는 풀. 종료 시점에 남은 주문이 돌아와도 안전하도록
+    // 해제하지 않는다.
+    static OrderPool& instance();
+
+    explicit OrderPool(size_t max_free = DEFAULT_MAX_FREE);
+    ~OrderPool();
+
+    OrderPool(const OrderPool&) = delete;
+    OrderPool& operator=(const OrderPool&) = delete;
+
+    // 빈 주문 (모든 필드 기본값)
+    OrderPtr acquire();
+
+    // 주문 count 개를 미리 만들어 둔다
+    void reserve(size_t count);
+
+    // 풀에서 새로 할당한 주문 수 / 재사용한 주문 수
+    uint64_t allocated() const { return allocated_.load(std::memory_order_relaxed); }
+    uint64_t reused() const { return reused_.load(std::memory_order_relaxed); }
+    // 공유 free list 와 호출한 스레드의 캐시에 있는 주문 수
+    size_t freeCount() const;
+
+private:
+    // OrderPtr 의 deleter: 풀에 돌려준다
+    struct Recycler {
+        OrderPool* pool;
+        void operator()(Order* order) const { pool->release(order); }
+    };
+
+    // shared_ptr 제어 블록 할당자
+    template <typename T>
+    struct BlockAllocator {
+        using value_type = T;
+
+        explicit BlockAllocator(OrderPool* p) : pool(p) {}
+        template <typename U>
+        BlockAllocator(const BlockAllocator<U>& other) : pool(other.pool) {}
+
+        T* allocate(size_t n) {
+            static_assert(sizeof(T) <= BLOCK_SIZE, "control block larger than BLOCK_SIZE");
+            static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                          "control block over-aligned");
+            if (n != 1) {
+                return static_cast<T*>(::operator new(n * sizeof(T)));
+            }
+            return static_cast<T*>(pool->allocateBlock());
+        }
+        void deallocate(T* p, size_t n) {
+            if (n != 1) {
+                ::operator delete(p);
+                return;
+            }
+            pool->releaseBlock(p);
+        }
+
+        template <typename U>
+        bool operator==(const BlockAllocator<U>& other) const { return pool == other.pool; }
+        template <typename U>
+        bool operator!=(const BlockAllocator<U>& other) const { return pool != other.pool; }
+
+        OrderPool* pool;
+    };
+
+    // 공유 free list. 풀이 먼저 사라져도 스레드 캐시가 돌려줄 곳이 남도록
+    // 풀과 스레드 캐시가 함께 갖는다
+    struct Depot;
+    struct ThreadCache;
+
+    // 호출한 스레드의 캐시 (이 풀에 묶어서). 스레드가 끝나는 중이면 nullptr
+    ThreadCache* threadCache() const;
+
+    void release(Order* order);
+    void* allocateBlock();
+    void releaseBlock(void* block);
+
+    std::shared_ptr<Depot> depot_;
+    std::atomic<uint64_t> allocated_{0};
+    std::atomic<uint64_t> reused_{0};
+};
+
+} // namespace aws_wrapper
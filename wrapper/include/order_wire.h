@@ -0,0 +1,58 @@
+#pragma once
+
+#include "journal.h"
+#include "order.h"
+#include <book/types.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace aws_wrapper {
+
+// === 주문 메시지 (Kafka/Kinesis 입력) ===
+// 첫 바이트가 content type 이다. WIRE_BINARY 면 아래 고정 레이아웃 바이너리,
+// 그 밖의 값 ('{' 등) 이면 JSON 메시지로 읽는다 (order_json.h 빠른 경로, 안 되면 nlohmann).
+//
+// 바이너리 레이아웃 (little-endian, version 1):
+//   0   u8   content type (WIRE_BINARY)
+//   1   u8   version
+//   2   u8   action (JournalOp: 1 ADD, 2 CANCEL, 3 REPLACE)
+//   3   u8   flags (WIRE_FLAG_*)
+//   4   u8   order_id 길이
+//   5   u8   user_id 길이
+//   6   u8   symbol 길이
+//   7   u8   reserved (0)
+//   8   u64  price
+//   16  u64  quantity
+//   24  u64  stop_price
+//   32  i64  timestamp (ms, 0 이면 수신 시각)
+//   40  i64  qty_delta (REPLACE)
+//   48  u64  new_price (REPLACE)
+//   56  order_id, user_id, symbol 바이트 (길이만큼 이어서)
+// 바이너리 메시지는 DOM 없이 풀에서 꺼낸 Order 에 바로 채운다.
+constexpr uint8_t WIRE_BINARY = 0x01;
+constexpr uint8_t WIRE_VERSION = 1;
+constexpr size_t WIRE_HEADER_SIZE = 56;
+
+constexpr uint8_t WIRE_FLAG_BUY = 0x01;
+constexpr uint8_t WIRE_FLAG_ALL_OR_NONE = 0x02;
+constexpr uint8_t WIRE_FLAG_IMMEDIATE_OR_CANCEL = 0x04;
+
+struct OrderMessage {
+    JournalOp action = JournalOp::ADD;
+    OrderPtr order;                        // CANCEL/REPLACE 는 symbol, order_id 만 사용
+    int64_t qty_delta = 0;                 // REPLACE
+    liquibook::book::Price new_price = 0;
+};
+
+// 형식이 잘못되면 예외 (바이너리는 std::runtime_error, JSON 은 nlohmann 예외).
+// 문자열이 너무 길거나 종목이 isValidSymbol 이 아니면 std::runtime_error
+// value 는 호출하는 동안만 유효하면 된다 (Kafka 메시지 버퍼를 그대로 넘겨도 된다)
+OrderMessage decodeOrderMessage(std::string_view value);
+
+// 바이너리로 인코딩 (문자열 필드는 255 바이트까지, 넘거나 종목이
+// isValidSymbol 이 아니면 std::runtime_error)
+std::string encodeOrderMessage(const OrderMessage& message);
+
+} // namespace aws_wrapper
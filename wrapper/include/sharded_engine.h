@@ -0,0 +1,132 @@
+#pragma once
+
+#include "engine_core.h"
+#include "iproducer.h"
+#include "journal.h"
+#include "market_data_handler.h"
+#include "redis_client.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aws_wrapper {
+
+// === 종목 샤딩 엔진 ===
+// 종목을 해시로 N개 샤드에 나눈다. 샤드마다 EngineCore(오더북, 주문 인덱스),
+// MarketDataHandler, depth 캐시 연결, 명령 큐, 워커 스레드를 따로 가지므로
+// 매칭 경로에는 샤드 사이에 공유하는 락이 없다 (저널만 공유하고, 샤드마다 자기
+// 버퍼에 모은 레코드를 꺼낸 묶음마다 한 번에 append 한다).
+// 한 종목의 명령은 항상 같은 샤드 큐로 들어가 받은 순서대로 처리된다.
+// 워커는 큐에서 한 번에 꺼낸 명령을 배리어 사이마다 EngineCore::applyBatch 로
+// 넘기므로 depth / BBO 는 꺼낸 묶음마다 종목당 한 번 발행된다.
+//
+// submit* 는 consumer 스레드에서 호출한다. 큐가 가득 차면 워커가 따라잡을
+// 때까지 기다린다.
+class ShardedEngine {
+public:
+    // depth_cache_host 가 비어 있으면 depth 캐시 없이 실행
+    // (hiredis 연결은 스레드 안전하지 않아 샤드마다 따로 연결한다)
+    ShardedEngine(size_t shard_count,
+                  IProducer* producer,
+                  const std::string& depth_cache_host = "",
+                  int depth_cache_port = 0,
+                  size_t queue_limit = 65536,
+                  size_t book_capacity = EngineCore::DEFAULT_BOOK_CAPACITY);
+    ~ShardedEngine();
+
+    ShardedEngine(const ShardedEngine&) = delete;
+    ShardedEngine& operator=(const ShardedEngine&) = delete;
+
+    size_t shardCount() const { return shards_.size(); }
+    size_t shardOf(const std::string& symbol) const;
+    EngineCore& shard(size_t index) { return shards_[index]->engine; }
+    EngineCore& engineFor(const std::string& symbol) { return shard(shardOf(symbol)); }
+
+    // 워커 시작 / 정지 (정지 전에 큐에 남은 명령은 모두 처리한다)
+    void start();
+    void stop();
+    // 지금까지 넣은 명령이 모두 처리될 때까지 대기
+    void drain();
+    // 기다리지 않고, 지금까지 넣은 명령이 모든 샤드에서 처리되면 done 을 부른다
+    // (마지막으로 도달한 워커 스레드에서 호출. 워커가 없으면 바로 호출)
+    void submitBarrier(std::function<void()> done);
+
+    // === 주문 API (비동기) ===
+    // source 는 명령이 온 Kafka 메시지 위치 (저널에 함께 기록)
+    void submitAdd(OrderPtr order, SourcePosition source = SourcePosition());
+    void submitCancel(const std::string& symbol, const std::string& order_id,
+                      SourcePosition source = SourcePosition());
+    void submitReplace(const std::string& symbol, const std::string& order_id,
+                       int64_t qty_delta, liquibook::book::Price new_price,
+                       SourcePosition source = SourcePosition());
+
+    // === 저널 API ===
+    // 모든 샤드가 같은 저널에 기록한다
+    void setJournal(JournalWriter* journal);
+    // 샤드마다 자기 종목만 골라 동시에 재생 (start() 전에)
+    size_t replayJournal(const std::string& path);
+    uint64_t lastSequence() const;
+
+    // === 스냅샷 API (종목의 샤드로 전달) ===
+    std::string snapshotOrderBook(const std::string& symbol);
+    bool restoreOrderBook(const std::string& symbol, const std::string& data);
+    bool removeOrderBook(const std::string& symbol);
+    bool saveBookSnapshot(const std::string& symbol, const std::string& path);
+    std::string loadBookSnapshot(const std::string& path);
+
+    // === 메트릭 API (모든 샤드 합계) ===
+    size_t getSymbolCount() const;
+    size_t getActiveOrderCount() const;
+    std::vector<std::string> getAllSymbols() const;
+    uint64_t getTotalOrdersProcessed() const;
+    uint64_t getTotalTradesExecuted() const;
+    // 큐에서 처리를 기다리는 명령 수
+    size_t getQueuedCommands() const;
+
+private:
+    struct Barrier {
+        std::atomic<size_t> remaining;
+        std::function<void()> done;
+    };
+
+    struct Command : EngineCore::Command {
+        std::shared_ptr<Barrier> barrier;      // 있으면 배리어 (op 무시)
+    };
+
+    struct Shard {
+        Shard(IProducer* producer, const std::string& depth_cache_host,
+              int depth_cache_port, size_t book_capacity);
+
+        std::unique_ptr<RedisClient> depth_cache;
+        MarketDataHandler handler;
+        EngineCore engine;
+
+        mutable std::mutex mutex;
+        std::condition_variable ready;     // 워커: 명령이 들어옴
+        std::condition_variable space;     // consumer: 큐에 자리가 남
+        std::condition_variable drained;   // drain(): 처리 완료
+        std::vector<Command> pending;
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+        bool stopping = false;
+        std::thread worker;
+    };
+
+    void submit(const std::string& symbol, Command&& command);
+    void submit(Shard& shard, Command&& command);
+    void run(Shard& shard);
+    static void apply(EngineCore& engine, Command& command);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t queue_limit_;
+    JournalWriter* journal_ = nullptr;
+    std::atomic<bool> running_{false};
+};
+
+} // namespace aws_wrapper
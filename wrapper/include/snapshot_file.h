@@ -0,0 +1,79 @@
+#pragma once
+
+#include "order.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aws_wrapper {
+
+// === 바이너리 오더북 스냅샷 파일 ===
+// 오더북을 한 번 순회해 쓰고, 복원할 때는 mmap 한 파일에서 매칭 없이
+// 우선순위 순서대로 컨테이너를 다시 만든다.
+//
+// 레이아웃 (호스트 바이트 순서, 8바이트 정렬):
+//   SnapshotFileHeader
+//   오더북 이미지 (liquibook book/book_snapshot.h)
+//     주문마다 가격, 미체결 수량, 조건, stop 여부를 우선순위 순서대로 담고
+//     order_ref 는 아래 주문 테이블의 인덱스
+//     depth 레벨도 함께 담는다
+//   주문 테이블:
+//     (u16 길이 + 바이트) symbol
+//     주문마다 (u16 길이 + 바이트) order_id, user_id |
+//       u8 is_buy | u32 conditions | u64 price | u64 order_qty |
+//       u64 filled_qty | u64 filled_cost | u64 stop_price | i64 timestamp
+// CRC 는 오더북 이미지와 주문 테이블 전체에 대한 값.
+
+struct SnapshotFileHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t crc;
+    uint32_t order_count;
+    uint64_t sequence;      // 스냅샷에 반영된 마지막 저널 sequence
+    uint64_t image_size;    // 오더북 이미지 바이트 수 (8의 배수)
+    uint64_t table_size;    // 주문 테이블 바이트 수
+};
+
+constexpr char SNAPSHOT_FILE_MAGIC[4] = {'L', 'Q', 'S', 'F'};
+constexpr uint16_t SNAPSHOT_FILE_VERSION = 1;
+
+// 주문 테이블 항목. 문자열이 u16 길이에 담기지 않으면 false
+bool encodeSnapshotOrder(const Order& order, std::string& out);
+OrderPtr decodeSnapshotOrder(const char*& p, const char* end,
+                             const std::string& symbol);
+
+// 헤더의 magic/CRC/크기를 채워 임시 파일에 쓰고 fdatasync 후 rename
+bool writeSnapshotFile(const std::string& path, SnapshotFileHeader& header,
+                       const std::vector<uint64_t>& image,
+                       const std::string& table);
+
+// 종목의 스냅샷 파일 경로 (<dir>/<symbol>.snap).
+// 종목이 isValidSymbol 이 아니면 (dir 밖을 가리킬 수 있으므로) 빈 문자열
+std::string snapshotFilePath(const std::string& dir, const std::string& symbol);
+
+// 바이너리 스냅샷 파일인지 (magic 확인)
+bool isSnapshotFile(const std::string& path);
+
+// 스냅샷 파일의 종목 (주문 테이블 첫 항목). 읽지 못하면 빈 문자열
+std::string snapshotFileSymbol(const std::string& path);
+
+// 읽기 전용 mmap
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return data_ != nullptr; }
+    const char* data() const { return static_cast<const char*>(data_); }
+    size_t size() const { return size_; }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace aws_wrapper
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "journal.h"
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+
+namespace aws_wrapper {
+
+// === 입력 위치 (exactly-once 재시작) ===
+// 저널 레코드에 남은 Kafka 위치로 엔진 상태가 어떤 메시지까지 반영했는지 파티션별로 따라간다.
+//  - OFFSET 표시: 그 파티션의 offset 미만 메시지는 모두 처리됐다
+//    (배치의 명령이 모든 샤드에서 처리된 뒤 기록한다)
+//  - 표시 이후 offset 의 명령 레코드: 다음 표시보다 먼저 저널에 들어간 메시지
+//    (다른 샤드가 아직 같은 배치를 처리하고 있을 때)
+// 재시작하면 파티션마다 표시된 offset 부터 다시 읽고, 그중 이미 저널에 있는 메시지는
+// 건너뛴다. apply 는 같은 레코드를 다시 적용해도 결과가 같으므로 스냅샷의 입력 위치에
+// 저널 전체를 겹쳐 적용해도 된다.
+class SourceOffsets {
+public:
+    void apply(const JournalRecord& record);
+    // 저널 파일의 모든 레코드를 적용. 적용한 레코드 수 반환
+    size_t applyJournal(const std::string& path);
+
+    // 파티션별로 다시 읽기 시작할 offset (표시가 없는 파티션은 빠진다)
+    std::map<int32_t, int64_t> resumeOffsets() const;
+    // 다시 읽기 시작한 offset 이후 이미 저널에 반영된 메시지인가
+    bool applied(int32_t partition, int64_t offset) const;
+    // 마지막으로 적용한 레코드의 sequence
+    uint64_t sequence() const { return sequence_; }
+    bool empty() const { return partitions_.empty(); }
+
+    // 스냅샷과 함께 남기는 JSON
+    std::string toJson() const;
+    bool fromJson(const std::string& data);
+    // 임시 파일에 쓰고 rename 한다
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+private:
+    struct Partition {
+        int64_t handled = -1;        // 이 offset 미만은 모두 처리됨 (-1 이면 모름)
+        std::set<int64_t> ahead;     // handled 이후 이미 저널에 있는 offset
+    };
+
+    std::map<int32_t, Partition> partitions_;
+    uint64_t sequence_ = 0;
+};
+
+// 스냅샷 디렉터리 안의 입력 위치 파일
+std::string sourceOffsetsPath(const std::string& snapshot_dir);
+// 입력 위치를 담는 Redis 키 (오더북 스냅샷 키 "snapshot:*" 와 겹치지 않는다)
+constexpr const char* SOURCE_OFFSETS_KEY = "source_offsets";
+
+} // namespace aws_wrapper
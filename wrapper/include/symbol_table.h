@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace aws_wrapper {
+
+// === 종목 인턴 테이블 ===
+// 종목 문자열을 처음 본 순서대로 0부터 촘촘한 id 로 바꾼다.
+// 엔진은 메시지마다 한 번만 해시로 id 를 찾고, 그 뒤로는 id 로 배열을 인덱싱한다.
+// id 는 종목이 제거돼도 재사용하지 않는다.
+class SymbolTable {
+public:
+    using Id = uint32_t;
+    static constexpr Id NONE = UINT32_MAX;
+
+    // 없으면 다음 id 를 부여
+    Id intern(const std::string& symbol) {
+        auto [it, inserted] = ids_.try_emplace(symbol, static_cast<Id>(names_.size()));
+        if (inserted) {
+            names_.push_back(symbol);
+        }
+        return it->second;
+    }
+
+    // 없으면 NONE
+    Id find(const std::string& symbol) const {
+        auto it = ids_.find(symbol);
+        return it == ids_.end() ? NONE : it->second;
+    }
+
+    const std::string& name(Id id) const { return names_[id]; }
+    size_t size() const { return names_.size(); }
+
+private:
+    std::unordered_map<std::string, Id> ids_;
+    std::vector<std::string> names_;
+};
+
+} // namespace aws_wrapper
@@ -0,0 +1,35 @@
+#include "alloc_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> g_heap_allocations{0};
+
+} // namespace
+
+namespace aws_wrapper {
+
+uint64_t heapAllocations() {
+    return g_heap_allocations.load(std::memory_order_relaxed);
+}
+
+} // namespace aws_wrapper
+
+// 배열, nothrow 버전은 기본 구현이 이 함수를 부르므로 함께 세어진다
+void* operator new(std::size_t size) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,95 @@
+#include "checkpointer.h"
+#include "logger.h"
+#include "redis_client.h"
+#include "snapshot_file.h"
+#include <chrono>
+
+namespace aws_wrapper {
+
+Checkpointer::Checkpointer(const std::string& journal_path,
+                           const std::string& snapshot_dir,
+                           RedisClient* redis)
+    : quiet_(nullptr, nullptr),
+      engine_(&quiet_),
+      journal_path_(journal_path),
+      snapshot_dir_(snapshot_dir),
+      redis_(redis) {
+}
+
+size_t Checkpointer::checkpoint() {
+    auto start = std::chrono::steady_clock::now();
+
+    // 저널은 엔진이 첫 명령을 기록할 때 생길 수 있다
+    if (!reader_) {
+        reader_ = std::make_unique<JournalReader>(journal_path_);
+        if (!reader_->isOpen()) {
+            reader_.reset();
+            return 0;
+        }
+    }
+    size_t applied = engine_.replayJournal(*reader_);
+    followOffsets(engine_.lastSequence());
+
+    size_t saved = 0;
+    for (const auto& symbol : engine_.getAllSymbols()) {
+        uint64_t sequence = engine_.bookSequence(symbol);
+        auto it = saved_sequences_.find(symbol);
+        if (it != saved_sequences_.end() && it->second == sequence) {
+            continue;  // 마지막 체크포인트 이후 바뀌지 않음
+        }
+        bool ok = true;
+        if (!snapshot_dir_.empty()) {
+            ok = engine_.saveBookSnapshot(symbol, snapshotFilePath(snapshot_dir_, symbol));
+        }
+        if (redis_) {
+            auto snapshot = engine_.snapshotOrderBook(symbol);
+            if (!snapshot.empty()) {
+                redis_->set("snapshot:" + symbol, snapshot);
+            }
+        }
+        if (ok) {
+            saved_sequences_[symbol] = sequence;
+            ++saved;
+        }
+    }
+
+    // 오더북을 모두 기록한 뒤에 입력 위치를 남긴다
+    if (applied > 0) {
+        if (!snapshot_dir_.empty()) {
+            offsets_.save(sourceOffsetsPath(snapshot_dir_));
+        }
+        if (redis_) {
+            redis_->set(SOURCE_OFFSETS_KEY, offsets_.toJson());
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    Logger::debug("Checkpoint: commands", applied, "orderbooks", saved,
+                  "sequence", engine_.lastSequence(), "ms", elapsed);
+    return saved;
+}
+
+void Checkpointer::followOffsets(uint64_t up_to) {
+    if (!offsets_reader_) {
+        offsets_reader_ = std::make_unique<JournalReader>(journal_path_);
+        if (!offsets_reader_->isOpen()) {
+            offsets_reader_.reset();
+            return;
+        }
+    }
+    if (has_pending_) {
+        if (pending_.sequence > up_to) return;
+        offsets_.apply(pending_);
+        has_pending_ = false;
+    }
+    while (offsets_reader_->next(pending_)) {
+        if (pending_.sequence > up_to) {
+            has_pending_ = true;
+            return;
+        }
+        offsets_.apply(pending_);
+    }
+}
+
+} // namespace aws_wrapper
@@ -1,85 +1,222 @@
 #include "engine_core.h"
+#include "binary_io.h"
+#include "order_pool.h"
+#include "snapshot_file.h"
 #include "logger.h"
+#include <book/book_snapshot.h>
+#include <algorithm>
+#include <cstring>
 #include <nlohmann/json.hpp>
 
 namespace aws_wrapper {
 
-EngineCore::EngineCore(MarketDataHandler* handler)
-    : handler_(handler) {
+namespace {
+
+// 저널이 담을 수 없는 명령 (id 는 너무 길 수 있어 길이만 남긴다)
+void rejectTooLarge(const EngineCore::Command& command) {
+    const bool add = command.op == JournalOp::ADD;
+    Logger::error("Command rejected - journal record too large:",
+                  add ? command.order->order_id().size() : command.order_id.size(),
+                  add ? command.order->user_id().size() : 0,
+                  add ? command.order->symbol().size() : command.symbol.size());
+}
+
+} // namespace
+
+EngineCore::EngineCore(MarketDataHandler* handler, size_t book_capacity)
+    : book_capacity_(book_capacity),
+      handler_(handler), order_listener_(handler), depth_listener_(handler) {
     Logger::info("EngineCore initialized");
 }
 
+EngineCore::BookState& EngineCore::stateFor(const std::string& symbol) {
+    SymbolTable::Id id = symbols_.intern(symbol);
+    if (id >= books_.size()) {
+        books_.resize(id + 1);
+    }
+    return books_[id];
+}
+
+EngineCore::BookState* EngineCore::findBook(const std::string& symbol) {
+    SymbolTable::Id id = symbols_.find(symbol);
+    if (id == SymbolTable::NONE || !books_[id].book) return nullptr;
+    return &books_[id];
+}
+
+const EngineCore::BookState* EngineCore::findBook(const std::string& symbol) const {
+    SymbolTable::Id id = symbols_.find(symbol);
+    if (id == SymbolTable::NONE || !books_[id].book) return nullptr;
+    return &books_[id];
+}
+
 OrderPtr EngineCore::findOrder(const std::string& symbol, 
                                 const std::string& order_id) {
-    auto sym_it = order_maps_.find(symbol);
-    if (sym_it == order_maps_.end()) return nullptr;
+    BookState* state = findBook(symbol);
+    if (!state) return nullptr;
     
-    auto ord_it = sym_it->second.find(order_id);
-    if (ord_it == sym_it->second.end()) return nullptr;
-    
-    return ord_it->second;
+    const OrderPtr* order = state->book->orders().find(order_id);
+    return order ? *order : nullptr;
 }
 
-EngineCore::OrderBookPtr EngineCore::getOrCreateBook(const std::string& symbol) {
-    auto it = books_.find(symbol);
-    if (it != books_.end()) {
-        return it->second;
+EngineCore::BookState& EngineCore::getOrCreateBook(const std::string& symbol) {
+    BookState& state = stateFor(symbol);
+    if (state.book) {
+        return state;
     }
     
     auto book = std::make_shared<OrderBook>();
     book->set_symbol(symbol);
     
     // 리스너 등록
-    book->set_order_listener(handler_);
+    attachListeners(*book);
+    book->orders().reserve(book_capacity_);
+    
+    state.book = book;
+    
+    Logger::info("Created OrderBook for symbol:", symbol);
+    return state;
+}
+
+void EngineCore::attachListeners(OrderBook& book) {
+    book.set_order_listener(order_listener_);
     // TradeListener는 OrderBook 타입이 달라서 직접 캐스트
     // DepthOrderBook은 OrderBook에서 상속받지만 템플릿 타입이 다름
     // 대신 on_trade 콜백은 MarketDataHandler에서 직접 처리
-    book->set_depth_listener(handler_);
-    book->set_bbo_listener(handler_);
+    book.set_depth_listener(depth_listener_);
+    book.set_bbo_listener(depth_listener_);
+}
+
+bool EngineCore::journal(JournalRecord& record) {
+    // 저널이 다시 읽지 못할 레코드는 쓰지 않고 명령도 적용하지 않는다
+    // (저널이 없을 때도 같게 해서 저널 유무로 결과가 달라지지 않게)
+    if (!journalRecordFits(record)) {
+        Logger::error("Command rejected - journal record too large:",
+                      record.order_id.size(), record.user_id.size(), record.symbol.size());
+        return false;
+    }
+    if (journal_) {
+        journal_->append(record);
+    } else {
+        record.sequence = sequence_ + 1;
+    }
+    sequence_ = record.sequence;
+    stateFor(record.symbol).sequence = record.sequence;
+    return true;
+}
+
+void EngineCore::applyAdd(const OrderPtr& order) {
+    BookState& state = getOrCreateBook(order->symbol());
     
-    books_[symbol] = book;
-    order_maps_[symbol] = {};
+    // 주문 인덱스에 저장 (오더북을 떠나면 오더북 콜백에서 빠진다)
+    state.book->orders().insert(order);
     
-    Logger::info("Created OrderBook for symbol:", symbol);
-    return book;
+    // Liquibook에 추가
+    state.book->add(order);
+    state.book->perform_callbacks();
+    
+    ++total_orders_processed_;
 }
 
-bool EngineCore::addOrder(OrderPtr order) {
-    std::lock_guard<std::mutex> lock(mutex_);
+bool EngineCore::applyCancel(const std::string& symbol, 
+                              const std::string& order_id) {
+    BookState* state = findBook(symbol);
+    if (!state) return false;
+    const OrderPtr* found = state->book->orders().find(order_id);
+    if (!found) return false;
+    OrderPtr order = *found;
     
-    auto book = getOrCreateBook(order->symbol());
+    state->book->cancel(order);
+    state->book->perform_callbacks();
     
-    // 주문 맵에 저장
-    order_maps_[order->symbol()][order->order_id()] = order;
+    // 취소는 on_cancel 에서 인덱스에서 빠진다. 거부된 경우에도 남기지 않는다
+    state->book->orders().erase(order);
+    return true;
+}
+
+bool EngineCore::applyReplace(const std::string& symbol, 
+                               const std::string& order_id,
+                               int64_t qty_delta, 
+                               liquibook::book::Price new_price) {
+    BookState* state = findBook(symbol);
+    if (!state) return false;
+    const OrderPtr* found = state->book->orders().find(order_id);
+    if (!found) return false;
+    OrderPtr order = *found;
     
-    // Liquibook에 추가
-    book->add(order);
-    book->perform_callbacks();
+    state->book->replace(order, qty_delta, new_price);
+    state->book->perform_callbacks();
+    return true;
+}
+
+JournalRecord EngineCore::addRecord(const Order& order, SourcePosition source) {
+    JournalRecord record;
+    record.op = JournalOp::ADD;
+    record.symbol = order.symbol();
+    record.order_id = order.order_id();
+    record.user_id = order.user_id();
+    record.is_buy = order.is_buy();
+    record.price = order.price();
+    record.quantity = order.order_qty();
+    record.stop_price = order.stop_price();
+    record.conditions = order.conditions();
+    record.timestamp = order.timestamp();
+    record.source = source;
+    return record;
+}
+
+JournalRecord EngineCore::cancelRecord(const std::string& symbol,
+                                       const std::string& order_id,
+                                       SourcePosition source) {
+    JournalRecord record;
+    record.op = JournalOp::CANCEL;
+    record.symbol = symbol;
+    record.order_id = order_id;
+    record.source = source;
+    return record;
+}
+
+JournalRecord EngineCore::replaceRecord(const std::string& symbol,
+                                        const std::string& order_id,
+                                        int64_t qty_delta,
+                                        liquibook::book::Price new_price,
+                                        SourcePosition source) {
+    JournalRecord record;
+    record.op = JournalOp::REPLACE;
+    record.symbol = symbol;
+    record.order_id = order_id;
+    record.qty_delta = qty_delta;
+    record.new_price = new_price;
+    record.source = source;
+    return record;
+}
+
+bool EngineCore::addOrder(OrderPtr order, SourcePosition source) {
+    std::lock_guard<std::mutex> lock(mutex_);
     
-    ++total_orders_processed_;
+    // 매칭 전에 저널 기록
+    JournalRecord record = addRecord(*order, source);
+    if (!journal(record)) return false;
+    
+    applyAdd(order);
     
     Logger::info("Order added:", order->order_id(), order->symbol());
     return true;
 }
 
 bool EngineCore::cancelOrder(const std::string& symbol, 
-                              const std::string& order_id) {
+                              const std::string& order_id,
+                              SourcePosition source) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto order = findOrder(symbol, order_id);
-    if (!order) {
+    if (!findOrder(symbol, order_id)) {
         Logger::warn("Cancel failed - order not found:", order_id);
         return false;
     }
     
-    auto it = books_.find(symbol);
-    if (it == books_.end()) return false;
+    JournalRecord record = cancelRecord(symbol, order_id, source);
+    if (!journal(record)) return false;
     
-    it->second->cancel(order);
-    it->second->perform_callbacks();
-    
-    // 주문 맵에서 제거
-    order_maps_[symbol].erase(order_id);
+    applyCancel(symbol, order_id);
     
     Logger::info("Order cancelled:", order_id);
     return true;
@@ -88,44 +225,282 @@ bool EngineCore::cancelOrder(const std::string& symbol,
 bool EngineCore::replaceOrder(const std::string& symbol, 
                                const std::string& order_id,
                                int64_t qty_delta, 
-                               liquibook::book::Price new_price) {
+                               liquibook::book::Price new_price,
+                               SourcePosition source) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto order = findOrder(symbol, order_id);
-    if (!order) {
+    if (!findOrder(symbol, order_id)) {
         Logger::warn("Replace failed - order not found:", order_id);
         return false;
     }
     
-    auto it = books_.find(symbol);
-    if (it == books_.end()) return false;
+    JournalRecord record = replaceRecord(symbol, order_id, qty_delta, new_price, source);
+    if (!journal(record)) return false;
     
-    it->second->replace(order, qty_delta, new_price);
-    it->second->perform_callbacks();
+    applyReplace(symbol, order_id, qty_delta, new_price);
     
     Logger::info("Order replaced:", order_id, "delta:", qty_delta, "price:", new_price);
     return true;
 }
 
+size_t EngineCore::applyBatch(std::vector<Command>& commands) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    // 종목 id 순으로 안정 정렬해 종목 안의 순서를 지킨다.
+    // 신규 주문의 오더북은 여기서 만들어 두어 아래에서는 books_ 가 커지지 않는다
+    batch_order_.clear();
+    for (size_t i = 0; i < commands.size(); ++i) {
+        const Command& command = commands[i];
+        SymbolTable::Id id;
+        if (command.op == JournalOp::ADD) {
+            getOrCreateBook(command.order->symbol());
+            id = symbols_.find(command.order->symbol());
+        } else {
+            id = symbols_.find(command.symbol);
+        }
+        batch_order_.emplace_back(id, i);
+    }
+    std::stable_sort(batch_order_.begin(), batch_order_.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+    
+    // 1) 종목마다 오더북 명령을 만들고 저널 레코드를 묶음에 모은다
+    batch_groups_.clear();
+    batch_commands_.clear();
+    batch_journal_.clear();
+    for (size_t begin = 0; begin < batch_order_.size();) {
+        const SymbolTable::Id id = batch_order_[begin].first;
+        size_t end = begin;
+        while (end < batch_order_.size() && batch_order_[end].first == id) {
+            ++end;
+        }
+        
+        OrderBook* book = id == SymbolTable::NONE ? nullptr : books_[id].book.get();
+        BatchGroup group{id, batch_commands_.size(), 0, batch_journal_.size()};
+        for (size_t i = begin; i < end; ++i) {
+            Command& command = commands[batch_order_[i].second];
+            if (command.op == JournalOp::ADD) {
+                // 인덱스에는 적용 전에 넣는다
+                // (같은 묶음의 뒤 명령이 찾을 수 있고, 체결되면 콜백에서 빠진다)
+                if (!batch_journal_.add(addRecord(*command.order, command.source))) {
+                    rejectTooLarge(command);
+                    continue;
+                }
+                book->orders().insert(command.order);
+                batch_commands_.push_back(
+                    OrderBook::TypedCommand::add(command.order));
+                ++total_orders_processed_;
+                Logger::info("Order added:", command.order->order_id(),
+                             command.order->symbol());
+                continue;
+            }
+            
+            const OrderPtr* found = book ? book->orders().find(command.order_id) : nullptr;
+            if (command.op == JournalOp::CANCEL) {
+                if (!found) {
+                    Logger::warn("Cancel failed - order not found:", command.order_id);
+                    continue;
+                }
+                if (!batch_journal_.add(cancelRecord(command.symbol, command.order_id,
+                                                     command.source))) {
+                    rejectTooLarge(command);
+                    continue;
+                }
+                batch_commands_.push_back(OrderBook::TypedCommand::cancel(*found));
+                Logger::info("Order cancelled:", command.order_id);
+            } else if (command.op == JournalOp::REPLACE) {
+                if (!found) {
+                    Logger::warn("Replace failed - order not found:", command.order_id);
+                    continue;
+                }
+                if (!batch_journal_.add(replaceRecord(command.symbol, command.order_id,
+                                                      command.qty_delta, command.new_price,
+                                                      command.source))) {
+                    rejectTooLarge(command);
+                    continue;
+                }
+                batch_commands_.push_back(OrderBook::TypedCommand::replace(
+                    *found, command.qty_delta, command.new_price));
+                Logger::info("Order replaced:", command.order_id,
+                             "delta:", command.qty_delta, "price:", command.new_price);
+            }
+        }
+        group.end = batch_commands_.size();
+        if (group.end > group.begin) {
+            group.last_record = batch_journal_.size() - 1;
+            batch_groups_.push_back(group);
+        }
+        begin = end;
+    }
+    if (batch_commands_.empty()) return 0;
+    
+    // 2) 매칭 전에 묶음 전체를 저널에 한 번에 기록 (sequence 는 묶음 안에서 연속)
+    uint64_t first_sequence = sequence_ + 1;
+    if (journal_) {
+        journal_->append(batch_journal_);
+        first_sequence = batch_journal_.sequence(0);
+    }
+    sequence_ = first_sequence + batch_journal_.size() - 1;
+    
+    // 3) 종목마다 apply_batch 로 적용 (depth / BBO 는 종목마다 한 번 발행)
+    size_t applied = 0;
+    for (const BatchGroup& group : batch_groups_) {
+        BookState& state = books_[group.id];
+        state.sequence = first_sequence + group.last_record;
+        const OrderBook::TypedCommand* first = batch_commands_.data() + group.begin;
+        const size_t count = group.end - group.begin;
+        try {
+            state.book->apply_batch(first, count);
+            applied += count;
+        } catch (const std::exception& e) {
+            Logger::error("Error processing command batch:", state.book->symbol(),
+                          e.what());
+        }
+        // 취소는 on_cancel 에서 인덱스에서 빠진다. 거부된 경우에도 남기지 않는다
+        for (size_t i = 0; i < count; ++i) {
+            if (first[i].type == OrderBook::TypedCommand::cmd_cancel) {
+                state.book->orders().erase(first[i].order);
+            }
+        }
+    }
+    return applied;
+}
+
+void EngineCore::setJournal(JournalWriter* journal) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    journal_ = journal;
+    if (journal_ && journal_->lastSequence() > sequence_) {
+        sequence_ = journal_->lastSequence();
+    }
+}
+
+uint64_t EngineCore::lastSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sequence_;
+}
+
+size_t EngineCore::replayJournal(const std::string& path,
+                                 const std::string& symbol,
+                                 uint64_t up_to) {
+    JournalReader reader(path);
+    if (!reader.isOpen()) {
+        Logger::info("No journal to replay:", path);
+        return 0;
+    }
+    
+    size_t applied = replayJournal(reader, symbol, up_to);
+    Logger::info("Journal replayed:", path, "commands:", applied,
+                 "last sequence:", lastSequence());
+    return applied;
+}
+
+size_t EngineCore::replayJournal(JournalReader& reader,
+                                 const std::string& symbol,
+                                 uint64_t up_to) {
+    if (symbol.empty()) {
+        return replayJournal(reader, SymbolFilter(), up_to);
+    }
+    return replayJournal(reader,
+        [&symbol](const std::string& s) { return s == symbol; }, up_to);
+}
+
+size_t EngineCore::replayJournal(JournalReader& reader,
+                                 const SymbolFilter& filter,
+                                 uint64_t up_to) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    // 재생 중 체결은 이미 발행된 것이므로 주문 상태만 갱신하고 발행하지 않는다
+    // depth는 재생이 끝난 뒤 다음 변경 때 발행된다
+    MarketDataHandler quiet(nullptr, nullptr);
+    order_listener_ = &quiet;
+    depth_listener_ = nullptr;
+    for (auto& state : books_) {
+        if (state.book) attachListeners(*state.book);
+    }
+    
+    size_t applied = 0;
+    JournalRecord record;
+    try {
+        while (reader.next(record)) {
+            if (record.sequence > up_to) break;
+            if (record.sequence > sequence_) {
+                sequence_ = record.sequence;
+            }
+            // 입력 위치 표시는 오더북과 상관없다
+            if (record.op == JournalOp::OFFSET) continue;
+            if (filter && !filter(record.symbol)) continue;
+        
+            // 스냅샷에 이미 반영된 명령은 건너뛴다
+            // (applyAdd 가 인턴하는 종목은 이미 인턴돼 있으므로 참조는 유효하다)
+            uint64_t& book_sequence = stateFor(record.symbol).sequence;
+            if (record.sequence <= book_sequence) continue;
+            book_sequence = record.sequence;
+        
+            switch (record.op) {
+                case JournalOp::ADD: {
+                    auto order = OrderPool::instance().acquire();
+                    order->setOrderId(record.order_id);
+                    order->setUserId(record.user_id);
+                    order->setSymbol(record.symbol);
+                    order->setIsBuy(record.is_buy);
+                    order->setPrice(record.price);
+                    order->setOrderQty(record.quantity);
+                    order->setStopPrice(record.stop_price);
+                    order->setConditions(record.conditions);
+                    order->setTimestamp(record.timestamp);
+                    applyAdd(order);
+                    break;
+                }
+                case JournalOp::CANCEL:
+                    applyCancel(record.symbol, record.order_id);
+                    break;
+                case JournalOp::REPLACE:
+                    applyReplace(record.symbol, record.order_id,
+                                 record.qty_delta, record.new_price);
+                    break;
+                case JournalOp::OFFSET:
+                    break;
+            }
+            ++applied;
+        }
+    } catch (const std::exception& e) {
+        Logger::error("Journal replay stopped at sequence", record.sequence, ":", e.what());
+    }
+    
+    order_listener_ = handler_;
+    depth_listener_ = handler_;
+    for (auto& state : books_) {
+        if (state.book) attachListeners(*state.book);
+    }
+    return applied;
+}
+
+uint64_t EngineCore::bookSequence(const std::string& symbol) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SymbolTable::Id id = symbols_.find(symbol);
+    return id == SymbolTable::NONE ? 0 : books_[id].sequence;
+}
+
 std::string EngineCore::snapshotOrderBook(const std::string& symbol) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = order_maps_.find(symbol);
-    if (it == order_maps_.end()) {
+    const BookState* state = findBook(symbol);
+    if (!state) {
         return "";
     }
     
     nlohmann::json snapshot;
     snapshot["symbol"] = symbol;
+    // 이 스냅샷에 반영된 마지막 저널 sequence
+    snapshot["sequence"] = state->sequence;
     snapshot["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::system_clock::now().time_since_epoch()).count();
     
     nlohmann::json orders = nlohmann::json::array();
-    for (const auto& [id, order] : it->second) {
+    state->book->orders().forEach([&orders](const OrderPtr& order) {
         if (order->open_qty() > 0) {
             orders.push_back(order->toJson());
         }
-    }
+    });
     snapshot["orders"] = orders;
     
     Logger::info("Snapshot created for:", symbol, "orders:", orders.size());
@@ -139,17 +514,20 @@ bool EngineCore::restoreOrderBook(const std::string& symbol,
     try {
         auto snapshot = nlohmann::json::parse(data);
         
-        // 기존 오더북 제거
-        books_.erase(symbol);
-        order_maps_.erase(symbol);
+        // 기존 오더북을 새 오더북으로 교체 (리스너 없이)
+        BookState& state = stateFor(symbol);
+        uint64_t snapshot_sequence = snapshot.value("sequence", uint64_t(0));
+        state.sequence = snapshot_sequence;
+        if (snapshot_sequence > sequence_) {
+            sequence_ = snapshot_sequence;
+        }
         
-        // 새 오더북 생성 (리스너 없이)
         auto book = std::make_shared<OrderBook>();
         book->set_symbol(symbol);
-        books_[symbol] = book;
-        order_maps_[symbol] = {};
+        state.book = book;
         
         const auto& orders = snapshot["orders"];
+        book->orders().reserve(std::max(orders.size(), book_capacity_));
         size_t total = orders.size();
         size_t count = 0;
         
@@ -160,7 +538,7 @@ bool EngineCore::restoreOrderBook(const std::string& symbol,
         // 주문 복원 (리스너 없이 조용히)
         for (const auto& j : orders) {
             auto order = Order::fromJson(j);
-            order_maps_[symbol][order->order_id()] = order;
+            book->orders().insert(order);
             book->add(order);
             
             // 프로그레스 업데이트 (10% 단위)
@@ -184,9 +562,7 @@ bool EngineCore::restoreOrderBook(const std::string& symbol,
         std::cout << "] " << total << "/" << total << " ✓" << std::endl;
         
         // 리스너 등록 (복원 완료 후)
-        book->set_order_listener(handler_);
-        book->set_depth_listener(handler_);
-        book->set_bbo_listener(handler_);
+        attachListeners(*book);
         
         Logger::info("OrderBook restored:", symbol, "orders:", total);
         return true;
@@ -196,11 +572,139 @@ bool EngineCore::restoreOrderBook(const std::string& symbol,
     }
 }
 
+bool EngineCore::saveBookSnapshot(const std::string& symbol,
+                                  const std::string& path) {
+    if (path.empty() || !isValidSymbol(symbol)) {
+        Logger::error("Refusing binary snapshot for unsafe symbol or path:", symbol);
+        return false;
+    }
+    
+    SnapshotFileHeader header{};
+    std::vector<uint64_t> image;
+    std::string table;
+    bool encoded = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        const BookState* state = findBook(symbol);
+        if (!state) {
+            return false;
+        }
+        
+        // order_ref 는 주문 테이블에 기록한 순서
+        uint32_t count = 0;
+        binary_io::putString(table, symbol);
+        liquibook::book::write_book_snapshot(*state->book,
+            [&](const OrderPtr& order) {
+                encoded = encodeSnapshotOrder(*order, table) && encoded;
+                return uint64_t(count++);
+            }, image);
+        header.order_count = count;
+        header.sequence = state->sequence;
+    }
+    
+    // 읽을 수 없는 테이블은 쓰지 않는다 (이전 스냅샷 파일을 그대로 둔다)
+    if (!encoded) {
+        Logger::error("Binary snapshot not written, order string too long:", symbol);
+        return false;
+    }
+    
+    if (!writeSnapshotFile(path, header, image, table)) {
+        return false;
+    }
+    Logger::info("Binary snapshot saved:", symbol, "orders:", header.order_count,
+                 "bytes:", sizeof(header) + header.image_size + header.table_size);
+    return true;
+}
+
+std::string EngineCore::loadBookSnapshot(const std::string& path) {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        Logger::error("Failed to map snapshot file:", path);
+        return "";
+    }
+    
+    try {
+        SnapshotFileHeader header;
+        if (file.size() < sizeof(header)) {
+            throw std::runtime_error("snapshot file is truncated");
+        }
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, SNAPSHOT_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != SNAPSHOT_FILE_VERSION) {
+            throw std::runtime_error("not a snapshot file of this version");
+        }
+        const uint64_t body = file.size() - sizeof(header);
+        if (header.image_size > body || header.table_size > body - header.image_size) {
+            throw std::runtime_error("snapshot file is truncated");
+        }
+        const char* image = file.data() + sizeof(header);
+        const char* table = image + header.image_size;
+        const char* end = table + header.table_size;
+        if (binary_io::crc32(table, header.table_size,
+                binary_io::crc32(image, header.image_size)) != header.crc) {
+            throw std::runtime_error("snapshot file CRC mismatch");
+        }
+        
+        // 매핑된 이미지를 복사하지 않고 그대로 읽는다
+        liquibook::book::BookSnapshotView view(image, header.image_size);
+        
+        std::string symbol;
+        if (!binary_io::getString(table, end, symbol) || symbol.empty()) {
+            throw std::runtime_error("snapshot file has no symbol");
+        }
+        std::vector<OrderPtr> orders;
+        orders.reserve(header.order_count);
+        for (uint32_t i = 0; i < header.order_count; ++i) {
+            auto order = decodeSnapshotOrder(table, end, symbol);
+            if (!order) {
+                throw std::runtime_error("snapshot order table is truncated");
+            }
+            orders.push_back(std::move(order));
+        }
+        
+        // 락 밖에서 새 오더북을 만들고 (리스너 없이) 교체만 락 안에서 한다
+        auto book = std::make_shared<OrderBook>();
+        book->set_symbol(symbol);
+        liquibook::book::restore_book_snapshot(*book, view,
+            [&orders](const liquibook::book::BookSnapshotOrder& saved)
+                -> const OrderPtr& {
+                if (saved.order_ref >= orders.size()) {
+                    throw std::runtime_error("snapshot order reference out of range");
+                }
+                return orders[saved.order_ref];
+            });
+        book->orders().reserve(std::max(orders.size(), book_capacity_));
+        for (const auto& order : orders) {
+            book->orders().insert(order);
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        attachListeners(*book);
+        BookState& state = stateFor(symbol);
+        state.book = book;
+        state.sequence = header.sequence;
+        if (header.sequence > sequence_) {
+            sequence_ = header.sequence;
+        }
+        
+        Logger::info("Binary snapshot restored:", symbol, "orders:", orders.size(),
+                     "sequence:", header.sequence);
+        return symbol;
+    } catch (const std::exception& e) {
+        Logger::error("Failed to load snapshot file:", path, e.what());
+        return "";
+    }
+}
+
 bool EngineCore::removeOrderBook(const std::string& symbol) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    books_.erase(symbol);
-    order_maps_.erase(symbol);
+    SymbolTable::Id id = symbols_.find(symbol);
+    if (id != SymbolTable::NONE) {
+        // 종목 id 는 그대로 두고 상태만 비운다
+        books_[id] = BookState();
+    }
     
     Logger::info("OrderBook removed:", symbol);
     return true;
@@ -208,23 +712,36 @@ bool EngineCore::removeOrderBook(const std::string& symbol) {
 
 size_t EngineCore::getSymbolCount() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return books_.size();
+    size_t count = 0;
+    for (const auto& state : books_) {
+        if (state.book) ++count;
+    }
+    return count;
 }
 
 size_t EngineCore::getOrderCount(const std::string& symbol) const {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = order_maps_.find(symbol);
-    if (it == order_maps_.end()) return 0;
-    return it->second.size();
+    const BookState* state = findBook(symbol);
+    return state ? state->book->orders().size() : 0;
+}
+
+size_t EngineCore::getActiveOrderCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& state : books_) {
+        if (state.book) count += state.book->orders().size();
+    }
+    return count;
 }
 
 std::vector<std::string> EngineCore::getAllSymbols() const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<std::string> symbols;
-    symbols.reserve(books_.size());
-    for (const auto& [sym, book] : books_) {
-        symbols.push_back(sym);
+    for (SymbolTable::Id id = 0; id < books_.size(); ++id) {
+        if (books_[id].book) {
+            symbols.push_back(symbols_.name(id));
+        }
     }
     return symbols;
 }
@@ -0,0 +1,369 @@
+// 입력 / 저장 형식 일관성 검사
+// 빠른 경로와 바이너리 형식이 기존 경로와 같은 결과를 내는지 확인한다.
+//   order json:     decodeOrderJson 이 받은 메시지는 nlohmann 경로 (json::parse +
+//                   Order::fromJson) 와 같은 주문이 되고, 바이너리로 인코딩해 다시
+//                   읽어도 같아야 한다. 빠른 경로가 받지 않는 메시지는 nlohmann 경로로
+//                   넘어가므로 비교하지 않는다. 손으로 쓴 경우 + 무작위로 변형한 메시지.
+//                   너무 긴 문자열, 파일 이름으로 쓸 수 없는 종목은 두 경로 모두 거부.
+//   journal:        JournalWriter::append (레코드 / JournalBatch) 로 쓴 레코드를
+//                   JournalReader 로 같은 값, 연속된 sequence 로 읽는다. 읽을 수 없는
+//                   레코드는 쓰지 않고, 다시 열어도 잘리는 레코드가 없다.
+//   source offsets: 같은 레코드를 apply 한 결과와 저널 파일을 applyJournal 한 결과,
+//                   toJson / fromJson 을 거친 결과가 같다.
+//
+// 사용법: format_check [cases=200000] [dir=임시 디렉터리]
+//   다른 결과가 하나라도 있으면 1 을 반환한다 (처음 몇 개는 출력).
+
+#include "order_json.h"
+#include "order_wire.h"
+#include "journal.h"
+#include "source_offsets.h"
+#include "logger.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aws_wrapper;
+
+namespace {
+
+size_t g_failures = 0;
+
+void fail(const char* check, const std::string& detail) {
+    if (++g_failures <= 10) {
+        std::printf("MISMATCH %s: %.200s\n", check, detail.c_str());
+    }
+}
+
+// === order json ===
+
+// consumer 가 빠른 경로를 쓰기 전에 하던 디코딩
+bool decodeGeneric(const std::string& value, OrderMessage& message) {
+    try {
+        auto j = nlohmann::json::parse(value);
+        message.order = Order::fromJson(j);
+        std::string action = j.value("action", "ADD");
+        if (action == "ADD") {
+            message.action = JournalOp::ADD;
+        } else if (action == "CANCEL") {
+            message.action = JournalOp::CANCEL;
+        } else if (action == "REPLACE") {
+            message.action = JournalOp::REPLACE;
+            message.qty_delta = j.value("qty_delta", 0);
+            message.new_price = j.value("new_price", 0);
+        } else {
+            return false;
+        }
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool sameMessage(const OrderMessage& a, const OrderMessage& b, bool with_timestamp) {
+    auto ja = a.order->toJson();
+    auto jb = b.order->toJson();
+    if (!with_timestamp) {
+        // 메시지에 없으면 디코딩한 시각이 들어간다
+        ja.erase("timestamp");
+        jb.erase("timestamp");
+    }
+    return ja == jb && a.action == b.action && a.qty_delta == b.qty_delta &&
+           a.new_price == b.new_price;
+}
+
+struct JsonCounts {
+    size_t total = 0;
+    size_t fast = 0;
+};
+
+void checkOrderJson(const std::string& value, JsonCounts& counts) {
+    ++counts.total;
+    OrderMessage fast;
+    if (!decodeOrderJson(value, fast)) return;
+    ++counts.fast;
+
+    OrderMessage generic;
+    bool with_timestamp = value.find("\"timestamp\"") != std::string::npos;
+    if (!decodeGeneric(value, generic) || !sameMessage(fast, generic, with_timestamp)) {
+        fail("fast vs nlohmann", value);
+        return;
+    }
+    try {
+        // 바이너리 형식은 timestamp 0 을 수신 시각으로 읽는다
+        bool binary_timestamp = fast.order->timestamp() != 0;
+        if (!sameMessage(fast, decodeOrderMessage(encodeOrderMessage(fast)), binary_timestamp)) {
+            fail("binary round trip", value);
+        }
+    } catch (const std::exception& e) {
+        fail("binary round trip", value + " " + e.what());
+    }
+}
+
+// 어느 경로로도 받으면 안 되는 메시지
+void checkOrderRejected(const std::string& value) {
+    OrderMessage message;
+    if (decodeOrderJson(value, message) || decodeGeneric(value, message)) {
+        fail("accepted", value);
+        return;
+    }
+    try {
+        decodeOrderMessage(value);
+        fail("decodeOrderMessage accepted", value);
+    } catch (const std::exception&) {
+    }
+}
+
+std::string orderWith(const std::string& key, const std::string& value) {
+    nlohmann::json j = {{"action", "ADD"}, {"order_id", "o1"}, {"user_id", "u1"},
+                        {"symbol", "SYM1"}, {"price", 100}, {"quantity", 5}};
+    j[key] = value;
+    return j.dump();
+}
+
+void checkOrderJson(size_t cases) {
+    const std::vector<std::string> seeds = {
+        R"({"action":"ADD","order_id":"a1","user_id":"u","symbol":"S","is_buy":false,"price":10,"quantity":5,"timestamp":7})",
+        R"( { "action" : "CANCEL" , "order_id" : "a1" , "symbol" : "S" } )",
+        R"({"action":"REPLACE","order_id":"a1","symbol":"S","qty_delta":-3,"new_price":11})",
+    };
+    std::vector<std::string> messages = seeds;
+    const std::vector<std::string> shapes = {
+        R"({"side":"SELL","symbol":"S","price":1})", R"({"side":"buy","symbol":"S"})",
+        R"({"side":"Buy","symbol":"S"})", R"({"is_buy":false,"side":"BUY","symbol":"S"})",
+        R"({"is_buy":1,"symbol":"S"})", R"({"price":1.5,"symbol":"S"})", R"({"price":1e3,"symbol":"S"})",
+        R"({"price":-1,"symbol":"S"})", R"({"price":2147483648,"symbol":"S"})",
+        R"({"price":2147483647,"symbol":"S"})", R"({"price":012,"symbol":"S"})",
+        R"({"price":-0,"symbol":"S"})", R"({"price":null,"symbol":"S"})",
+        R"({"order_type":null,"x":[1],"symbol":"S"})",
+        R"({"order_type":"LIMIT","x":true,"y":-5,"z":"q","symbol":"S"})",
+        R"({"symbol":"S\"x"})", "{\"symbol\":\"\xc3\xa9\"}", "{\"symbol\":\"a\tb\"}",
+        R"({"conditions":{"all_or_none":true},"symbol":"S"})", R"({"action":"FOO","symbol":"S"})",
+        R"({"action":"ADD","symbol":"S"} x)", R"({"action":"ADD","symbol":"S",})", R"({})", R"([])",
+        R"({"symbol":"A","symbol":"B"})",
+        R"({"qty_delta":-2147483648,"action":"REPLACE","symbol":"S"})",
+        R"({"qty_delta":-2147483649,"action":"REPLACE","symbol":"S"})",
+        R"({"timestamp":-5,"symbol":"S"})", R"({"timestamp":123456789012345678,"symbol":"S"})",
+        R"({"new_price":-1,"action":"REPLACE","symbol":"S"})", "\n{\"symbol\":\"S\"}\n",
+        R"({"symbol":"S")", R"({"symbol" "S"})", R"({"price":})", R"({"is_buy":truex})", "",
+        orderWith("order_id", std::string(MAX_ORDER_FIELD_LENGTH, 'a')),
+        orderWith("symbol", "BTC-USD_1.x"),
+    };
+    messages.insert(messages.end(), shapes.begin(), shapes.end());
+
+    JsonCounts counts;
+    for (const auto& message : messages) {
+        checkOrderJson(message, counts);
+    }
+    std::mt19937_64 rng(9);
+    const char alphabet[] = "{}[]\":,. -+0123456789eEtrufalsn\\x/\t\xc3\xa9";
+    for (size_t i = 0; i < cases; ++i) {
+        std::string value = seeds[rng() % seeds.size()];
+        int mutations = 1 + rng() % 3;
+        for (int k = 0; k < mutations; ++k) {
+            size_t pos = rng() % (value.size() + 1);
+            char c = alphabet[rng() % (sizeof(alphabet) - 1)];
+            switch (rng() % 3) {
+                case 0: if (pos < value.size()) value[pos] = c; break;
+                case 1: value.insert(value.begin() + pos, c); break;
+                default: if (pos < value.size()) value.erase(pos, 1); break;
+            }
+        }
+        checkOrderJson(value, counts);
+    }
+
+    const std::string too_long(MAX_ORDER_FIELD_LENGTH + 1, 'a');
+    const std::vector<std::string> rejected = {
+        orderWith("order_id", too_long), orderWith("user_id", too_long),
+        orderWith("symbol", too_long), orderWith("symbol", "../../x"),
+        orderWith("symbol", "a/b"), orderWith("symbol", ".hidden"), orderWith("symbol", ""),
+        R"({"action":"ADD","order_id":"o1","price":1,"quantity":1})",
+    };
+    for (const auto& message : rejected) {
+        checkOrderRejected(message);
+    }
+    std::printf("order json: %zu messages, fast path %zu, rejected %zu\n",
+                counts.total, counts.fast, rejected.size());
+}
+
+// === journal ===
+
+bool sameRecord(const JournalRecord& a, const JournalRecord& b) {
+    return a.sequence == b.sequence && a.op == b.op && a.symbol == b.symbol &&
+           a.order_id == b.order_id && a.user_id == b.user_id && a.is_buy == b.is_buy &&
+           a.price == b.price && a.quantity == b.quantity &&
+           a.stop_price == b.stop_price && a.conditions == b.conditions &&
+           a.timestamp == b.timestamp && a.qty_delta == b.qty_delta &&
+           a.new_price == b.new_price && a.source.partition == b.source.partition &&
+           a.source.offset == b.source.offset;
+}
+
+std::string randomString(std::mt19937_64& rng, size_t size) {
+    std::string value(size, '\0');
+    for (auto& c : value) c = static_cast<char>(rng());
+    return value;
+}
+
+JournalRecord randomRecord(std::mt19937_64& rng) {
+    JournalRecord record;
+    record.op = static_cast<JournalOp>(1 + rng() % 4);
+    record.symbol = randomString(rng, rng() % 16);
+    record.order_id = randomString(rng, rng() % 40);
+    record.user_id = randomString(rng, rng() % 300);
+    record.is_buy = (rng() & 1) != 0;
+    record.price = rng();
+    record.quantity = rng();
+    record.stop_price = rng();
+    record.conditions = static_cast<liquibook::book::OrderConditions>(rng());
+    record.timestamp = static_cast<int64_t>(rng());
+    record.qty_delta = static_cast<int64_t>(rng());
+    record.new_price = rng();
+    if (rng() % 4 != 0) {
+        record.source.partition = static_cast<int32_t>(rng() % 8);
+        record.source.offset = static_cast<int64_t>(rng() % 100000);
+    }
+    return record;
+}
+
+// 쓴 레코드 (sequence 포함) 를 돌려준다
+std::vector<JournalRecord> writeJournal(const std::string& path, size_t count) {
+    std::mt19937_64 rng(17);
+    std::vector<JournalRecord> written;
+    JournalWriter writer(path);
+    JournalBatch batch;
+    std::vector<JournalRecord> batched;
+    for (size_t i = 0; i < count; ++i) {
+        JournalRecord record = randomRecord(rng);
+        // 큰 레코드는 가끔만 (쓰지 않은 레코드마다 오류 로그가 남는다)
+        switch (i % 250) {
+            case 10: record.user_id.assign(60000, 'u'); break;   // 64KB 안
+            case 20: record.user_id.assign(UINT16_MAX, 'u'); break;  // payload 가 넘친다
+            case 30: record.order_id.assign(UINT16_MAX + 1, 'o'); break;  // u16 을 넘는다
+            default: break;
+        }
+        bool fits = journalRecordFits(record);
+        if (rng() % 2 == 0) {
+            if (writer.append(record) != fits) {
+                fail("journal append", "record of " + std::to_string(record.user_id.size()) +
+                     "/" + std::to_string(record.order_id.size()) + " bytes");
+            }
+            if (fits) written.push_back(record);
+            continue;
+        }
+        if (batch.add(record) != fits) {
+            fail("journal batch add", "record of " + std::to_string(record.user_id.size()) +
+                 "/" + std::to_string(record.order_id.size()) + " bytes");
+        }
+        if (fits) batched.push_back(record);
+        if (batch.size() >= 1 + rng() % 32) {
+            writer.append(batch);
+            for (size_t k = 0; k < batched.size(); ++k) {
+                batched[k].sequence = batch.sequence(k);
+                written.push_back(batched[k]);
+            }
+            batch.clear();
+            batched.clear();
+        }
+    }
+    writer.append(batch);
+    for (size_t k = 0; k < batched.size(); ++k) {
+        batched[k].sequence = batch.sequence(k);
+        written.push_back(batched[k]);
+    }
+    return written;
+}
+
+void checkJournal(const std::string& path, const std::vector<JournalRecord>& written) {
+    JournalReader reader(path);
+    JournalRecord record;
+    size_t count = 0;
+    while (reader.next(record)) {
+        if (count >= written.size() || !sameRecord(record, written[count])) {
+            fail("journal read", "record " + std::to_string(count));
+            return;
+        }
+        if (count > 0 && record.sequence != written[count - 1].sequence + 1) {
+            fail("journal sequence", std::to_string(record.sequence));
+        }
+        ++count;
+    }
+    if (count != written.size()) {
+        fail("journal read", std::to_string(count) + " of " +
+             std::to_string(written.size()) + " records");
+    }
+
+    // 다시 열면 잘린 tail 만 잘라낸다 (온전한 레코드는 그대로)
+    uint64_t size = std::filesystem::file_size(path);
+    {
+        JournalWriter reopened(path);
+        if (!written.empty() && reopened.lastSequence() != written.back().sequence) {
+            fail("journal reopen", "last sequence " + std::to_string(reopened.lastSequence()));
+        }
+    }
+    if (std::filesystem::file_size(path) != size) {
+        fail("journal reopen", "truncated to " +
+             std::to_string(std::filesystem::file_size(path)) + " bytes");
+    }
+    std::printf("journal: %zu records, %llu bytes\n", count,
+                static_cast<unsigned long long>(size));
+}
+
+// === source offsets ===
+
+void checkSourceOffsets(const std::string& path, const std::vector<JournalRecord>& written) {
+    SourceOffsets applied;
+    for (const auto& record : written) {
+        applied.apply(record);
+    }
+    SourceOffsets replayed;
+    if (replayed.applyJournal(path) != written.size() ||
+        replayed.toJson() != applied.toJson()) {
+        fail("source offsets applyJournal", replayed.toJson());
+    }
+    SourceOffsets loaded;
+    if (!loaded.fromJson(applied.toJson()) || loaded.toJson() != applied.toJson() ||
+        loaded.sequence() != applied.sequence() ||
+        loaded.resumeOffsets() != applied.resumeOffsets()) {
+        fail("source offsets json", applied.toJson());
+    }
+    for (int32_t partition = 0; partition < 8; ++partition) {
+        for (int64_t offset = 0; offset < 100000; offset += 7) {
+            if (loaded.applied(partition, offset) != applied.applied(partition, offset)) {
+                fail("source offsets applied", std::to_string(partition) + ":" +
+                     std::to_string(offset));
+            }
+        }
+    }
+    std::printf("source offsets: %zu partitions resume, sequence %llu\n",
+                applied.resumeOffsets().size(),
+                static_cast<unsigned long long>(applied.sequence()));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Logger::setLevel(LogLevel::ERROR);
+    const long cases = argc > 1 ? std::atol(argv[1]) : 200000;
+    const std::filesystem::path dir = argc > 2 ? std::filesystem::path(argv[2]) :
+                                                 std::filesystem::temp_directory_path();
+    if (cases < 0) {
+        std::fprintf(stderr, "usage: %s [cases] [dir]\n", argv[0]);
+        return 2;
+    }
+
+    checkOrderJson(static_cast<size_t>(cases));
+
+    const std::string path = (dir / "format_check.journal").string();
+    std::remove(path.c_str());
+    auto written = writeJournal(path, 2000);
+    checkJournal(path, written);
+    checkSourceOffsets(path, written);
+    std::remove(path.c_str());
+
+    std::printf("%zu mismatches\n", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -4,7 +4,7 @@
 
 namespace aws_wrapper {
 
-GrpcServiceImpl::GrpcServiceImpl(EngineCore* engine, RedisClient* redis)
+GrpcServiceImpl::GrpcServiceImpl(ShardedEngine* engine, RedisClient* redis)
     : engine_(engine)
     , redis_(redis)
     , start_time_(std::chrono::steady_clock::now()) {
@@ -91,7 +91,7 @@ grpc::Status GrpcServiceImpl::HealthCheck(grpc::ServerContext* context,
 }
 
 // GrpcService implementation
-GrpcService::GrpcService(EngineCore* engine, RedisClient* redis)
+GrpcService::GrpcService(ShardedEngine* engine, RedisClient* redis)
     : service_(std::make_unique<GrpcServiceImpl>(engine, redis)) {
 }
 
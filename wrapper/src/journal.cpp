@@ -0,0 +1,270 @@
+#include "journal.h"
+#include "binary_io.h"
+#include "logger.h"
+#include <cstring>
+#include <unistd.h>
+
+namespace aws_wrapper {
+
+namespace {
+
+constexpr size_t HEADER_SIZE = 8;          // u32 길이 + u32 CRC
+constexpr uint32_t MAX_PAYLOAD = 64 * 1024;
+// 문자열 바이트를 뺀 payload 크기 (고정 필드 + 문자열 길이 u16 세 개)
+constexpr size_t FIXED_PAYLOAD = 8 + 1 + 1 + 4 + 8 * 6 + 2 * 3 + 4 + 8;
+
+using namespace binary_io;
+
+bool encode(const JournalRecord& r, std::string& out) {
+    put<uint64_t>(out, r.sequence);
+    put<uint8_t>(out, static_cast<uint8_t>(r.op));
+    put<uint8_t>(out, r.is_buy ? 1 : 0);
+    put<uint32_t>(out, r.conditions);
+    put<uint64_t>(out, r.price);
+    put<uint64_t>(out, r.quantity);
+    put<uint64_t>(out, r.stop_price);
+    put<int64_t>(out, r.timestamp);
+    put<int64_t>(out, r.qty_delta);
+    put<uint64_t>(out, r.new_price);
+    if (!putString(out, r.symbol) ||
+        !putString(out, r.order_id) ||
+        !putString(out, r.user_id)) {
+        return false;
+    }
+    put<int32_t>(out, r.source.partition);
+    put<int64_t>(out, r.source.offset);
+    return true;
+}
+
+bool decode(const std::string& payload, JournalRecord& r) {
+    const char* p = payload.data();
+    const char* end = p + payload.size();
+    uint8_t op = 0;
+    uint8_t is_buy = 0;
+    uint32_t conditions = 0;
+    uint64_t price = 0, quantity = 0, stop_price = 0, new_price = 0;
+    bool ok = get(p, end, r.sequence) &&
+              get(p, end, op) &&
+              get(p, end, is_buy) &&
+              get(p, end, conditions) &&
+              get(p, end, price) &&
+              get(p, end, quantity) &&
+              get(p, end, stop_price) &&
+              get(p, end, r.timestamp) &&
+              get(p, end, r.qty_delta) &&
+              get(p, end, new_price) &&
+              getString(p, end, r.symbol) &&
+              getString(p, end, r.order_id) &&
+              getString(p, end, r.user_id);
+    if (!ok || op < 1 || op > 4) return false;
+    r.source = SourcePosition();
+    if (p < end && !(get(p, end, r.source.partition) && get(p, end, r.source.offset))) {
+        return false;
+    }
+    r.op = static_cast<JournalOp>(op);
+    r.is_buy = is_buy != 0;
+    r.conditions = conditions;
+    r.price = price;
+    r.quantity = quantity;
+    r.stop_price = stop_price;
+    r.new_price = new_price;
+    return true;
+}
+
+// 헤더 자리를 비워 두고 레코드를 out 끝에 붙인다.
+// 읽을 때 거부될 레코드면 (문자열이 u16 을 넘거나 payload 가 MAX_PAYLOAD 를 넘으면)
+// 아무것도 붙이지 않고 false
+bool encodeRecord(const JournalRecord& record, std::string& out) {
+    if (!journalRecordFits(record)) return false;
+    size_t start = out.size();
+    out.append(HEADER_SIZE, '\0');
+    if (!encode(record, out)) {
+        out.resize(start);
+        return false;
+    }
+    uint32_t size = static_cast<uint32_t>(out.size() - start - HEADER_SIZE);
+    std::memcpy(&out[start], &size, 4);
+    return true;
+}
+
+// sequence 를 채우고 CRC 를 계산해 헤더를 완성한다
+void sealRecord(char* record, uint64_t sequence) {
+    uint32_t size = 0;
+    std::memcpy(&size, record, 4);
+    std::memcpy(record + HEADER_SIZE, &sequence, 8);
+    uint32_t crc = crc32(record + HEADER_SIZE, size);
+    std::memcpy(record + 4, &crc, 4);
+}
+
+} // namespace
+
+bool journalRecordFits(const JournalRecord& record) {
+    const size_t strings = record.symbol.size() + record.order_id.size() +
+                           record.user_id.size();
+    return record.symbol.size() <= UINT16_MAX &&
+           record.order_id.size() <= UINT16_MAX &&
+           record.user_id.size() <= UINT16_MAX &&
+           FIXED_PAYLOAD + strings <= MAX_PAYLOAD;
+}
+
+// === JournalBatch ===
+
+bool JournalBatch::add(const JournalRecord& record) {
+    size_t offset = buffer_.size();
+    if (!encodeRecord(record, buffer_)) return false;
+    offsets_.push_back(offset);
+    return true;
+}
+
+void JournalBatch::clear() {
+    buffer_.clear();
+    offsets_.clear();
+    first_sequence_ = 0;
+}
+
+// === JournalReader ===
+
+JournalReader::JournalReader(const std::string& path)
+    : file_(std::fopen(path.c_str(), "rb")) {
+    payload_.reserve(256);
+}
+
+JournalReader::~JournalReader() {
+    if (file_) std::fclose(file_);
+}
+
+bool JournalReader::next(JournalRecord& record) {
+    if (!file_) return false;
+    if (read(record)) {
+        return true;
+    }
+    // 다음 호출 때 같은 위치에서 다시 읽는다 (그 사이 writer가 끝을 채울 수 있다)
+    std::clearerr(file_);
+    std::fseek(file_, static_cast<long>(valid_bytes_), SEEK_SET);
+    return false;
+}
+
+bool JournalReader::read(JournalRecord& record) {
+    char header[HEADER_SIZE];
+    if (std::fread(header, 1, HEADER_SIZE, file_) != HEADER_SIZE) return false;
+    uint32_t size = 0;
+    uint32_t crc = 0;
+    std::memcpy(&size, header, 4);
+    std::memcpy(&crc, header + 4, 4);
+    if (size == 0 || size > MAX_PAYLOAD) return false;
+
+    payload_.resize(size);
+    if (std::fread(&payload_[0], 1, size, file_) != size) return false;
+    if (crc32(payload_.data(), size) != crc) return false;
+    if (!decode(payload_, record)) return false;
+
+    valid_bytes_ += HEADER_SIZE + size;
+    return true;
+}
+
+// === JournalWriter ===
+
+JournalWriter::JournalWriter(const std::string& path, bool sync_each)
+    : sync_each_(sync_each) {
+    // 기존 저널의 마지막 sequence와 온전한 끝 위치 확인
+    uint64_t valid_bytes = 0;
+    {
+        JournalReader reader(path);
+        JournalRecord record;
+        while (reader.next(record)) {
+            last_sequence_ = record.sequence;
+        }
+        valid_bytes = reader.validBytes();
+    }
+
+    file_ = std::fopen(path.c_str(), "ab");
+    if (!file_) {
+        Logger::error("Failed to open journal:", path);
+        return;
+    }
+    // 크래시로 쓰다 만 레코드는 잘라낸다
+    std::fseek(file_, 0, SEEK_END);
+    if (static_cast<uint64_t>(std::ftell(file_)) > valid_bytes) {
+        Logger::warn("Truncating torn journal tail:", path, "at", valid_bytes);
+        if (::ftruncate(::fileno(file_), static_cast<off_t>(valid_bytes)) != 0) {
+            Logger::error("Failed to truncate journal:", path);
+        }
+    }
+    buffer_.reserve(256);
+    Logger::info("Journal opened:", path, "last sequence:", last_sequence_);
+}
+
+JournalWriter::~JournalWriter() {
+    if (file_) {
+        sync();
+        std::fclose(file_);
+    }
+}
+
+bool JournalWriter::append(JournalRecord& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer_.clear();
+    if (!encodeRecord(record, buffer_)) {
+        Logger::error("Journal record too large, not written:", record.order_id.size(),
+                      record.user_id.size(), record.symbol.size());
+        return false;
+    }
+    record.sequence = ++last_sequence_;
+    if (!file_) return false;
+    sealRecord(&buffer_[0], record.sequence);
+
+    if (std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size() ||
+        std::fflush(file_) != 0) {
+        Logger::error("Journal write failed at sequence", record.sequence);
+        return false;
+    }
+    if (sync_each_) {
+        ::fdatasync(::fileno(file_));
+    }
+    return true;
+}
+
+bool JournalWriter::append(JournalBatch& batch) {
+    if (batch.empty()) return true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch.first_sequence_ = last_sequence_ + 1;
+    last_sequence_ += batch.size();
+    if (!file_) return false;
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        sealRecord(&batch.buffer_[batch.offsets_[i]], batch.sequence(i));
+    }
+    if (std::fwrite(batch.buffer_.data(), 1, batch.buffer_.size(), file_) !=
+            batch.buffer_.size() ||
+        std::fflush(file_) != 0) {
+        Logger::error("Journal write failed at sequence", batch.first_sequence_);
+        return false;
+    }
+    if (sync_each_) {
+        ::fdatasync(::fileno(file_));
+    }
+    return true;
+}
+
+uint64_t JournalWriter::lastSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_sequence_;
+}
+
+void JournalWriter::advanceTo(uint64_t sequence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sequence > last_sequence_) {
+        Logger::info("Journal sequence advanced from", last_sequence_, "to", sequence);
+        last_sequence_ = sequence;
+    }
+}
+
+void JournalWriter::sync() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+        std::fflush(file_);
+        ::fdatasync(::fileno(file_));
+    }
+}
+
+} // namespace aws_wrapper
@@ -2,13 +2,29 @@
 #include "logger.h"
 #include "config.h"
 #include "msk_iam_auth.h"
+#include <algorithm>
+#include <chrono>
 
 namespace aws_wrapper {
 
+std::string_view MessageBatch::key(size_t index) const {
+    const auto& msg = messages_[index];
+    return msg->key_pointer()
+        ? std::string_view(static_cast<const char*>(msg->key_pointer()), msg->key_len())
+        : std::string_view();
+}
+
+std::string_view MessageBatch::value(size_t index) const {
+    const auto& msg = messages_[index];
+    return std::string_view(static_cast<const char*>(msg->payload()), msg->len());
+}
+
 KafkaConsumer::KafkaConsumer(const std::string& brokers,
                               const std::string& topic,
-                              const std::string& group_id)
-    : topic_(topic) {
+                              const std::string& group_id,
+                              size_t batch_size)
+    : topic_(topic),
+      batch_size_(batch_size) {
     std::string errstr;
     
     auto conf = std::unique_ptr<RdKafka::Conf>(
@@ -17,7 +33,15 @@ KafkaConsumer::KafkaConsumer(const std::string& brokers,
     conf->set("bootstrap.servers", brokers, errstr);
     conf->set("group.id", group_id, errstr);
     conf->set("auto.offset.reset", "earliest", errstr);
-    conf->set("enable.auto.commit", "true", errstr);
+    // 배치 모드는 오더북에 반영된 배치까지만 직접 커밋한다
+    conf->set("enable.auto.commit", batch_size_ > 0 ? "false" : "true", errstr);
+    if (batch_size_ > 0) {
+        // 리밸런스 때 옮겨 가는 파티션만 멈추고 나머지 파티션은 계속 받는다
+        conf->set("partition.assignment.strategy", "cooperative-sticky", errstr);
+        if (conf->set("rebalance_cb", &rebalancer_, errstr) != RdKafka::Conf::CONF_OK) {
+            Logger::error("Failed to set rebalance callback:", errstr);
+        }
+    }
     
     // MSK IAM 인증 설정 (포트 9098 사용 시)
     std::string aws_region = Config::get("AWS_REGION", "ap-northeast-2");
@@ -38,7 +62,8 @@ KafkaConsumer::KafkaConsumer(const std::string& brokers,
         throw std::runtime_error("Kafka consumer creation failed: " + errstr);
     }
     
-    Logger::info("KafkaConsumer created, brokers:", brokers, "group:", group_id);
+    Logger::info("KafkaConsumer created, brokers:", brokers, "group:", group_id,
+                 "batch:", batch_size_);
 }
 
 KafkaConsumer::~KafkaConsumer() {
@@ -57,7 +82,11 @@ void KafkaConsumer::start() {
     }
     
     running_ = true;
-    worker_ = std::thread(&KafkaConsumer::consumeLoop, this);
+    if (batch_size_ > 0 && batch_callback_) {
+        worker_ = std::thread(&KafkaConsumer::pollLoop, this);
+    } else {
+        worker_ = std::thread(&KafkaConsumer::consumeLoop, this);
+    }
     
     Logger::info("KafkaConsumer started, topic:", topic_);
 }
@@ -70,6 +99,17 @@ void KafkaConsumer::stop() {
         worker_.join();
     }
     
+    // 배치 모드: 파티션 스레드를 멈추고, 넘긴 배치가 반영된 만큼 커밋한 뒤 닫는다
+    if (!workers_.empty()) {
+        for (auto& [partition, worker] : workers_) {
+            worker->thread.join();
+        }
+        waitApplied(-1);
+        commitApplied(true);
+        workers_.clear();
+    }
+    
+    // close() 가 부르는 마지막 리밸런스 콜백에는 멈출 파티션 스레드가 없다
     consumer_->close();
     Logger::info("KafkaConsumer stopped");
 }
@@ -111,4 +151,223 @@ void KafkaConsumer::consumeLoop() {
     }
 }
 
+void KafkaConsumer::pollLoop() {
+    // 메시지는 파티션 큐에서 파티션 스레드가 읽는다. 여기서는 리밸런스 콜백과
+    // 오류 이벤트를 처리하고, 반영된 offset 을 커밋한다.
+    while (running_) {
+        commitApplied(false);
+        
+        std::unique_ptr<RdKafka::Message> msg(consumer_->consume(100));
+        if (!msg) continue;
+        
+        RdKafka::ErrorCode err = msg->err();
+        if (err == RdKafka::ERR_NO_ERROR) {
+            // 파티션 큐를 떼기 전에 들어온 메시지. 그 파티션의 배치로 처리한다
+            int32_t partition = msg->partition();
+            auto batch = std::make_unique<MessageBatch>();
+            batch->messages_.push_back(std::move(msg));
+            dispatch(partition, std::move(batch));
+        } else if (err != RdKafka::ERR__TIMED_OUT && err != RdKafka::ERR__PARTITION_EOF) {
+            Logger::error("Consume error:", msg->errstr());
+        }
+    }
+}
+
+void KafkaConsumer::partitionLoop(PartitionWorker* worker) {
+    while (running_ && worker->running) {
+        auto batch = pollBatch(*worker->queue);
+        if (batch->empty()) continue;
+        dispatch(worker->partition, std::move(batch));
+    }
+}
+
+void KafkaConsumer::rebalance(RdKafka::KafkaConsumer* consumer,
+                              RdKafka::ErrorCode err,
+                              std::vector<RdKafka::TopicPartition*>& partitions) {
+    bool cooperative = consumer->rebalance_protocol() == "COOPERATIVE";
+    
+    if (err == RdKafka::ERR__ASSIGN_PARTITIONS) {
+        // 파티션 큐를 먼저 떼어 두어야 첫 메시지부터 파티션 스레드가 받는다
+        for (auto* partition : partitions) {
+            auto start = start_offsets_.find(partition->partition());
+            if (start != start_offsets_.end()) {
+                Logger::info("Partition", start->first, "starts at offset", start->second);
+                partition->set_offset(start->second);
+                start_offsets_.erase(start);
+            }
+            startPartition(partition);
+        }
+        if (cooperative) {
+            if (RdKafka::Error* error = consumer->incremental_assign(partitions)) {
+                Logger::error("Partition assign failed:", error->str());
+                delete error;
+            }
+        } else {
+            consumer->assign(partitions);
+        }
+        Logger::info("Partitions assigned:", partitions.size(),
+                     "owned:", workers_.size());
+        return;
+    }
+    
+    if (err != RdKafka::ERR__REVOKE_PARTITIONS) {
+        Logger::error("Rebalance error:", RdKafka::err2str(err));
+    }
+    for (auto* partition : partitions) {
+        stopPartition(partition->partition());
+    }
+    if (cooperative) {
+        if (RdKafka::Error* error = consumer->incremental_unassign(partitions)) {
+            Logger::error("Partition unassign failed:", error->str());
+            delete error;
+        }
+    } else {
+        consumer->unassign();
+    }
+    Logger::info("Partitions revoked:", partitions.size(),
+                 "owned:", workers_.size());
+}
+
+void KafkaConsumer::startPartition(RdKafka::TopicPartition* partition) {
+    int32_t id = partition->partition();
+    if (workers_.count(id)) return;
+    
+    std::unique_ptr<RdKafka::Queue> queue(consumer_->get_partition_queue(partition));
+    if (!queue) {
+        Logger::error("No queue for partition:", id);
+        return;
+    }
+    queue->forward(nullptr);
+    
+    {
+        std::lock_guard<std::mutex> lock(commit_mutex_);
+        assigned_.insert(id);
+    }
+    auto worker = std::make_unique<PartitionWorker>();
+    worker->partition = id;
+    worker->queue = std::move(queue);
+    worker->thread = std::thread(&KafkaConsumer::partitionLoop, this, worker.get());
+    workers_[id] = std::move(worker);
+}
+
+void KafkaConsumer::stopPartition(int32_t partition) {
+    auto it = workers_.find(partition);
+    if (it == workers_.end()) return;
+    
+    it->second->running = false;
+    it->second->thread.join();
+    waitApplied(partition);
+    commitApplied(true);
+    {
+        // 늦게 반영된 배치가 새 소유자의 offset 을 덮어쓰지 않게 한다
+        std::lock_guard<std::mutex> lock(commit_mutex_);
+        assigned_.erase(partition);
+        applied_offsets_.erase(partition);
+        outstanding_.erase(partition);
+    }
+    workers_.erase(it);
+}
+
+std::unique_ptr<MessageBatch> KafkaConsumer::pollBatch(RdKafka::Queue& queue) {
+    auto batch = std::make_unique<MessageBatch>();
+    batch->messages_.reserve(batch_size_);
+    
+    // 첫 메시지만 기다리고, 나머지는 이미 받아 둔 것만 바로 가져온다
+    int timeout_ms = 100;
+    while (batch->messages_.size() < batch_size_) {
+        std::unique_ptr<RdKafka::Message> msg(queue.consume(timeout_ms));
+        if (!msg) break;
+        
+        RdKafka::ErrorCode err = msg->err();
+        if (err == RdKafka::ERR_NO_ERROR) {
+            batch->messages_.push_back(std::move(msg));
+            timeout_ms = 0;
+        } else if (err == RdKafka::ERR__PARTITION_EOF) {
+            continue;
+        } else {
+            if (err != RdKafka::ERR__TIMED_OUT) {
+                Logger::error("Consume error:", msg->errstr());
+            }
+            break;
+        }
+    }
+    return batch;
+}
+
+void KafkaConsumer::dispatch(int32_t partition, std::unique_ptr<MessageBatch> batch) {
+    // 파티션 안에서는 offset 순서대로 오므로 마지막 메시지가 최대
+    int64_t next = batch->messages_.back()->offset() + 1;
+    {
+        std::lock_guard<std::mutex> lock(commit_mutex_);
+        ++outstanding_[partition];
+    }
+    auto once = std::make_shared<std::atomic<bool>>(false);
+    auto applied = [this, partition, next, once] {
+        if (!once->exchange(true)) {
+            markApplied(partition, next);
+        }
+    };
+    
+    Logger::debug("Received batch, partition:", partition, "messages:", batch->size());
+    try {
+        batch_callback_(*batch, applied);
+    } catch (const std::exception& e) {
+        Logger::error("Batch callback error:", e.what());
+        applied();
+    }
+}
+
+void KafkaConsumer::markApplied(int32_t partition, int64_t offset) {
+    {
+        std::lock_guard<std::mutex> lock(commit_mutex_);
+        if (assigned_.count(partition)) {
+            int64_t& applied = applied_offsets_[partition];
+            applied = std::max(applied, offset);
+        }
+        auto it = outstanding_.find(partition);
+        if (it != outstanding_.end() && it->second > 0) {
+            --it->second;
+        }
+    }
+    commit_done_.notify_all();
+}
+
+bool KafkaConsumer::waitApplied(int32_t partition) {
+    std::unique_lock<std::mutex> lock(commit_mutex_);
+    auto pending = [this, partition] {
+        size_t count = 0;
+        for (const auto& [id, batches] : outstanding_) {
+            if (partition < 0 || id == partition) count += batches;
+        }
+        return count;
+    };
+    if (!commit_done_.wait_for(lock, std::chrono::seconds(10),
+                               [&pending] { return pending() == 0; })) {
+        Logger::warn("Batches not yet applied:", pending(), "partition:", partition);
+        return false;
+    }
+    return true;
+}
+
+void KafkaConsumer::commitApplied(bool sync) {
+    std::map<int32_t, int64_t> offsets;
+    {
+        std::lock_guard<std::mutex> lock(commit_mutex_);
+        offsets.swap(applied_offsets_);
+    }
+    if (offsets.empty()) return;
+    
+    std::vector<RdKafka::TopicPartition*> partitions;
+    partitions.reserve(offsets.size());
+    for (const auto& [partition, offset] : offsets) {
+        partitions.push_back(RdKafka::TopicPartition::create(topic_, partition, offset));
+    }
+    RdKafka::ErrorCode err = sync ? consumer_->commitSync(partitions)
+                                  : consumer_->commitAsync(partitions);
+    if (err != RdKafka::ERR_NO_ERROR) {
+        Logger::error("Offset commit failed:", RdKafka::err2str(err));
+    }
+    RdKafka::TopicPartition::destroy(partitions);
+}
+
 } // namespace aws_wrapper
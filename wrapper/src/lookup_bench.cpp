@@ -0,0 +1,158 @@
+// 주문 조회 마이크로벤치마크
+// 라이브 주문 N개를 두고 (종목, order_id) 로 주문을 찾는 비용을 비교한다.
+//   map:   std::map<symbol, std::map<order_id, OrderPtr>> (이전 EngineCore 구조)
+//   index: SymbolTable 로 종목 id → 종목별 OrderIndex (open addressing)
+//
+// 사용법: lookup_bench [orders=1000000] [symbols=64]
+
+#include "order.h"
+#include "order_index.h"
+#include "symbol_table.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aws_wrapper;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Key {
+    std::string symbol;
+    std::string order_id;
+};
+
+double nsPerOp(Clock::time_point start, size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+// 결과를 버리지 않도록 모아 두는 값
+size_t g_sink = 0;
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t order_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    const size_t symbol_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+    if (order_count == 0 || symbol_count == 0) {
+        std::fprintf(stderr, "usage: %s [orders] [symbols]\n", argv[0]);
+        return 2;
+    }
+
+    // Kafka 메시지와 같은 모양의 키 (심볼 + UUID 비슷한 order_id)
+    std::mt19937_64 rng(42);
+    std::vector<std::string> symbols;
+    for (size_t i = 0; i < symbol_count; ++i) {
+        symbols.push_back("SYM" + std::to_string(100000 + i));
+    }
+    std::vector<OrderPtr> orders;
+    orders.reserve(order_count);
+    for (size_t i = 0; i < order_count; ++i) {
+        auto order = std::make_shared<Order>();
+        char id[40];
+        std::snprintf(id, sizeof(id), "ord_%016llx_%08zu",
+                      static_cast<unsigned long long>(rng()), i);
+        order->setOrderId(id);
+        order->setSymbol(symbols[rng() % symbol_count]);
+        orders.push_back(order);
+    }
+    // 조회 순서는 무작위 (캐시에 유리하지 않게)
+    std::vector<Key> hits;
+    hits.reserve(order_count);
+    for (size_t i = 0; i < order_count; ++i) {
+        const auto& order = orders[rng() % order_count];
+        hits.push_back({order->symbol(), order->order_id()});
+    }
+    std::vector<Key> misses;
+    misses.reserve(order_count);
+    for (size_t i = 0; i < order_count; ++i) {
+        misses.push_back({symbols[rng() % symbol_count],
+                          "ord_missing_" + std::to_string(i)});
+    }
+
+    std::printf("orders %zu, symbols %zu\n", order_count, symbol_count);
+    std::printf("%-8s %12s %12s %12s %12s\n", "", "insert ns", "hit ns", "miss ns", "erase ns");
+
+    // === std::map 두 단계 ===
+    {
+        std::map<std::string, std::map<std::string, OrderPtr>> maps;
+        auto start = Clock::now();
+        for (const auto& order : orders) {
+            maps[order->symbol()][order->order_id()] = order;
+        }
+        double insert_ns = nsPerOp(start, order_count);
+
+        start = Clock::now();
+        for (const auto& key : hits) {
+            auto sym = maps.find(key.symbol);
+            auto it = sym->second.find(key.order_id);
+            g_sink += it != sym->second.end();
+        }
+        double hit_ns = nsPerOp(start, order_count);
+
+        start = Clock::now();
+        for (const auto& key : misses) {
+            auto sym = maps.find(key.symbol);
+            g_sink += sym->second.find(key.order_id) != sym->second.end();
+        }
+        double miss_ns = nsPerOp(start, order_count);
+
+        start = Clock::now();
+        for (const auto& order : orders) {
+            maps[order->symbol()].erase(order->order_id());
+        }
+        double erase_ns = nsPerOp(start, order_count);
+        std::printf("%-8s %12.1f %12.1f %12.1f %12.1f\n", "map",
+                    insert_ns, hit_ns, miss_ns, erase_ns);
+    }
+
+    // === 인턴한 종목 id + OrderIndex ===
+    {
+        SymbolTable table;
+        std::vector<OrderIndex> indexes;
+        // 엔진처럼 종목마다 예상 주문 수만큼 미리 잡는다
+        const size_t capacity = order_count / symbol_count * 2;
+        auto start = Clock::now();
+        for (const auto& order : orders) {
+            SymbolTable::Id id = table.intern(order->symbol());
+            if (id >= indexes.size()) {
+                indexes.resize(id + 1);
+                indexes[id].reserve(capacity);
+            }
+            indexes[id].insert(order);
+        }
+        double insert_ns = nsPerOp(start, order_count);
+
+        start = Clock::now();
+        for (const auto& key : hits) {
+            g_sink += indexes[table.find(key.symbol)].find(key.order_id) != nullptr;
+        }
+        double hit_ns = nsPerOp(start, order_count);
+
+        start = Clock::now();
+        for (const auto& key : misses) {
+            g_sink += indexes[table.find(key.symbol)].find(key.order_id) != nullptr;
+        }
+        double miss_ns = nsPerOp(start, order_count);
+
+        start = Clock::now();
+        for (const auto& order : orders) {
+            indexes[table.find(order->symbol())].erase(order->order_id());
+        }
+        double erase_ns = nsPerOp(start, order_count);
+        std::printf("%-8s %12.1f %12.1f %12.1f %12.1f\n", "index",
+                    insert_ns, hit_ns, miss_ns, erase_ns);
+    }
+
+    // 모두 찾았는지 (hit 는 order_count 번 성공해야 한다)
+    if (g_sink != 2 * order_count) {
+        std::fprintf(stderr, "unexpected lookup count %zu\n", g_sink);
+        return 1;
+    }
+    return 0;
+}
@@ -1,11 +1,23 @@
 #include "config.h"
 #include "logger.h"
-#include "engine_core.h"
+#include "sharded_engine.h"
 #include "market_data_handler.h"
 #include "grpc_service.h"
 #include "redis_client.h"
 #include "metrics.h"
+#include "alloc_counter.h"
+#include "order_pool.h"
+#include "order_wire.h"
+#include "journal.h"
+#include "snapshot_file.h"
+#include "checkpointer.h"
+#include "source_offsets.h"
+#include <algorithm>
+#include <filesystem>
+#include <functional>
 #include <iostream>
+#include <set>
+#include <string_view>
 #include <csignal>
 #include <nlohmann/json.hpp>
 
@@ -66,6 +78,8 @@ int main(int argc, char* argv[]) {
     const auto kafka_brokers = Config::get(Config::KAFKA_BROKERS, "localhost:9092");
     const auto kafka_topic = Config::get(Config::KAFKA_ORDER_TOPIC, "orders");
     const auto kafka_group = Config::get(Config::KAFKA_GROUP_ID, "matching-engine");
+    // poll 한 번에 받을 최대 메시지 수 (0 이면 메시지마다 처리, auto commit)
+    const auto kafka_batch_size = Config::getInt(Config::KAFKA_BATCH_SIZE, 256);
 #endif
     const auto grpc_port = Config::getInt(Config::GRPC_PORT, 50051);
     const auto redis_host = Config::get(Config::REDIS_HOST, "localhost");
@@ -73,6 +87,16 @@ int main(int argc, char* argv[]) {
     // Depth 캐시 (실시간 호가용 - 별도 인스턴스)
     const auto depth_cache_host = Config::get("DEPTH_CACHE_HOST", redis_host);
     const auto depth_cache_port = Config::getInt("DEPTH_CACHE_PORT", redis_port);
+    // 입력 명령 저널 (빈 값이면 저널 없이 실행)
+    const auto journal_path = Config::get(Config::JOURNAL_PATH, "orders.journal");
+    const auto journal_fsync = Config::getBool(Config::JOURNAL_FSYNC, false);
+    // 바이너리 스냅샷 디렉터리 (빈 값이면 Redis JSON 스냅샷만 사용)
+    const auto snapshot_dir = Config::get(Config::SNAPSHOT_DIR, "");
+    // 매칭 워커 스레드 수 (종목을 나눠 맡는다)
+    const auto engine_shards = Config::getInt(Config::ENGINE_SHARDS, 1);
+    // 오더북마다 미리 잡아 둘 주문 인덱스 크기
+    const auto book_capacity = Config::getInt(Config::ENGINE_BOOK_CAPACITY,
+                                              static_cast<int>(EngineCore::DEFAULT_BOOK_CAPACITY));
     
     Logger::info("=== Configuration ===");
 #ifdef USE_KINESIS
@@ -82,10 +106,15 @@ int main(int argc, char* argv[]) {
     Logger::info("Kafka Brokers:", kafka_brokers);
     Logger::info("Order Topic:", kafka_topic);
     Logger::info("Group ID:", kafka_group);
+    Logger::info("Batch Size:", kafka_batch_size);
 #endif
     Logger::info("gRPC Port:", grpc_port);
     Logger::info("Redis (snapshot):", redis_host, ":", redis_port);
     Logger::info("Redis (depth):", depth_cache_host, ":", depth_cache_port);
+    Logger::info("Journal:", journal_path.empty() ? "disabled" : journal_path,
+                 journal_fsync ? "(fsync)" : "");
+    Logger::info("Snapshot dir:", snapshot_dir.empty() ? "disabled" : snapshot_dir);
+    Logger::info("Engine shards:", engine_shards);
     Logger::info("=====================");
     
     try {
@@ -96,13 +125,6 @@ int main(int argc, char* argv[]) {
             Logger::warn("Redis (snapshot) connection failed - continuing without cache");
         }
         
-        // Depth 캐시 연결 (실시간 호가용)
-        RedisClient depth_cache(depth_cache_host, depth_cache_port);
-        bool depth_connected = depth_cache.connect();
-        if (!depth_connected) {
-            Logger::warn("Redis (depth) connection failed - continuing without depth cache");
-        }
-        
 #ifdef USE_KINESIS
         // Kinesis Producer 생성
         KinesisProducer producer(aws_region);
@@ -111,56 +133,170 @@ int main(int argc, char* argv[]) {
         KafkaProducer producer(kafka_brokers);
 #endif
         
-        // 핸들러 및 엔진 생성 (depth_cache를 전달)
-        MarketDataHandler handler(&producer, depth_connected ? &depth_cache : nullptr);
-        EngineCore engine(&handler);
-        
-        // === 시작 시 Redis에서 스냅샷 복원 ===
-        if (redis_connected) {
-            Logger::info("Restoring snapshots from Redis...");
-            auto snapshot_keys = redis.keys("snapshot:*");
-            for (const auto& key : snapshot_keys) {
-                std::string symbol = key.substr(9);  // "snapshot:" 제거
-                auto snapshot_data = redis.get(key);
-                if (snapshot_data.has_value()) {
-                    engine.restoreOrderBook(symbol, snapshot_data.value());
-                    Logger::info("Restored orderbook:", symbol);
+        // 엔진 생성 (샤드마다 핸들러와 depth 캐시 연결을 따로 만든다)
+        ShardedEngine engine(engine_shards > 0 ? engine_shards : 1, &producer,
+                             depth_cache_host, depth_cache_port, 65536,
+                             book_capacity > 0 ? book_capacity : 0);
+        
+        // === 시작 시 스냅샷 복원 ===
+        // 바이너리 스냅샷(mmap, 매칭 없이)을 먼저, 없는 종목은 Redis에서 복원
+        // (라이브 엔진과 체크포인트 섀도 엔진에 같은 스냅샷을 복원한다)
+        auto restoreSnapshots = [&](auto& target) {
+            std::set<std::string> restored;
+            if (!snapshot_dir.empty()) {
+                std::error_code ec;
+                std::filesystem::create_directories(snapshot_dir, ec);
+                for (const auto& entry : std::filesystem::directory_iterator(snapshot_dir, ec)) {
+                    if (entry.path().extension() != ".snap") continue;
+                    auto symbol = target.loadBookSnapshot(entry.path().string());
+                    if (!symbol.empty()) {
+                        restored.insert(symbol);
+                    }
+                }
+                Logger::info("Restored", restored.size(), "orderbooks from", snapshot_dir);
+            }
+            if (redis_connected) {
+                Logger::info("Restoring snapshots from Redis...");
+                auto snapshot_keys = redis.keys("snapshot:*");
+                for (const auto& key : snapshot_keys) {
+                    std::string symbol = key.substr(9);  // "snapshot:" 제거
+                    if (restored.count(symbol)) continue;
+                    auto snapshot_data = redis.get(key);
+                    if (snapshot_data.has_value()) {
+                        target.restoreOrderBook(symbol, snapshot_data.value());
+                        Logger::info("Restored orderbook:", symbol);
+                    }
+                }
+                Logger::info("Restored", snapshot_keys.size(), "orderbooks from Redis");
+            }
+        };
+        restoreSnapshots(engine);
+        
+        // === 엔진 상태가 반영한 Kafka 입력 위치 ===
+        // 스냅샷과 함께 기록한 위치에 저널 레코드의 위치를 겹쳐 적용한다. 저널이 없으면
+        // 스냅샷이 어느 메시지까지 반영했는지 모르므로 커밋된 offset 부터 읽는다.
+        SourceOffsets source_offsets;
+        if (!journal_path.empty()) {
+            if (!snapshot_dir.empty() && source_offsets.load(sourceOffsetsPath(snapshot_dir))) {
+                Logger::info("Source offsets restored from", snapshot_dir);
+            } else if (redis_connected) {
+                auto stored = redis.get(SOURCE_OFFSETS_KEY);
+                if (stored.has_value() && source_offsets.fromJson(stored.value())) {
+                    Logger::info("Source offsets restored from Redis");
                 }
             }
-            Logger::info("Restored", snapshot_keys.size(), "orderbooks from Redis");
+            source_offsets.applyJournal(journal_path);
+            for (const auto& [partition, offset] : source_offsets.resumeOffsets()) {
+                Logger::info("Partition", partition, "resumes at offset", offset);
+            }
+        }
+        
+        // === 스냅샷 이후 명령은 저널에서 재생 ===
+        std::unique_ptr<JournalWriter> journal;
+        if (!journal_path.empty()) {
+            engine.replayJournal(journal_path);
+            journal = std::make_unique<JournalWriter>(journal_path, journal_fsync);
+            if (journal->isOpen()) {
+                engine.setJournal(journal.get());
+            } else {
+                Logger::warn("Journal unavailable - continuing without journal");
+            }
+        }
+        
+        // === 스냅샷 저장 ===
+        // 저널이 있으면 저널을 따라가는 섀도 엔진에서 만들어 매칭을 멈추지 않는다
+        std::unique_ptr<Checkpointer> checkpointer;
+        if (journal && journal->isOpen() && (redis_connected || !snapshot_dir.empty())) {
+            checkpointer = std::make_unique<Checkpointer>(
+                journal_path, snapshot_dir, redis_connected ? &redis : nullptr);
+            restoreSnapshots(checkpointer->engine());
+            checkpointer->offsets() = source_offsets;
         }
+        auto saveSnapshots = [&]() -> size_t {
+            if (checkpointer) {
+                return checkpointer->checkpoint();
+            }
+            // 저널이 없으면 라이브 엔진에서 직접 (종목마다 그 샤드의 락을 잡는다)
+            auto symbols = engine.getAllSymbols();
+            for (const auto& symbol : symbols) {
+                if (!snapshot_dir.empty()) {
+                    engine.saveBookSnapshot(symbol, snapshotFilePath(snapshot_dir, symbol));
+                }
+                if (redis_connected) {
+                    auto snapshot = engine.snapshotOrderBook(symbol);
+                    if (!snapshot.empty()) {
+                        redis.set("snapshot:" + symbol, snapshot);
+                    }
+                }
+            }
+            return symbols.size();
+        };
         
 #ifdef USE_KINESIS
         // Kinesis Consumer 시작
         KinesisConsumer consumer(stream_name, aws_region);
 #else
         // Kafka Consumer 시작
-        KafkaConsumer consumer(kafka_brokers, kafka_topic, kafka_group);
+        KafkaConsumer consumer(kafka_brokers, kafka_topic, kafka_group,
+                               static_cast<size_t>(std::max(kafka_batch_size, 0)));
 #endif
-        consumer.setCallback([&engine](const std::string& key,
-                                        const std::string& value) {
+        // 종목의 샤드 큐에 넣기만 하고 매칭은 샤드 워커가 한다
+        engine.start();
+        auto handleMessage = [&engine](std::string_view value, SourcePosition source) {
             Metrics::instance().incrementOrdersReceived();
             
             try {
-                auto j = nlohmann::json::parse(value);
-                auto order = Order::fromJson(j);
-                
-                std::string action = j.value("action", "ADD");
+                // 첫 바이트로 바이너리 / JSON 을 고른다 (order_wire.h)
+                OrderMessage message = decodeOrderMessage(value);
+                const auto& order = message.order;
                 
-                if (action == "ADD") {
-                    engine.addOrder(order);
-                } else if (action == "CANCEL") {
-                    engine.cancelOrder(order->symbol(), order->order_id());
-                } else if (action == "REPLACE") {
-                    int64_t qty_delta = j.value("qty_delta", 0);
-                    uint64_t new_price = j.value("new_price", 0);
-                    engine.replaceOrder(order->symbol(), order->order_id(), 
-                                        qty_delta, new_price);
+                switch (message.action) {
+                    case JournalOp::ADD:
+                        engine.submitAdd(order, source);
+                        break;
+                    case JournalOp::CANCEL:
+                        engine.submitCancel(order->symbol(), order->order_id(), source);
+                        break;
+                    case JournalOp::REPLACE:
+                        engine.submitReplace(order->symbol(), order->order_id(),
+                                             message.qty_delta, message.new_price, source);
+                        break;
+                    case JournalOp::OFFSET:
+                        break;
                 }
             } catch (const std::exception& e) {
                 Logger::error("Error processing message:", e.what());
             }
+        };
+        consumer.setCallback([&handleMessage](const std::string& key,
+                                              const std::string& value) {
+            handleMessage(value, SourcePosition());
+        });
+#ifndef USE_KINESIS
+        // 배치 모드: 파티션마다 스레드가 받은 메시지 버퍼를 복사 없이 디코딩해 샤드 큐에
+        // 넣는다 (여러 파티션에서 동시에 불린다). 배치의 명령이 모든 샤드에서 처리된 뒤에
+        // 저널에 입력 위치를 표시하고 그 파티션의 offset 을 커밋한다.
+        consumer.setBatchCallback([&engine, &journal, &source_offsets, &handleMessage](
+                const MessageBatch& batch, std::function<void()> applied) {
+            for (size_t i = 0; i < batch.size(); ++i) {
+                SourcePosition source{batch.partition(i), batch.offset(i)};
+                // 재시작 전에 이미 저널에 들어간 메시지
+                if (source_offsets.applied(source.partition, source.offset)) continue;
+                handleMessage(batch.value(i), source);
+            }
+            SourcePosition handled{batch.partition(0), batch.offset(batch.size() - 1) + 1};
+            engine.submitBarrier([&journal, handled, applied = std::move(applied)] {
+                if (journal && journal->isOpen()) {
+                    JournalRecord mark;
+                    mark.op = JournalOp::OFFSET;
+                    mark.source = handled;
+                    journal->append(mark);
+                }
+                applied();
+            });
         });
+        consumer.setStartOffsets(source_offsets.resumeOffsets());
+#endif
         consumer.start();
         
         // gRPC 서버 시작
@@ -183,19 +319,13 @@ int main(int argc, char* argv[]) {
             auto now = std::chrono::steady_clock::now();
             
             // 10초마다 자동 스냅샷 저장
-            if (redis_connected && 
+            if ((redis_connected || !snapshot_dir.empty()) && 
                 std::chrono::duration_cast<std::chrono::seconds>(
                     now - last_snapshot).count() >= SNAPSHOT_INTERVAL_SECONDS) {
                 
-                auto symbols = engine.getAllSymbols();
-                for (const auto& symbol : symbols) {
-                    auto snapshot = engine.snapshotOrderBook(symbol);
-                    if (!snapshot.empty()) {
-                        redis.set("snapshot:" + symbol, snapshot);
-                    }
-                }
-                if (!symbols.empty()) {
-                    Logger::debug("Auto-saved", symbols.size(), "orderbook snapshots to Redis");
+                size_t saved = saveSnapshots();
+                if (saved > 0) {
+                    Logger::debug("Auto-saved", saved, "orderbook snapshots");
                 }
                 last_snapshot = now;
             }
@@ -204,29 +334,33 @@ int main(int argc, char* argv[]) {
             if (std::chrono::duration_cast<std::chrono::seconds>(
                     now - last_report).count() >= METRICS_INTERVAL_SECONDS) {
                 Metrics::instance().setSymbolCount(engine.getSymbolCount());
+                Metrics::instance().setActiveOrders(engine.getActiveOrderCount());
+                Metrics::instance().setQueuedCommands(engine.getQueuedCommands());
+                Metrics::instance().setHeapAllocations(heapAllocations());
+                Metrics::instance().setOrderAllocations(OrderPool::instance().allocated());
                 Logger::info("Metrics:", Metrics::instance().toJson());
                 last_report = now;
             }
         }
         
-        // === 종료 전 최종 스냅샷 저장 ===
-        if (redis_connected) {
-            Logger::info("Saving final snapshots before shutdown...");
-            auto symbols = engine.getAllSymbols();
-            for (const auto& symbol : symbols) {
-                auto snapshot = engine.snapshotOrderBook(symbol);
-                if (!snapshot.empty()) {
-                    redis.set("snapshot:" + symbol, snapshot);
-                }
-            }
-            Logger::info("Saved", symbols.size(), "snapshots");
-        }
-        
         // 정리
         Logger::info("Shutting down...");
         consumer.stop();
         grpc_service.stop();
+        // 큐에 남은 명령을 모두 처리하고 워커 정지
+        engine.stop();
+        
+        // === 종료 전 최종 스냅샷 저장 (입력을 멈춘 뒤) ===
+        if (redis_connected || !snapshot_dir.empty()) {
+            Logger::info("Saving final snapshots before shutdown...");
+            Logger::info("Saved", saveSnapshots(), "snapshots");
+        }
+        
         producer.flush(5000);
+        if (journal) {
+            engine.setJournal(nullptr);
+            journal->sync();
+        }
         
         Logger::info("=== Shutdown Complete ===");
         
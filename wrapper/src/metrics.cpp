@@ -36,6 +36,9 @@ std::string Metrics::toJson() const {
     j["fills_published"] = fills_published_.load();
     j["symbol_count"] = symbol_count_.load();
     j["active_orders"] = active_orders_.load();
+    j["queued_commands"] = queued_commands_.load();
+    j["heap_allocations"] = heap_allocations_.load();
+    j["order_allocations"] = order_allocations_.load();
     j["avg_order_latency_us"] = getAvgOrderLatencyUs();
     j["avg_match_latency_us"] = getAvgMatchLatencyUs();
     
@@ -1,15 +1,52 @@
 #include "order.h"
+#include "order_pool.h"
 #include "logger.h"
 #include <chrono>
+#include <stdexcept>
+#include <string>
 
 namespace aws_wrapper {
 
+namespace {
+
+// 임시 문자열을 만들지 않고 기존 버퍼에 복사 (풀에서 꺼낸 주문의 용량 재사용).
+// 문자열이 아니면 j.value() 처럼 type_error, 너무 길면 runtime_error
+void assignString(std::string& out, const nlohmann::json& j, const char* key) {
+    auto it = j.find(key);
+    if (it != j.end()) {
+        out.assign(it->get_ref<const std::string&>());
+    } else {
+        out.clear();
+    }
+    if (out.size() > MAX_ORDER_FIELD_LENGTH) {
+        throw std::runtime_error(std::string(key) + " longer than " +
+                                 std::to_string(MAX_ORDER_FIELD_LENGTH) + " bytes");
+    }
+}
+
+} // namespace
+
+bool isValidSymbol(std::string_view symbol) {
+    if (symbol.empty() || symbol.size() > MAX_ORDER_FIELD_LENGTH || symbol[0] == '.') {
+        return false;
+    }
+    for (char c : symbol) {
+        bool ok = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+                  (c >= '0' && c <= '9') || c == '.' || c == '_' || c == '-';
+        if (!ok) return false;
+    }
+    return true;
+}
+
 std::shared_ptr<Order> Order::fromJson(const nlohmann::json& j) {
-    auto order = std::make_shared<Order>();
+    auto order = OrderPool::instance().acquire();
     
-    order->order_id_ = j.value("order_id", "");
-    order->user_id_ = j.value("user_id", "");
-    order->symbol_ = j.value("symbol", "");
+    assignString(order->order_id_, j, "order_id");
+    assignString(order->user_id_, j, "user_id");
+    assignString(order->symbol_, j, "symbol");
+    if (!isValidSymbol(order->symbol_)) {
+        throw std::runtime_error("symbol must be [A-Za-z0-9._-] not starting with '.'");
+    }
     
     // is_buy (boolean) 또는 side (string) 둘 다 지원
     if (j.contains("is_buy")) {
@@ -63,6 +100,20 @@ nlohmann::json Order::toJson() const {
     return j;
 }
 
+void Order::reset() {
+    order_id_.clear();
+    user_id_.clear();
+    symbol_.clear();
+    is_buy_ = true;
+    price_ = 0;
+    order_qty_ = 0;
+    filled_qty_ = 0;
+    filled_cost_ = 0;
+    stop_price_ = 0;
+    conditions_ = 0;
+    timestamp_ = 0;
+}
+
 void Order::fill(liquibook::book::Quantity fill_qty,
                  liquibook::book::Cost fill_cost,
                  liquibook::book::FillId fill_id) {
@@ -0,0 +1,113 @@
+#include "order_index.h"
+#include <functional>
+#include <utility>
+
+namespace aws_wrapper {
+
+namespace {
+
+constexpr size_t MIN_SLOTS = 16;
+
+// 부하율 3/4 이하로 count 개를 담는 2의 거듭제곱 슬롯 수
+size_t slotsFor(size_t count) {
+    size_t slots = MIN_SLOTS;
+    while (slots * 3 < count * 4) {
+        slots *= 2;
+    }
+    return slots;
+}
+
+} // namespace
+
+size_t OrderIndex::hashOf(const std::string& order_id) {
+    return std::hash<std::string>{}(order_id);
+}
+
+size_t OrderIndex::probe(const std::string& order_id, size_t hash) const {
+    size_t i = hash & mask_;
+    while (slots_[i].order) {
+        if (slots_[i].hash == hash && slots_[i].order->order_id() == order_id) {
+            break;
+        }
+        i = (i + 1) & mask_;
+    }
+    return i;
+}
+
+void OrderIndex::reserve(size_t count) {
+    size_t slots = slotsFor(count);
+    if (slots > slots_.size()) {
+        rehash(slots);
+    }
+}
+
+void OrderIndex::rehash(size_t slot_count) {
+    std::vector<Slot> old(slot_count);
+    old.swap(slots_);
+    mask_ = slot_count - 1;
+    for (auto& slot : old) {
+        if (!slot.order) continue;
+        size_t i = slot.hash & mask_;
+        while (slots_[i].order) {
+            i = (i + 1) & mask_;
+        }
+        slots_[i] = std::move(slot);
+    }
+}
+
+const OrderPtr* OrderIndex::find(const std::string& order_id) const {
+    if (size_ == 0) return nullptr;
+    const Slot& slot = slots_[probe(order_id, hashOf(order_id))];
+    return slot.order ? &slot.order : nullptr;
+}
+
+void OrderIndex::insert(const OrderPtr& order) {
+    if ((size_ + 1) * 4 > slots_.size() * 3) {
+        rehash(slots_.empty() ? MIN_SLOTS : slots_.size() * 2);
+    }
+    size_t hash = hashOf(order->order_id());
+    Slot& slot = slots_[probe(order->order_id(), hash)];
+    if (!slot.order) {
+        ++size_;
+    }
+    slot.hash = hash;
+    slot.order = order;
+}
+
+bool OrderIndex::erase(const std::string& order_id) {
+    if (size_ == 0) return false;
+    size_t hole = probe(order_id, hashOf(order_id));
+    if (!slots_[hole].order) return false;
+    eraseAt(hole);
+    return true;
+}
+
+bool OrderIndex::erase(const OrderPtr& order) {
+    if (size_ == 0) return false;
+    size_t hole = probe(order->order_id(), hashOf(order->order_id()));
+    if (slots_[hole].order != order) return false;
+    eraseAt(hole);
+    return true;
+}
+
+void OrderIndex::eraseAt(size_t hole) {
+    // 뒤따르는 항목 중 hole 자리로 옮겨도 탐색이 끊기지 않는 것을 당겨 온다
+    for (size_t i = (hole + 1) & mask_; slots_[i].order; i = (i + 1) & mask_) {
+        size_t home = slots_[i].hash & mask_;
+        if (((i - home) & mask_) >= ((i - hole) & mask_)) {
+            slots_[hole] = std::move(slots_[i]);
+            hole = i;
+        }
+    }
+    slots_[hole].order.reset();
+    --size_;
+}
+
+void OrderIndex::clear() {
+    for (auto& slot : slots_) {
+        slot.order.reset();
+    }
+    size_ = 0;
+}
+
+} // namespace aws_wrapper
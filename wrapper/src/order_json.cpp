@@ -0,0 +1,235 @@
+#include "order_json.h"
+#include "order_pool.h"
+#include "logger.h"
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace aws_wrapper {
+
+namespace {
+
+// 문자열 안에서 따로 처리해야 하는 첫 바이트 ('"', '\\', 0x20 미만, 0x80 이상)
+const char* scanString(const char* p, const char* end) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x20);
+    while (end - p >= 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        // 부호 있는 비교라 0x80 이상 (음수) 도 0x20 미만으로 잡힌다
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash)),
+            _mm_cmplt_epi8(bytes, space));
+        int mask = _mm_movemask_epi8(special);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    for (; p < end; ++p) {
+        uint8_t c = static_cast<uint8_t>(*p);
+        if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80) break;
+    }
+    return p;
+}
+
+void skipSpace(const char*& p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+        ++p;
+    }
+}
+
+// 여는 따옴표 다음부터. 이스케이프 / 비 ASCII 가 있으면 false
+bool readString(const char*& p, const char* end, std::string_view& out) {
+    const char* stop = scanString(p, end);
+    if (stop == end || *stop != '"') return false;
+    out = std::string_view(p, stop - p);
+    p = stop + 1;
+    return true;
+}
+
+// JSON 정수 (선행 0 금지). 소수, 지수, 19자리 이상은 false
+bool readInteger(const char*& p, const char* end, int64_t& out) {
+    bool negative = p < end && *p == '-';
+    if (negative) ++p;
+    const char* digits = p;
+    uint64_t value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + static_cast<uint64_t>(*p - '0');
+        ++p;
+    }
+    size_t count = p - digits;
+    if (count == 0 || count > 18 || (count > 1 && *digits == '0')) return false;
+    if (p < end && (*p == '.' || *p == 'e' || *p == 'E')) return false;
+    out = negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+    return true;
+}
+
+bool readLiteral(const char*& p, const char* end, std::string_view literal) {
+    if (static_cast<size_t>(end - p) < literal.size() ||
+        std::string_view(p, literal.size()) != literal) {
+        return false;
+    }
+    p += literal.size();
+    return true;
+}
+
+bool readBool(const char*& p, const char* end, bool& out) {
+    if (p < end && *p == 't') {
+        out = true;
+        return readLiteral(p, end, "true");
+    }
+    out = false;
+    return readLiteral(p, end, "false");
+}
+
+// 모르는 키의 값: 스칼라만 건너뛴다
+bool skipValue(const char*& p, const char* end) {
+    if (p == end) return false;
+    std::string_view text;
+    int64_t number = 0;
+    bool flag = false;
+    switch (*p) {
+        case '"': return readString(++p, end, text);
+        case 't':
+        case 'f': return readBool(p, end, flag);
+        case 'n': return readLiteral(p, end, "null");
+        default:  return readInteger(p, end, number);
+    }
+}
+
+// nlohmann 경로는 j.value(key, 0) 이라 int 로 읽는다. 그 범위 안의 값만 받는다
+bool inIntRange(int64_t value, int64_t min) {
+    return value >= min && value <= INT_MAX;
+}
+
+struct Fields {
+    std::string_view order_id;
+    std::string_view user_id;
+    std::string_view symbol;
+    std::string_view side = "BUY";
+    std::string_view action = "ADD";
+    bool has_is_buy = false;
+    bool is_buy = true;
+    bool has_timestamp = false;
+    int64_t price = 0;
+    int64_t quantity = 0;
+    int64_t stop_price = 0;
+    int64_t timestamp = 0;
+    int64_t qty_delta = 0;
+    int64_t new_price = 0;
+};
+
+bool readField(const char*& p, const char* end, std::string_view key, Fields& f) {
+    if (p == end) return false;
+    int64_t* number = nullptr;
+    int64_t min = 0;
+    std::string_view* text = nullptr;
+
+    if (key == "order_id") text = &f.order_id;
+    else if (key == "symbol") text = &f.symbol;
+    else if (key == "user_id") text = &f.user_id;
+    else if (key == "action") text = &f.action;
+    else if (key == "side") text = &f.side;
+    else if (key == "price") number = &f.price;
+    else if (key == "quantity") number = &f.quantity;
+    else if (key == "stop_price") number = &f.stop_price;
+    else if (key == "new_price") number = &f.new_price;
+    else if (key == "qty_delta") { number = &f.qty_delta; min = INT_MIN; }
+    else if (key == "timestamp") {
+        f.has_timestamp = true;
+        return readInteger(p, end, f.timestamp);
+    } else if (key == "is_buy") {
+        f.has_is_buy = true;
+        return readBool(p, end, f.is_buy);
+    } else if (key == "conditions") {
+        return false;   // 중첩 객체는 nlohmann 경로
+    } else {
+        return skipValue(p, end);
+    }
+
+    if (text) {
+        return *p == '"' && readString(++p, end, *text);
+    }
+    return readInteger(p, end, *number) && inIntRange(*number, min);
+}
+
+bool parseFields(std::string_view value, Fields& f) {
+    const char* p = value.data();
+    const char* end = p + value.size();
+    skipSpace(p, end);
+    if (p == end || *p++ != '{') return false;
+    skipSpace(p, end);
+    if (p < end && *p == '}') {
+        ++p;
+    } else {
+        while (true) {
+            std::string_view key;
+            if (p == end || *p++ != '"' || !readString(p, end, key)) return false;
+            skipSpace(p, end);
+            if (p == end || *p++ != ':') return false;
+            skipSpace(p, end);
+            if (!readField(p, end, key, f)) return false;
+            skipSpace(p, end);
+            if (p == end) return false;
+            char c = *p++;
+            if (c == '}') break;
+            if (c != ',') return false;
+            skipSpace(p, end);
+        }
+    }
+    skipSpace(p, end);
+    return p == end;
+}
+
+} // namespace
+
+bool decodeOrderJson(std::string_view value, OrderMessage& message) {
+    Fields f;
+    if (!parseFields(value, f)) return false;
+    // 너무 긴 문자열이나 쓸 수 없는 종목도 nlohmann 경로에서 같은 오류로 거부된다
+    if (f.order_id.size() > MAX_ORDER_FIELD_LENGTH ||
+        f.user_id.size() > MAX_ORDER_FIELD_LENGTH ||
+        !isValidSymbol(f.symbol)) {
+        return false;
+    }
+
+    if (f.action == "ADD") {
+        message.action = JournalOp::ADD;
+    } else if (f.action == "CANCEL") {
+        message.action = JournalOp::CANCEL;
+    } else if (f.action == "REPLACE") {
+        message.action = JournalOp::REPLACE;
+        message.qty_delta = f.qty_delta;
+        message.new_price = static_cast<liquibook::book::Price>(f.new_price);
+    } else {
+        return false;   // 오류 메시지는 nlohmann 경로에서
+    }
+
+    auto order = OrderPool::instance().acquire();
+    order->setOrderId(f.order_id);
+    order->setUserId(f.user_id);
+    order->setSymbol(f.symbol);
+    order->setIsBuy(f.has_is_buy ? f.is_buy : (f.side == "BUY" || f.side == "buy"));
+    order->setPrice(static_cast<liquibook::book::Price>(f.price));
+    order->setOrderQty(static_cast<liquibook::book::Quantity>(f.quantity));
+    order->setStopPrice(static_cast<liquibook::book::Price>(f.stop_price));
+    order->setTimestamp(f.has_timestamp ? f.timestamp :
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+
+    Logger::debug("Order parsed:", order->order_id(), order->symbol(),
+                  order->is_buy() ? "BUY" : "SELL", order->price(), order->order_qty());
+
+    message.order = std::move(order);
+    return true;
+}
+
+} // namespace aws_wrapper
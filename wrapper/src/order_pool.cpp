@@ -0,0 +1,220 @@
+#include "order_pool.h"
+#include <algorithm>
+#include <mutex>
+#include <new>
+
+namespace aws_wrapper {
+
+struct OrderPool::Depot {
+    explicit Depot(size_t max) : max_free(max) {}
+    ~Depot() {
+        for (Order* order : orders) {
+            delete order;
+        }
+        for (void* block : blocks) {
+            ::operator delete(block);
+        }
+    }
+
+    const size_t max_free;
+    std::mutex mutex;
+    std::vector<Order*> orders;
+    std::vector<void*> blocks;
+};
+
+namespace {
+
+void destroy(Order* order) { delete order; }
+void destroy(void* block) { ::operator delete(block); }
+
+// local 이 비었으면 공유 목록에서 TRANSFER 개를 한 번에 가져와 하나를 꺼낸다
+template <typename T>
+bool take(std::vector<T>& local, std::vector<T>& shared, std::mutex& mutex, T& item) {
+    if (local.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t count = std::min(shared.size(), OrderPool::TRANSFER);
+        local.insert(local.end(), shared.end() - count, shared.end());
+        shared.resize(shared.size() - count);
+    }
+    if (local.empty()) return false;
+    item = local.back();
+    local.pop_back();
+    return true;
+}
+
+// local 끝의 count 개를 공유 목록으로 돌려준다 (max_free 를 넘는 만큼은 해제)
+template <typename T>
+void spill(std::vector<T>& local, size_t count, std::vector<T>& shared,
+           std::mutex& mutex, size_t max_free) {
+    auto first = local.end() - count;
+    size_t kept = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t room = max_free > shared.size() ? max_free - shared.size() : 0;
+        kept = std::min(count, room);
+        shared.insert(shared.end(), first, first + kept);
+    }
+    for (auto it = first + kept; it != local.end(); ++it) {
+        destroy(*it);
+    }
+    local.erase(first, local.end());
+}
+
+// local 에 넣고, 2 * TRANSFER 개를 넘으면 TRANSFER 개를 공유 목록으로 돌려준다
+template <typename T>
+void put(std::vector<T>& local, std::vector<T>& shared, std::mutex& mutex,
+         size_t max_free, T item) {
+    local.push_back(item);
+    if (local.size() > 2 * OrderPool::TRANSFER) {
+        spill(local, OrderPool::TRANSFER, shared, mutex, max_free);
+    }
+}
+
+} // namespace
+
+// 한 번에 한 풀에 묶인다. 다른 풀을 쓰면 가진 것을 원래 풀에 돌려주고 옮겨 간다
+struct OrderPool::ThreadCache {
+    explicit ThreadCache(bool* gone) : gone(gone) {
+        orders.reserve(2 * TRANSFER + 1);
+        blocks.reserve(2 * TRANSFER + 1);
+    }
+    ~ThreadCache() {
+        bind(nullptr);
+        *gone = true;
+    }
+
+    void bind(const std::shared_ptr<Depot>& target) {
+        if (depot == target) return;
+        if (depot) {
+            spill(orders, orders.size(), depot->orders, depot->mutex, depot->max_free);
+            spill(blocks, blocks.size(), depot->blocks, depot->mutex, depot->max_free);
+        }
+        depot = target;
+    }
+
+    std::shared_ptr<Depot> depot;
+    std::vector<Order*> orders;
+    std::vector<void*> blocks;
+    bool* gone;
+};
+
+OrderPool& OrderPool::instance() {
+    static OrderPool* pool = new OrderPool();
+    return *pool;
+}
+
+OrderPool::OrderPool(size_t max_free)
+    : depot_(std::make_shared<Depot>(max_free)) {
+}
+
+OrderPool::~OrderPool() {
+    // 이 스레드의 캐시는 바로 돌려주고, 다른 스레드의 캐시는 그 스레드가
+    // 끝날 때 depot 으로 돌아간다
+    if (ThreadCache* cache = threadCache()) {
+        cache->bind(nullptr);
+    }
+}
+
+OrderPool::ThreadCache* OrderPool::threadCache() const {
+    // 캐시가 소멸된 뒤 (스레드 종료 중) 돌아오는 주문은 공유 목록으로 보낸다
+    static thread_local bool gone = false;
+    if (gone) return nullptr;
+    static thread_local ThreadCache cache(&gone);
+    cache.bind(depot_);
+    return &cache;
+}
+
+OrderPtr OrderPool::acquire() {
+    Order* order = nullptr;
+    Depot& depot = *depot_;
+    if (ThreadCache* cache = threadCache()) {
+        take(cache->orders, depot.orders, depot.mutex, order);
+    } else {
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        if (!depot.orders.empty()) {
+            order = depot.orders.back();
+            depot.orders.pop_back();
+        }
+    }
+    if (order) {
+        reused_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        order = new Order();
+        allocated_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // 제어 블록 할당이 실패하면 shared_ptr 생성자가 deleter 로 주문을 돌려준다
+    return OrderPtr(order, Recycler{this}, BlockAllocator<Order>(this));
+}
+
+void OrderPool::reserve(size_t count) {
+    Depot& depot = *depot_;
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    depot.orders.reserve(count);
+    depot.blocks.reserve(count);
+    while (depot.orders.size() < count) {
+        depot.orders.push_back(new Order());
+        allocated_.fetch_add(1, std::memory_order_relaxed);
+    }
+    while (depot.blocks.size() < count) {
+        depot.blocks.push_back(::operator new(BLOCK_SIZE));
+    }
+}
+
+size_t OrderPool::freeCount() const {
+    size_t count = 0;
+    if (ThreadCache* cache = threadCache()) {
+        count = cache->orders.size();
+    }
+    std::lock_guard<std::mutex> lock(depot_->mutex);
+    return count + depot_->orders.size();
+}
+
+void OrderPool::release(Order* order) {
+    order->reset();
+    Depot& depot = *depot_;
+    if (ThreadCache* cache = threadCache()) {
+        put(cache->orders, depot.orders, depot.mutex, depot.max_free, order);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        if (depot.orders.size() < depot.max_free) {
+            depot.orders.push_back(order);
+            return;
+        }
+    }
+    delete order;
+}
+
+void* OrderPool::allocateBlock() {
+    void* block = nullptr;
+    Depot& depot = *depot_;
+    if (ThreadCache* cache = threadCache()) {
+        take(cache->blocks, depot.blocks, depot.mutex, block);
+    } else {
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        if (!depot.blocks.empty()) {
+            block = depot.blocks.back();
+            depot.blocks.pop_back();
+        }
+    }
+    return block ? block : ::operator new(BLOCK_SIZE);
+}
+
+void OrderPool::releaseBlock(void* block) {
+    Depot& depot = *depot_;
+    if (ThreadCache* cache = threadCache()) {
+        put(cache->blocks, depot.blocks, depot.mutex, depot.max_free, block);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        if (depot.blocks.size() < depot.max_free) {
+            depot.blocks.push_back(block);
+            return;
+        }
+    }
+    ::operator delete(block);
+}
+
+} // namespace aws_wrapper
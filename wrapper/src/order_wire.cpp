@@ -0,0 +1,171 @@
+#include "order_wire.h"
+#include "binary_io.h"
+#include "order_json.h"
+#include "order_pool.h"
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string_view>
+
+namespace aws_wrapper {
+
+// binary_io 는 호스트 바이트 순서로 쓰므로 wire 포맷은 little-endian 호스트를 전제한다
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "order wire format assumes a little-endian host");
+
+using binary_io::get;
+using binary_io::put;
+
+namespace {
+
+int64_t nowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool validAction(uint8_t action) {
+    return action >= static_cast<uint8_t>(JournalOp::ADD) &&
+           action <= static_cast<uint8_t>(JournalOp::REPLACE);
+}
+
+OrderMessage decodeBinary(std::string_view value) {
+    const char* p = value.data();
+    const char* end = p + value.size();
+    uint8_t content_type = 0, version = 0, action = 0, flags = 0;
+    uint8_t order_id_len = 0, user_id_len = 0, symbol_len = 0, reserved = 0;
+    uint64_t price = 0, quantity = 0, stop_price = 0, new_price = 0;
+    int64_t timestamp = 0, qty_delta = 0;
+    if (!get(p, end, content_type) || !get(p, end, version)) {
+        throw std::runtime_error("order message truncated");
+    }
+    if (version != WIRE_VERSION) {
+        throw std::runtime_error("unsupported order message version " +
+                                 std::to_string(version));
+    }
+    bool ok = get(p, end, action) &&
+              get(p, end, flags) &&
+              get(p, end, order_id_len) &&
+              get(p, end, user_id_len) &&
+              get(p, end, symbol_len) &&
+              get(p, end, reserved) &&
+              get(p, end, price) &&
+              get(p, end, quantity) &&
+              get(p, end, stop_price) &&
+              get(p, end, timestamp) &&
+              get(p, end, qty_delta) &&
+              get(p, end, new_price);
+    if (!ok || end - p != order_id_len + user_id_len + symbol_len) {
+        throw std::runtime_error("order message size mismatch");
+    }
+    if (!validAction(action)) {
+        throw std::runtime_error("unknown order action " + std::to_string(action));
+    }
+    if (!isValidSymbol(std::string_view(p + order_id_len + user_id_len, symbol_len))) {
+        throw std::runtime_error("symbol must be [A-Za-z0-9._-] not starting with '.'");
+    }
+
+    OrderMessage message;
+    message.action = static_cast<JournalOp>(action);
+    message.qty_delta = qty_delta;
+    message.new_price = new_price;
+
+    auto order = OrderPool::instance().acquire();
+    order->setOrderId(std::string_view(p, order_id_len));
+    p += order_id_len;
+    order->setUserId(std::string_view(p, user_id_len));
+    p += user_id_len;
+    order->setSymbol(std::string_view(p, symbol_len));
+    order->setIsBuy((flags & WIRE_FLAG_BUY) != 0);
+    liquibook::book::OrderConditions conditions = 0;
+    if (flags & WIRE_FLAG_ALL_OR_NONE) {
+        conditions |= liquibook::book::oc_all_or_none;
+    }
+    if (flags & WIRE_FLAG_IMMEDIATE_OR_CANCEL) {
+        conditions |= liquibook::book::oc_immediate_or_cancel;
+    }
+    order->setConditions(conditions);
+    order->setPrice(price);
+    order->setOrderQty(quantity);
+    order->setStopPrice(stop_price);
+    order->setTimestamp(timestamp != 0 ? timestamp : nowMillis());
+    message.order = std::move(order);
+    return message;
+}
+
+OrderMessage decodeJson(std::string_view value) {
+    OrderMessage message;
+    if (decodeOrderJson(value, message)) {
+        return message;
+    }
+
+    // 빠른 경로가 받지 않는 모양은 범용 파서로
+    auto j = nlohmann::json::parse(value.begin(), value.end());
+    message.order = Order::fromJson(j);
+
+    std::string action = j.value("action", "ADD");
+    if (action == "ADD") {
+        message.action = JournalOp::ADD;
+    } else if (action == "CANCEL") {
+        message.action = JournalOp::CANCEL;
+    } else if (action == "REPLACE") {
+        message.action = JournalOp::REPLACE;
+        message.qty_delta = j.value("qty_delta", 0);
+        message.new_price = j.value("new_price", 0);
+    } else {
+        throw std::runtime_error("unknown order action " + action);
+    }
+    return message;
+}
+
+void checkLength(const std::string& field, const char* name) {
+    if (field.size() > MAX_ORDER_FIELD_LENGTH) {
+        throw std::runtime_error(std::string(name) + " longer than 255 bytes");
+    }
+}
+
+} // namespace
+
+OrderMessage decodeOrderMessage(std::string_view value) {
+    if (!value.empty() && static_cast<uint8_t>(value[0]) == WIRE_BINARY) {
+        return decodeBinary(value);
+    }
+    return decodeJson(value);
+}
+
+std::string encodeOrderMessage(const OrderMessage& message) {
+    const Order& order = *message.order;
+    checkLength(order.order_id(), "order_id");
+    checkLength(order.user_id(), "user_id");
+    if (!isValidSymbol(order.symbol())) {
+        throw std::runtime_error("symbol must be [A-Za-z0-9._-] not starting with '.'");
+    }
+
+    uint8_t flags = 0;
+    if (order.is_buy()) flags |= WIRE_FLAG_BUY;
+    if (order.all_or_none()) flags |= WIRE_FLAG_ALL_OR_NONE;
+    if (order.immediate_or_cancel()) flags |= WIRE_FLAG_IMMEDIATE_OR_CANCEL;
+
+    std::string out;
+    out.reserve(WIRE_HEADER_SIZE + order.order_id().size() +
+                order.user_id().size() + order.symbol().size());
+    put<uint8_t>(out, WIRE_BINARY);
+    put<uint8_t>(out, WIRE_VERSION);
+    put<uint8_t>(out, static_cast<uint8_t>(message.action));
+    put<uint8_t>(out, flags);
+    put<uint8_t>(out, static_cast<uint8_t>(order.order_id().size()));
+    put<uint8_t>(out, static_cast<uint8_t>(order.user_id().size()));
+    put<uint8_t>(out, static_cast<uint8_t>(order.symbol().size()));
+    put<uint8_t>(out, 0);
+    put<uint64_t>(out, order.price());
+    put<uint64_t>(out, order.order_qty());
+    put<uint64_t>(out, order.stop_price());
+    put<int64_t>(out, order.timestamp());
+    put<int64_t>(out, message.qty_delta);
+    put<uint64_t>(out, message.new_price);
+    out.append(order.order_id());
+    out.append(order.user_id());
+    out.append(order.symbol());
+    return out;
+}
+
+} // namespace aws_wrapper
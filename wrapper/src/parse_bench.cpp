@@ -0,0 +1,145 @@
+// 주문 메시지 파싱 처리량 마이크로벤치마크
+// 같은 메시지 묶음을 세 가지 방법으로 디코딩한다.
+//   nlohmann: json::parse + Order::fromJson + action 조회 (이전 consumer 콜백)
+//   fast:     decodeOrderJson (order_json.h, SIMD 빠른 경로)
+//   binary:   같은 메시지를 바이너리로 인코딩해 decodeOrderMessage
+//
+// 사용법: parse_bench [corpus.jsonl] [passes=5]
+//   corpus 는 한 줄에 메시지 하나 (kafka-console-consumer 출력 그대로).
+//   없으면 Lambda 주문 라우터와 같은 모양의 메시지 100000개를 만들어 쓴다.
+
+#include "order_json.h"
+#include "order_wire.h"
+#include "logger.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aws_wrapper;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<std::string> readCorpus(const char* path) {
+    std::vector<std::string> messages;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty()) {
+            messages.push_back(line);
+        }
+    }
+    return messages;
+}
+
+// lambda/AWSSupernoba-order-router 가 보내는 모양 (+ 취소/정정)
+std::vector<std::string> makeCorpus(size_t count) {
+    std::mt19937_64 rng(42);
+    std::vector<std::string> messages;
+    messages.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        char id[64];
+        std::snprintf(id, sizeof(id), "%08llx-%04llx-4%03llx-a%03llx-%012llx",
+                      static_cast<unsigned long long>(rng() & 0xffffffff),
+                      static_cast<unsigned long long>(rng() & 0xffff),
+                      static_cast<unsigned long long>(rng() & 0xfff),
+                      static_cast<unsigned long long>(rng() & 0xfff),
+                      static_cast<unsigned long long>(rng() & 0xffffffffffffULL));
+        nlohmann::json j;
+        uint64_t kind = rng() % 10;
+        j["action"] = kind < 8 ? "ADD" : kind < 9 ? "CANCEL" : "REPLACE";
+        j["order_id"] = id;
+        j["user_id"] = "user-" + std::to_string(rng() % 100000);
+        j["symbol"] = "SYM" + std::to_string(100000 + rng() % 64);
+        j["is_buy"] = (rng() & 1) != 0;
+        j["price"] = 70000 + rng() % 5000;
+        j["quantity"] = 1 + rng() % 1000;
+        j["order_type"] = "LIMIT";
+        j["timestamp"] = 1700000000000LL + static_cast<int64_t>(i);
+        if (kind == 9) {
+            j["qty_delta"] = static_cast<int>(rng() % 21) - 10;
+            j["new_price"] = 70000 + rng() % 5000;
+        }
+        messages.push_back(j.dump());
+    }
+    return messages;
+}
+
+// 결과를 버리지 않도록 모아 두는 값
+uint64_t g_sink = 0;
+
+template <typename Decode>
+void run(const char* name, const std::vector<std::string>& messages,
+         size_t bytes, int passes, Decode&& decode) {
+    double best = 0;
+    for (int pass = 0; pass < passes; ++pass) {
+        auto start = Clock::now();
+        for (const auto& message : messages) {
+            g_sink += decode(message);
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (pass == 0 || seconds < best) best = seconds;
+    }
+    std::printf("%-10s %10.1f %12.0f %10.1f\n", name,
+                best * 1e9 / messages.size(), messages.size() / best,
+                bytes / best / (1024 * 1024));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Logger::setLevel(LogLevel::ERROR);
+    std::vector<std::string> messages = argc > 1 ? readCorpus(argv[1]) : makeCorpus(100000);
+    const int passes = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (messages.empty() || passes <= 0) {
+        std::fprintf(stderr, "usage: %s [corpus.jsonl] [passes]\n", argv[0]);
+        return 2;
+    }
+
+    // 빠른 경로가 받지 않는 메시지 수와 바이너리 인코딩 (잘못된 메시지는 빼고 센다)
+    size_t bytes = 0, fallback = 0;
+    std::vector<std::string> binary;
+    binary.reserve(messages.size());
+    for (const auto& message : messages) {
+        bytes += message.size();
+        OrderMessage decoded;
+        if (!decodeOrderJson(message, decoded)) {
+            ++fallback;
+        }
+        try {
+            binary.push_back(encodeOrderMessage(decodeOrderMessage(message)));
+        } catch (const std::exception&) {
+        }
+    }
+    size_t binary_bytes = 0;
+    for (const auto& message : binary) binary_bytes += message.size();
+
+    std::printf("messages %zu, %.1f bytes/msg, fast path fallback %zu\n",
+                messages.size(), static_cast<double>(bytes) / messages.size(), fallback);
+    std::printf("%-10s %10s %12s %10s\n", "", "ns/msg", "msgs/s", "MB/s");
+
+    run("nlohmann", messages, bytes, passes, [](const std::string& message) {
+        try {
+            auto j = nlohmann::json::parse(message);
+            auto order = Order::fromJson(j);
+            return order->order_qty() + j.value("action", "ADD").size();
+        } catch (const std::exception&) {
+            return size_t{0};
+        }
+    });
+    run("fast", messages, bytes, passes, [](const std::string& message) {
+        OrderMessage decoded;
+        return decodeOrderJson(message, decoded) ? decoded.order->order_qty() : 0;
+    });
+    run("binary", binary, binary_bytes, passes, [](const std::string& message) {
+        return decodeOrderMessage(message).order->order_qty();
+    });
+
+    return g_sink == 0 ? 1 : 0;
+}
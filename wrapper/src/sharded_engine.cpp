@@ -0,0 +1,370 @@
+#include "sharded_engine.h"
+#include "snapshot_file.h"
+#include "logger.h"
+#include <algorithm>
+#include <functional>
+
+namespace aws_wrapper {
+
+namespace {
+
+std::unique_ptr<RedisClient> connectDepthCache(const std::string& host, int port) {
+    if (host.empty()) return nullptr;
+    auto client = std::make_unique<RedisClient>(host, port);
+    if (!client->connect()) {
+        Logger::warn("Redis (depth) connection failed for shard - continuing without depth cache");
+        return nullptr;
+    }
+    return client;
+}
+
+} // namespace
+
+ShardedEngine::Shard::Shard(IProducer* producer,
+                            const std::string& depth_cache_host,
+                            int depth_cache_port,
+                            size_t book_capacity)
+    : depth_cache(connectDepthCache(depth_cache_host, depth_cache_port)),
+      handler(producer, depth_cache.get()),
+      engine(&handler, book_capacity) {
+}
+
+ShardedEngine::ShardedEngine(size_t shard_count,
+                             IProducer* producer,
+                             const std::string& depth_cache_host,
+                             int depth_cache_port,
+                             size_t queue_limit,
+                             size_t book_capacity)
+    : queue_limit_(std::max<size_t>(queue_limit, 1)) {
+    shard_count = std::max<size_t>(shard_count, 1);
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<Shard>(
+            producer, depth_cache_host, depth_cache_port, book_capacity));
+    }
+    Logger::info("ShardedEngine initialized, shards:", shard_count);
+}
+
+ShardedEngine::~ShardedEngine() {
+    stop();
+}
+
+size_t ShardedEngine::shardOf(const std::string& symbol) const {
+    return std::hash<std::string>{}(symbol) % shards_.size();
+}
+
+void ShardedEngine::start() {
+    if (running_) return;
+    for (auto& shard : shards_) {
+        shard->stopping = false;
+        Shard* target = shard.get();
+        shard->worker = std::thread([this, target] { run(*target); });
+    }
+    running_ = true;
+}
+
+void ShardedEngine::stop() {
+    if (!running_) return;
+    for (auto& shard : shards_) {
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->stopping = true;
+        }
+        shard->ready.notify_one();
+    }
+    for (auto& shard : shards_) {
+        shard->worker.join();
+    }
+    running_ = false;
+}
+
+void ShardedEngine::drain() {
+    for (auto& shard : shards_) {
+        std::unique_lock<std::mutex> lock(shard->mutex);
+        shard->drained.wait(lock, [&shard] {
+            return shard->completed == shard->submitted;
+        });
+    }
+}
+
+void ShardedEngine::run(Shard& shard) {
+    std::vector<Command> batch;
+    std::vector<EngineCore::Command> orders;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            shard.ready.wait(lock, [&shard] {
+                return !shard.pending.empty() || shard.stopping;
+            });
+            if (shard.pending.empty()) {
+                return;  // 정지 요청, 남은 명령 없음
+            }
+            // 쌓인 명령을 한 번에 가져가 락 밖에서 처리한다
+            batch.swap(shard.pending);
+        }
+        shard.space.notify_all();
+
+        // 배리어 사이의 명령을 묶어 종목별로 한 번에 적용한다
+        // (배리어보다 먼저 들어온 명령은 배리어가 끝나기 전에 모두 적용된다)
+        for (size_t begin = 0; begin < batch.size();) {
+            size_t end = begin;
+            orders.clear();
+            while (end < batch.size() && !batch[end].barrier) {
+                orders.push_back(std::move(static_cast<EngineCore::Command&>(batch[end])));
+                ++end;
+            }
+            try {
+                if (!orders.empty()) {
+                    shard.engine.applyBatch(orders);
+                }
+            } catch (const std::exception& e) {
+                Logger::error("Error processing command:", e.what());
+            }
+            try {
+                if (end < batch.size() && --batch[end].barrier->remaining == 0) {
+                    batch[end].barrier->done();
+                }
+            } catch (const std::exception& e) {
+                Logger::error("Error processing command:", e.what());
+            }
+            begin = end + 1;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.completed += batch.size();
+        }
+        shard.drained.notify_all();
+        batch.clear();
+    }
+}
+
+void ShardedEngine::apply(EngineCore& engine, Command& command) {
+    switch (command.op) {
+        case JournalOp::ADD:
+            engine.addOrder(std::move(command.order), command.source);
+            break;
+        case JournalOp::CANCEL:
+            engine.cancelOrder(command.symbol, command.order_id, command.source);
+            break;
+        case JournalOp::REPLACE:
+            engine.replaceOrder(command.symbol, command.order_id,
+                                command.qty_delta, command.new_price, command.source);
+            break;
+        case JournalOp::OFFSET:
+            break;
+    }
+}
+
+void ShardedEngine::submit(const std::string& symbol, Command&& command) {
+    submit(*shards_[shardOf(symbol)], std::move(command));
+}
+
+void ShardedEngine::submit(Shard& shard, Command&& command) {
+    if (!running_) {
+        // 워커가 없으면 호출한 스레드에서 바로 처리
+        apply(shard.engine, command);
+        return;
+    }
+
+    bool wake = false;
+    {
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        shard.space.wait(lock, [this, &shard] {
+            return shard.pending.size() < queue_limit_;
+        });
+        // 큐가 비어 있을 때만 워커가 잠들어 있을 수 있다
+        wake = shard.pending.empty();
+        shard.pending.push_back(std::move(command));
+        ++shard.submitted;
+    }
+    if (wake) {
+        shard.ready.notify_one();
+    }
+}
+
+void ShardedEngine::submitAdd(OrderPtr order, SourcePosition source) {
+    Command command;
+    command.op = JournalOp::ADD;
+    command.order = std::move(order);
+    command.source = source;
+    const std::string& symbol = command.order->symbol();
+    submit(symbol, std::move(command));
+}
+
+void ShardedEngine::submitCancel(const std::string& symbol,
+                                 const std::string& order_id,
+                                 SourcePosition source) {
+    Command command;
+    command.op = JournalOp::CANCEL;
+    command.symbol = symbol;
+    command.order_id = order_id;
+    command.source = source;
+    submit(symbol, std::move(command));
+}
+
+void ShardedEngine::submitReplace(const std::string& symbol,
+                                  const std::string& order_id,
+                                  int64_t qty_delta,
+                                  liquibook::book::Price new_price,
+                                  SourcePosition source) {
+    Command command;
+    command.op = JournalOp::REPLACE;
+    command.source = source;
+    command.symbol = symbol;
+    command.order_id = order_id;
+    command.qty_delta = qty_delta;
+    command.new_price = new_price;
+    submit(symbol, std::move(command));
+}
+
+void ShardedEngine::submitBarrier(std::function<void()> done) {
+    if (!running_) {
+        done();
+        return;
+    }
+    auto barrier = std::make_shared<Barrier>();
+    barrier->remaining = shards_.size();
+    barrier->done = std::move(done);
+    for (auto& shard : shards_) {
+        Command command;
+        command.barrier = barrier;
+        submit(*shard, std::move(command));
+    }
+}
+
+void ShardedEngine::setJournal(JournalWriter* journal) {
+    if (journal) {
+        uint64_t sequence = 0;
+        for (const auto& shard : shards_) {
+            sequence = std::max(sequence, shard->engine.lastSequence());
+        }
+        journal->advanceTo(sequence);
+    }
+    journal_ = journal;
+    for (auto& shard : shards_) {
+        shard->engine.setJournal(journal);
+    }
+}
+
+size_t ShardedEngine::replayJournal(const std::string& path) {
+    if (!JournalReader(path).isOpen()) {
+        Logger::info("No journal to replay:", path);
+        return 0;
+    }
+
+    // 샤드마다 저널을 처음부터 읽고 자기 종목의 명령만 적용한다
+    std::vector<size_t> applied(shards_.size(), 0);
+    std::vector<std::thread> threads;
+    threads.reserve(shards_.size());
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        threads.emplace_back([this, &path, &applied, i] {
+            JournalReader reader(path);
+            if (!reader.isOpen()) return;
+            applied[i] = shards_[i]->engine.replayJournal(reader,
+                [this, i](const std::string& symbol) { return shardOf(symbol) == i; });
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    size_t total = 0;
+    for (size_t count : applied) {
+        total += count;
+    }
+    Logger::info("Journal replayed:", path, "commands:", total,
+                 "shards:", shards_.size(), "last sequence:", lastSequence());
+    return total;
+}
+
+uint64_t ShardedEngine::lastSequence() const {
+    if (journal_) {
+        return journal_->lastSequence();
+    }
+    uint64_t sequence = 0;
+    for (const auto& shard : shards_) {
+        sequence = std::max(sequence, shard->engine.lastSequence());
+    }
+    return sequence;
+}
+
+std::string ShardedEngine::snapshotOrderBook(const std::string& symbol) {
+    return engineFor(symbol).snapshotOrderBook(symbol);
+}
+
+bool ShardedEngine::restoreOrderBook(const std::string& symbol,
+                                     const std::string& data) {
+    return engineFor(symbol).restoreOrderBook(symbol, data);
+}
+
+bool ShardedEngine::removeOrderBook(const std::string& symbol) {
+    return engineFor(symbol).removeOrderBook(symbol);
+}
+
+bool ShardedEngine::saveBookSnapshot(const std::string& symbol,
+                                     const std::string& path) {
+    return engineFor(symbol).saveBookSnapshot(symbol, path);
+}
+
+std::string ShardedEngine::loadBookSnapshot(const std::string& path) {
+    auto symbol = snapshotFileSymbol(path);
+    if (symbol.empty()) {
+        Logger::error("Failed to read snapshot file symbol:", path);
+        return "";
+    }
+    return engineFor(symbol).loadBookSnapshot(path);
+}
+
+size_t ShardedEngine::getSymbolCount() const {
+    size_t count = 0;
+    for (const auto& shard : shards_) {
+        count += shard->engine.getSymbolCount();
+    }
+    return count;
+}
+
+size_t ShardedEngine::getActiveOrderCount() const {
+    size_t count = 0;
+    for (const auto& shard : shards_) {
+        count += shard->engine.getActiveOrderCount();
+    }
+    return count;
+}
+
+std::vector<std::string> ShardedEngine::getAllSymbols() const {
+    std::vector<std::string> symbols;
+    for (const auto& shard : shards_) {
+        auto shard_symbols = shard->engine.getAllSymbols();
+        symbols.insert(symbols.end(), shard_symbols.begin(), shard_symbols.end());
+    }
+    std::sort(symbols.begin(), symbols.end());
+    return symbols;
+}
+
+uint64_t ShardedEngine::getTotalOrdersProcessed() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard->engine.getTotalOrdersProcessed();
+    }
+    return total;
+}
+
+uint64_t ShardedEngine::getTotalTradesExecuted() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard->engine.getTotalTradesExecuted();
+    }
+    return total;
+}
+
+size_t ShardedEngine::getQueuedCommands() const {
+    size_t queued = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        queued += shard->submitted - shard->completed;
+    }
+    return queued;
+}
+
+} // namespace aws_wrapper
@@ -0,0 +1,153 @@
+#include "snapshot_file.h"
+#include "binary_io.h"
+#include "order_pool.h"
+#include "logger.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace aws_wrapper {
+
+using namespace binary_io;
+
+bool encodeSnapshotOrder(const Order& order, std::string& out) {
+    if (!putString(out, order.order_id()) || !putString(out, order.user_id())) {
+        return false;
+    }
+    put<uint8_t>(out, order.is_buy() ? 1 : 0);
+    put<uint32_t>(out, order.conditions());
+    put<uint64_t>(out, order.price());
+    put<uint64_t>(out, order.order_qty());
+    put<uint64_t>(out, order.filled_qty());
+    put<uint64_t>(out, order.filled_cost());
+    put<uint64_t>(out, order.stop_price());
+    put<int64_t>(out, order.timestamp());
+    return true;
+}
+
+OrderPtr decodeSnapshotOrder(const char*& p, const char* end,
+                             const std::string& symbol) {
+    std::string order_id, user_id;
+    uint8_t is_buy = 0;
+    uint32_t conditions = 0;
+    uint64_t price = 0, order_qty = 0, filled_qty = 0, filled_cost = 0;
+    uint64_t stop_price = 0;
+    int64_t timestamp = 0;
+    bool ok = getString(p, end, order_id) &&
+              getString(p, end, user_id) &&
+              get(p, end, is_buy) &&
+              get(p, end, conditions) &&
+              get(p, end, price) &&
+              get(p, end, order_qty) &&
+              get(p, end, filled_qty) &&
+              get(p, end, filled_cost) &&
+              get(p, end, stop_price) &&
+              get(p, end, timestamp);
+    if (!ok) return nullptr;
+
+    auto order = OrderPool::instance().acquire();
+    order->setOrderId(order_id);
+    order->setUserId(user_id);
+    order->setSymbol(symbol);
+    order->setIsBuy(is_buy != 0);
+    order->setConditions(conditions);
+    order->setPrice(price);
+    order->setOrderQty(order_qty);
+    order->setFilled(filled_qty, filled_cost);
+    order->setStopPrice(stop_price);
+    order->setTimestamp(timestamp);
+    return order;
+}
+
+bool writeSnapshotFile(const std::string& path, SnapshotFileHeader& header,
+                       const std::vector<uint64_t>& image,
+                       const std::string& table) {
+    const char* image_bytes = reinterpret_cast<const char*>(image.data());
+    std::memcpy(header.magic, SNAPSHOT_FILE_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_FILE_VERSION;
+    header.reserved = 0;
+    header.image_size = image.size() * sizeof(uint64_t);
+    header.table_size = table.size();
+    header.crc = crc32(table.data(), table.size(),
+                       crc32(image_bytes, header.image_size));
+
+    // 쓰다 만 파일이 남지 않도록 임시 파일에 쓰고 rename
+    const std::string tmp = path + ".tmp";
+    std::FILE* file = std::fopen(tmp.c_str(), "wb");
+    if (!file) {
+        Logger::error("Failed to open snapshot file:", tmp);
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(image_bytes, 1, header.image_size, file) == header.image_size &&
+              std::fwrite(table.data(), 1, table.size(), file) == table.size() &&
+              std::fflush(file) == 0 &&
+              ::fdatasync(::fileno(file)) == 0;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        Logger::error("Failed to write snapshot file:", path);
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string snapshotFilePath(const std::string& dir, const std::string& symbol) {
+    if (!isValidSymbol(symbol)) return "";
+    return (std::filesystem::path(dir) / (symbol + ".snap")).string();
+}
+
+bool isSnapshotFile(const std::string& path) {
+    char magic[sizeof(SNAPSHOT_FILE_MAGIC)] = {};
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    bool ok = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic);
+    std::fclose(file);
+    return ok && std::memcmp(magic, SNAPSHOT_FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+std::string snapshotFileSymbol(const std::string& path) {
+    std::string symbol;
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return symbol;
+    SnapshotFileHeader header;
+    uint16_t size = 0;
+    if (std::fread(&header, sizeof(header), 1, file) == 1 &&
+        std::memcmp(header.magic, SNAPSHOT_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+        std::fseek(file, static_cast<long>(header.image_size), SEEK_CUR) == 0 &&
+        std::fread(&size, sizeof(size), 1, file) == 1) {
+        symbol.resize(size);
+        if (std::fread(&symbol[0], 1, size, file) != size) {
+            symbol.clear();
+        }
+    }
+    std::fclose(file);
+    return symbol;
+}
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size),
+                            PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            data_ = data;
+            size_ = static_cast<size_t>(st.st_size);
+            // 복원은 처음부터 끝까지 한 번 읽는다
+            ::madvise(data_, size_, MADV_SEQUENTIAL);
+        }
+    }
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) ::munmap(data_, size_);
+}
+
+} // namespace aws_wrapper
@@ -0,0 +1,122 @@
+#include "source_offsets.h"
+#include "logger.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace aws_wrapper {
+
+void SourceOffsets::apply(const JournalRecord& record) {
+    sequence_ = std::max(sequence_, record.sequence);
+    const SourcePosition& source = record.source;
+    if (source.partition < 0 || source.offset < 0) return;
+
+    Partition& partition = partitions_[source.partition];
+    if (record.op == JournalOp::OFFSET) {
+        if (source.offset <= partition.handled) return;
+        partition.handled = source.offset;
+        partition.ahead.erase(partition.ahead.begin(),
+                              partition.ahead.lower_bound(partition.handled));
+    } else if (source.offset >= partition.handled) {
+        partition.ahead.insert(source.offset);
+    }
+}
+
+size_t SourceOffsets::applyJournal(const std::string& path) {
+    JournalReader reader(path);
+    if (!reader.isOpen()) return 0;
+    size_t count = 0;
+    JournalRecord record;
+    while (reader.next(record)) {
+        apply(record);
+        ++count;
+    }
+    return count;
+}
+
+std::map<int32_t, int64_t> SourceOffsets::resumeOffsets() const {
+    std::map<int32_t, int64_t> offsets;
+    for (const auto& [id, partition] : partitions_) {
+        if (partition.handled >= 0) {
+            offsets[id] = partition.handled;
+        }
+    }
+    return offsets;
+}
+
+bool SourceOffsets::applied(int32_t partition, int64_t offset) const {
+    auto it = partitions_.find(partition);
+    if (it == partitions_.end()) return false;
+    return offset < it->second.handled || it->second.ahead.count(offset) > 0;
+}
+
+std::string SourceOffsets::toJson() const {
+    nlohmann::json partitions = nlohmann::json::array();
+    for (const auto& [id, partition] : partitions_) {
+        partitions.push_back({
+            {"partition", id},
+            {"handled", partition.handled},
+            {"ahead", partition.ahead}
+        });
+    }
+    nlohmann::json json;
+    json["sequence"] = sequence_;
+    json["partitions"] = std::move(partitions);
+    return json.dump();
+}
+
+bool SourceOffsets::fromJson(const std::string& data) {
+    try {
+        auto json = nlohmann::json::parse(data);
+        std::map<int32_t, Partition> partitions;
+        for (const auto& item : json.at("partitions")) {
+            Partition& partition = partitions[item.at("partition").get<int32_t>()];
+            partition.handled = item.at("handled").get<int64_t>();
+            partition.ahead = item.at("ahead").get<std::set<int64_t>>();
+        }
+        partitions_ = std::move(partitions);
+        sequence_ = json.at("sequence").get<uint64_t>();
+        return true;
+    } catch (const std::exception& e) {
+        Logger::error("Failed to parse source offsets:", e.what());
+        return false;
+    }
+}
+
+bool SourceOffsets::save(const std::string& path) const {
+    const std::string data = toJson();
+    const std::string tmp = path + ".tmp";
+    std::FILE* file = std::fopen(tmp.c_str(), "wb");
+    if (!file) {
+        Logger::error("Failed to open source offsets file:", tmp);
+        return false;
+    }
+    bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size() &&
+              std::fflush(file) == 0 &&
+              ::fdatasync(::fileno(file)) == 0;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        Logger::error("Failed to write source offsets file:", path);
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SourceOffsets::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::stringstream data;
+    data << file.rdbuf();
+    return fromJson(data.str());
+}
+
+std::string sourceOffsetsPath(const std::string& snapshot_dir) {
+    return (std::filesystem::path(snapshot_dir) / "source_offsets.json").string();
+}
+
+} // namespace aws_wrapper